@@ -118,558 +118,172 @@ Triggered via the commmand: "auto_mode:mmm" where mmm is the duration in minutes
 */
 #include "auto_generator.h"
 #include "shared.h"
+#include "phase_templates.h"
+#include "power_budget.h"
+#include "steady_rotate.h"
 #include <Arduino.h>
-#include <vector>
-#include <string>
+#include <LittleFS.h>
+#include <stdio.h>
 
 // This file can't access the log_t function in main.cpp directly.
-// We'll use Serial.printf for logging within this module.
-#define AUTO_LOG(format, ...) Serial.printf("%lu ms: [AutoGenerator] " format "\n", millis(), ##__VA_ARGS__)
+// We'll log through Serial from this module. Lines are formatted on the stack and
+// written out whole, because Serial.printf() allocates for lines over 64 bytes.
+#define AUTO_LOG(format, ...) do { \
+        char __autoLogLine[160]; \
+        int __autoLogLen = snprintf(__autoLogLine, sizeof(__autoLogLine), "%lu ms: [AutoGenerator] " format "\n", millis(), ##__VA_ARGS__); \
+        if (__autoLogLen > 0) Serial.write(__autoLogLine, min((size_t)__autoLogLen, sizeof(__autoLogLine) - 1)); \
+    } while (0)
 
 namespace AutoGenerator {
 
-const std::vector<const char*> calm_noise_palettes = {"cloud", "ocean", "forest"};
-const std::vector<const char*> energetic_noise_palettes = {"lava", "party", "rainbow"};
-
-// Helper to create a command string from various parameter types
-std::string format_command(const char* cmd, long val) {
-    char buffer[32];
-    sprintf(buffer, "%s:%ld", cmd, val);
-    return std::string(buffer);
+// Helpers to append a command line with various parameter types
+void push_command(ScriptBuffer& script, const char* cmd, long val) {
+    script.pushf("%s:%ld", cmd, val);
 }
 
-std::string format_command(const char* cmd, int val1, int val2) {
-    char buffer[32];
-    sprintf(buffer, "%s:%d,%d", cmd, val1, val2);
-    return std::string(buffer);
+void push_command(ScriptBuffer& script, const char* cmd, int val1, int val2) {
+    script.pushf("%s:%d,%d", cmd, val1, val2);
 }
 
-std::string format_command(const char* cmd, int val1, int val2, int val3) {
-    char buffer[48];
-    sprintf(buffer, "%s:%d,%d,%d", cmd, val1, val2, val3);
-    return std::string(buffer);
+void push_command(ScriptBuffer& script, const char* cmd, int val1, int val2, int val3) {
+    script.pushf("%s:%d,%d,%d", cmd, val1, val2, val3);
 }
 
-std::string format_command(const char* cmd, int val1, int val2, int val3, int val4, int val5) {
-    char buffer[64];
-    sprintf(buffer, "%s:%d,%d,%d,%d,%d", cmd, val1, val2, val3, val4, val5);
-    return std::string(buffer);
+void push_phase_comment(ScriptBuffer& script, const char* phase_name) {
+    script.pushf("[---------- %s ----------]", phase_name);
 }
 
-std::string format_phase_comment(const char* phase_name) {
-    char buffer[64];
-    sprintf(buffer, "[---------- %s ----------]", phase_name);
-    return std::string(buffer);
+// Lines a script can hold, given both the line limit and the text pool. Sized on a
+// generous average line length so the pool never fills before the line count does.
+int script_line_budget() {
+    const int AVG_COMMAND_BYTES = 20;
+    return min(SCRIPT_MAX_LINES, (int)(SCRIPT_POOL_BYTES / AVG_COMMAND_BYTES));
 }
 
-// Per guidance, the generator now follows a musical structure.
-enum MusicalPhase {
-    INTRODUCTION,
-    VIBE,
-    TENSION,
-    CLIMAX,
-    COOL_DOWN
-};
-
-std::vector<std::string> generateScript(int duration_minutes) {
-    std::vector<std::string> script;
-    if (duration_minutes <= 0) return script;
-
-    randomSeed(millis());
-
-    long total_duration_ms = duration_minutes * 60L * 1000L;
-
-    // --- Musical Structure Durations & Overview ---
-    long intro_duration_ms = 30 * 1000L;
-    long cool_down_duration_ms = 60 * 1000L;
-    long min_full_show_ms = intro_duration_ms + 120 * 1000L + cool_down_duration_ms; // Approx 3.5 mins for one cycle
-
-    // If requested duration is shorter than a full show, scale down phase times.
-    if (total_duration_ms < min_full_show_ms) {
-        float scale_factor = (float)total_duration_ms / (float)min_full_show_ms;
-        if (scale_factor < 0.5) scale_factor = 0.5; // Don't make them too short
-        intro_duration_ms *= scale_factor;
-        cool_down_duration_ms *= scale_factor;
-    }
-
-    long main_body_duration_ms = total_duration_ms - intro_duration_ms - cool_down_duration_ms;
-    if (main_body_duration_ms < 0) main_body_duration_ms = 0;
-
-    const long avg_vibe_ms = (20000 + 30001) / 2; // Keep scenes moving
-    const long avg_tension_ms = (15000 + 25001) / 2;
-    const long avg_climax_ms = (75000 + 90001) / 2; // Longer, multi-part climax
-    const long avg_cycle_ms = avg_vibe_ms + avg_tension_ms + avg_climax_ms;
-    int num_cycles = (avg_cycle_ms > 0) ? (main_body_duration_ms / avg_cycle_ms) : 0;
-
-    long accumulated_duration_ms = 0;
-
-    // --- Dynamic Command Limit based on Available Memory ---
-    // Instead of a fixed limit, we calculate how many commands we can safely store.
-    // This prevents running out of memory on long auto-mode durations.
-    const long HEAP_SAFETY_MARGIN = 50 * 1024; // Reserve 50KB of heap for other operations.
-    const int AVG_COMMAND_MEMORY_COST = 48;   // A generous estimate for a std::string in a vector.
-    const int ABSOLUTE_MAX_COMMANDS = 2000;   // A hard cap to prevent excessively long generation.
-
-    long free_heap = ESP.getFreeHeap();
-    long available_for_script = free_heap - HEAP_SAFETY_MARGIN;
-    int max_commands = 100; // Default fallback
-    if (available_for_script > 0) {
-        max_commands = min(ABSOLUTE_MAX_COMMANDS, (int)(available_for_script / AVG_COMMAND_MEMORY_COST));
-    }
+// Replaces PhaseTemplates::BUILTIN_TEMPLATES when present and valid.
+static const char* const PHASE_TEMPLATES_PATH = "/phases.txt";
+// Room for an override file; the built-in set is about half of this.
+static const size_t PHASE_TEMPLATES_FILE_BYTES = 6144;
+static char __phaseTemplatesFile[PHASE_TEMPLATES_FILE_BYTES];
+static bool __phaseTemplatesFromFile = false;
+
+// PhaseTemplates takes plain function pointers, so the variant's revolution time is
+// reached through an instantiated template.
+template <typename Config>
+static long templateRevTimeMs(int speed) {
+    return calculateRevTimeMs<Config>(speed);
+}
 
-    AUTO_LOG("Generating auto-script for %d minutes (%ld ms)...", duration_minutes, total_duration_ms);
-    AUTO_LOG("Heap: %ldB free. Dynamic max commands set to: %d", free_heap, max_commands);
+static long templateRandom(long low, long highExclusive) {
+    return random(low, highExclusive);
+}
 
-    AUTO_LOG("Composition Overview for %d minutes:", duration_minutes);
-    AUTO_LOG("  - INTRODUCTION: ~%lds", intro_duration_ms / 1000);
-    AUTO_LOG("  - MAIN BODY:    ~%ldm", main_body_duration_ms / 60000);
-    if (num_cycles > 0) {
-        AUTO_LOG("      - %d cycles of:", num_cycles);
-        AUTO_LOG("        - VIBE:    ~%lds", avg_vibe_ms / 1000);
-        AUTO_LOG("        - TENSION: ~%lds", avg_tension_ms / 1000);
-        AUTO_LOG("        - CLIMAX:  ~%lds", avg_climax_ms / 1000);
-    } else if (main_body_duration_ms > 0) {
-        AUTO_LOG("      - Partial cycle");
+void loadPhaseTemplates() {
+    int errorLine = 0;
+    // Switch to the built-in set first: the active set may point into the file buffer
+    // that is about to be overwritten.
+    if (!PhaseTemplates::load(PhaseTemplates::BUILTIN_TEMPLATES, &errorLine)) {
+        AUTO_LOG("Built-in phase templates: error on line %d.", errorLine); // Caught on the first test run
     }
-    AUTO_LOG("  - COOL_DOWN:    ~%lds", cool_down_duration_ms / 1000);
-
-    script.push_back("led_reset"); // Use led_reset to clear effects without touching global brightness or motor.
-    script.push_back("hold:1000");
-    accumulated_duration_ms += 1000;
-
-    // --- 1. INTRODUCTION ---
-    if (intro_duration_ms > 1000) {
-        script.push_back(format_phase_comment("INTRODUCTION"));
-        long intro_remaining_ms = intro_duration_ms;
-        script.push_back("led_reset"); // Reset LED state first.
-        script.push_back(format_command("led_display_brightness", (long)random(30, 51))); // Start dim
-
-        // Per guidance, showcase a full-strip effect with motor off.
-        if (random(100) < 50) { // 50% chance to start with a noise effect
-            script.push_back("motor_speed:0");
-            const char* palette = calm_noise_palettes[random(calm_noise_palettes.size())];
-            char buffer[64];
-            sprintf(buffer, "led_effect:noise,%s,5,30", palette);
-            script.push_back(buffer);
-            script.push_back("hold:7000"); intro_remaining_ms -= 7000;
+    __phaseTemplatesFromFile = false;
+    if (LittleFS.begin(false) && LittleFS.exists(PHASE_TEMPLATES_PATH)) {
+        File file = LittleFS.open(PHASE_TEMPLATES_PATH, "r");
+        size_t len = file ? file.size() : 0;
+        if (!file) {
+            AUTO_LOG("Could not open %s; using built-in phase templates.", PHASE_TEMPLATES_PATH);
+        } else if (len >= sizeof(__phaseTemplatesFile)) {
+            AUTO_LOG("%s is %u bytes (max %u); using built-in phase templates.", PHASE_TEMPLATES_PATH,
+                     (unsigned)len, (unsigned)(sizeof(__phaseTemplatesFile) - 1));
         } else {
-            script.push_back("motor_speed:0");
-            script.push_back("hold:2000"); intro_remaining_ms -= 2000;
-            script.push_back(format_command("led_background", (int)random(256), 5));
+            len = file.read((uint8_t*)__phaseTemplatesFile, len);
+            __phaseTemplatesFile[len] = '\0';
+            if (PhaseTemplates::load(__phaseTemplatesFile, &errorLine)) {
+                __phaseTemplatesFromFile = true;
+            } else {
+                AUTO_LOG("%s: error on line %d; using built-in phase templates.", PHASE_TEMPLATES_PATH, errorLine);
+            }
         }
+        if (file) file.close();
+    }
+    logPhaseTemplates();
+}
 
-        long hold1 = min(5000L, intro_remaining_ms / 2L);
-        if (hold1 > 0) { script.push_back(format_command("hold", hold1)); intro_remaining_ms -= hold1; }
-        script.push_back(format_command("led_tails", (int)random(256), 10, 1));
-        long hold2 = min(5000L, intro_remaining_ms / 2L);
-        if (hold2 > 0) { script.push_back(format_command("hold", hold2)); intro_remaining_ms -= hold2; }
-        script.push_back("motor_speed:500");
-        script.push_back(format_command("led_background", (int)random(256), 15));
-        if (intro_remaining_ms > 1000) script.push_back(format_command("hold", intro_remaining_ms));
-        accumulated_duration_ms += intro_duration_ms;
+void logPhaseTemplates() {
+    AUTO_LOG("Phase templates: %s, %d phases.", __phaseTemplatesFromFile ? PHASE_TEMPLATES_PATH : "built-in",
+             PhaseTemplates::phaseCount());
+    for (int i = 0; i < PhaseTemplates::phaseCount(); i++) {
+        AUTO_LOG("  - %s: %d scenes", PhaseTemplates::phaseName(i), PhaseTemplates::sceneCount(i));
     }
+}
 
-    // --- 2. MAIN BODY (VIBE -> TENSION -> CLIMAX loop) ---
-    MusicalPhase currentPhase = VIBE;
-
-    while (accumulated_duration_ms < (total_duration_ms - cool_down_duration_ms) && script.size() < max_commands - 10) { // Leave room for cooldown and finale
-        long scene_duration_ms = 0;
-        uint8_t base_hue = random(256);
-        uint8_t tail_hue;
-        uint8_t bg_hue;
-
-        // --- Generate a scene based on the current musical phase ---
-        switch (currentPhase) {
-            case VIBE: {
-                script.push_back(format_phase_comment("VIBE"));
-                script.push_back(format_command("led_display_brightness", (long)random(60, 81))); // Vibe brightness
-                scene_duration_ms = random(20000, 30001); // Shorter scenes to keep things moving
-
-                // Colors: Harmonious (Analogous/Monochromatic)
-                if (random(100) < 70) { // 70% Analogous
-                    bg_hue = base_hue;
-                    tail_hue = (base_hue + random(20, 41)) % 256;
-                } else { // 30% Monochromatic
-                    bg_hue = base_hue;
-                    tail_hue = base_hue;
-                }
-
-                // Per guidance, occasionally break up the vibe with a full-strip effect
-                if (random(100) < 15) {
-                    script.push_back(format_command("motor_speed", (long)random(500, 601)));
-                    const char* palette = calm_noise_palettes[random(calm_noise_palettes.size())];
-                    char buffer[64];
-                    sprintf(buffer, "led_effect:noise,%s,8,40", palette);
-                    script.push_back(buffer);
-                } else {
-                    long motor_speed = random(500, 701);
-                    script.push_back(format_command("motor_speed", motor_speed));
-                    script.push_back(format_command("led_background", (int)bg_hue, (int)random(15, 31)));
-                    script.push_back(format_command("led_tails", (int)tail_hue, (int)random(10, 25), (int)random(1, 3)));
-
-                    if (random(100) < 40) { // 40% chance to set a custom cycle time
-                        long est_rev_time = calculate_rev_time_ms(motor_speed);
-                        float multiplier = (float)random(100, 201) / 100.0f; // 1.0x to 2.0x
-                        script.push_back(format_command("led_cycle_time", (long)(est_rev_time * multiplier)));
-                    }
-                }
-                if (random(100) < 50) { // Gentle sine hue effect
-                    uint8_t hue_low = (tail_hue - 20 + 256) % 256;
-                    uint8_t hue_high = (tail_hue + 20) % 256;
-                    script.push_back(format_command("led_sine_hue", (int)hue_low, (int)hue_high));
-                }
-                currentPhase = TENSION; // Transition to next phase
-                break;
-            }
+template <typename Config>
+void generateScript(int duration_minutes, uint32_t rampDurationMs, ScriptBuffer& script, uint32_t seed, bool verbose) {
+    script.clear();
+    if (duration_minutes <= 0) return;
 
-            case TENSION: {
-                script.push_back(format_phase_comment("TENSION"));
-                script.push_back(format_command("led_display_brightness", (long)random(80, 96))); // Tension brightness
-                scene_duration_ms = random(15000, 25001); // Medium length, building scenes
-
-                // Colors: High-contrast (Complementary)
-                bg_hue = base_hue;
-                tail_hue = (base_hue + 128) % 256;
-
-                if (random(100) < 20) { // 20% chance for a marquee effect
-                    script.push_back(format_command("motor_speed", (long)random(600, 801)));
-                    char buffer[64];
-                    // led_effect:marquee,H,LW,DW,S
-                    sprintf(buffer, "led_effect:marquee,%d,%d,%d,%d", tail_hue, (int)random(2,5), (int)random(4,10), (int)random(25, 76));
-                    script.push_back(buffer);
-                } else {
-                    long motor_speed = random(750, 951);
-                    script.push_back(format_command("motor_speed", motor_speed)); // Ramp up speed
-                    script.push_back(format_command("led_background", (int)bg_hue, (int)random(25, 41)));
-                    script.push_back(format_command("led_tails", (int)tail_hue, (int)random(5, 15), (int)random(3, 6)));
-
-                    // Per guidance, cycle time >= motor revolution time
-                    if (random(100) < 75) { // 75% chance to set a custom cycle time
-                        long est_rev_time = calculate_rev_time_ms(motor_speed);
-                        float multiplier = (float)random(100, 151) / 100.0f; // 1.0x to 1.5x
-                        script.push_back(format_command("led_cycle_time", (long)(est_rev_time * multiplier)));
-                    }
-                }
-
-                if (random(100) < 60) { // Pulsing brightness effect, kept within the tension range
-                    script.push_back(format_command("led_sine_pulse", (int)random(50, 71), (int)random(90, 96)));
-                }
-
-                // Per guidance, use motor_reverse to signal the transition to CLIMAX
-                if (random(100) < 75) { // 75% chance to reverse into the climax
-                    script.push_back("motor_reverse");
-                    accumulated_duration_ms += DEFAULT_RAMP_DURATION_MS + 1000;
-                }
-                currentPhase = CLIMAX; // Transition to next phase
-                break;
-            }
+    randomSeed(seed != 0 ? seed : millis());
 
-            case CLIMAX: {
-                script.push_back(format_phase_comment("CLIMAX"));
-                script.push_back("led_display_brightness:100"); // Max brightness
-
-                // A longer, multi-part climax with 2-3 scenes.
-                long climax_total_duration_ms = random(75000, 90001);
-                int num_scenes = random(2, 4); // 2 or 3 scenes
-                long duration_per_scene = climax_total_duration_ms / num_scenes;
-
-                for (int i = 0; i < num_scenes; ++i) {
-                    long current_scene_duration = duration_per_scene;
-                    long remaining_total_time = (total_duration_ms - cool_down_duration_ms) - accumulated_duration_ms;
-                    if (current_scene_duration > remaining_total_time && remaining_total_time > 1000) {
-                        current_scene_duration = remaining_total_time;
-                    }
-                    if (current_scene_duration <= 1000) break;
-
-                    int effect_choice = random(100);
-                    long hold_time = current_scene_duration;
-
-                    // Per guidance, increase use of marquee effect.
-                    if (effect_choice < 40) { // 40% marquee (still or high speed)
-                        uint8_t marquee_hue = random(256);
-                        char buffer[64];
-                        if (random(100) < 40) { // motor still
-                            script.push_back("motor_speed:0");
-                            script.push_back("hold:2000"); // wait for motor to stop
-                            hold_time = max(1000L, hold_time - 2000L);
-                            sprintf(buffer, "led_effect:marquee,%d,%d,%d,%d", marquee_hue, (int)random(2,5), (int)random(4,10), (int)random(75, 121));
-                            script.push_back(buffer);
-
-                            // If hold is long, switch to a different static effect to add variety
-                            if (hold_time > 12000) {
-                                long half_hold = hold_time / 2;
-                                script.push_back(format_command("hold", half_hold));
-                                hold_time -= half_hold;
-
-                                if (random(100) < 50) {
-                                    script.push_back("led_effect:fire");
-                                } else {
-                                    const char* palette = energetic_noise_palettes[random(energetic_noise_palettes.size())];
-                                    char buffer2[64];
-                                    sprintf(buffer2, "led_effect:noise,%s,25,15", palette);
-                                    script.push_back(buffer2);
-                                }
-                            }
-                        } else { // motor high speed
-                            script.push_back(format_command("motor_speed", (long)random(900, 1001)));
-                            sprintf(buffer, "led_effect:marquee,%d,%d,%d,%d", marquee_hue, (int)random(2,5), (int)random(4,10), (int)random(25, 76));
-                            script.push_back(buffer);
-
-                            // Break up the long hold with motor speed changes
-                            int num_changes = random(2, 4); // 2 or 3 changes
-                            if (num_changes > 1) {
-                                long hold_per_change = hold_time / num_changes;
-                                if (hold_per_change > 4000) { // Only if chunks are meaningful
-                                    for (int j = 0; j < num_changes - 1; j++) {
-                                        script.push_back(format_command("hold", hold_per_change));
-                                        script.push_back(format_command("motor_speed", (long)random(850, 1001)));
-                                        hold_time -= hold_per_change;
-                                    }
-                                }
-                            }
-                        }
-
-                    } else if (effect_choice < 75) { // 35% Rainbow + see-saw
-                        script.push_back(format_command("motor_speed", (long)random(900, 1001)));
-                        script.push_back("led_rainbow");
-                        script.push_back(format_command("led_tails", 0, (int)random(10, 20), (int)random(4, 7)));
-
-                        int num_reverses = random(2, 5); // 2 to 4 reverses
-                        long hold_per_reverse = hold_time / (num_reverses + 1);
-
-                        if (hold_per_reverse > 500) {
-                            for(int j=0; j<num_reverses; j++) {
-                                script.push_back(format_command("hold", hold_per_reverse));
-                                script.push_back("led_reverse");
-                                hold_time -= hold_per_reverse;
-                            }
-                        }
-                    } else { // 25% fire/noise or blink
-                        if (random(100) < 50) { // fire/noise
-                            script.push_back("motor_speed:0");
-                            script.push_back("hold:4000");
-                            hold_time = max(1000L, hold_time - 4000L);
-
-                            bool use_fire_first = (random(100) < 50);
-                            if (use_fire_first) script.push_back("led_effect:fire");
-                            else {
-                                const char* palette = energetic_noise_palettes[random(energetic_noise_palettes.size())];
-                                char buffer[64];
-                                sprintf(buffer, "led_effect:noise,%s,25,15", palette);
-                                script.push_back(buffer);
-                            }
-
-                            // If the hold is long, switch to the other effect halfway through
-                            if (hold_time > 12000) {
-                                long half_hold = hold_time / 2;
-                                script.push_back(format_command("hold", half_hold));
-                                hold_time -= half_hold;
-
-                                if (use_fire_first) { // switch to noise
-                                    const char* palette = energetic_noise_palettes[random(energetic_noise_palettes.size())];
-                                    char buffer[64];
-                                    sprintf(buffer, "led_effect:noise,%s,25,15", palette);
-                                    script.push_back(buffer);
-                                } else { // switch to fire
-                                    script.push_back("led_effect:fire");
-                                }
-                            }
-                        } else { // blink
-                            script.push_back(format_command("motor_speed", (long)random(950, 1001)));
-                            uint8_t blink_hue = random(256);
-                            script.push_back(format_command("led_blink", (int)blink_hue, 100, 80, 150, 0 /* loop */));
-
-                            // Break up the long hold with motor speed changes
-                            int num_changes = random(2, 4); // 2 or 3 changes
-                            if (num_changes > 1) {
-                                long hold_per_change = hold_time / num_changes;
-                                if (hold_per_change > 4000) { // Only if chunks are meaningful
-                                    for (int j = 0; j < num_changes - 1; j++) {
-                                        script.push_back(format_command("hold", hold_per_change));
-                                        script.push_back(format_command("motor_speed", (long)random(900, 1001)));
-                                        hold_time -= hold_per_change;
-                                    }
-                                }
-                            }
-                        }
-                    }
-
-                    if (hold_time > 0) {
-                        script.push_back(format_command("hold", hold_time));
-                    }
-                    accumulated_duration_ms += current_scene_duration;
-                }
-
-                // Per guidance, use motor_reverse to signal the transition out of CLIMAX
-                if (random(100) < 40) { // 40% chance to reverse out of the climax
-                    script.push_back("motor_reverse");
-                    accumulated_duration_ms += DEFAULT_RAMP_DURATION_MS + 1000;
-                }
-                currentPhase = VIBE; // Transition back to start
-                scene_duration_ms = 0; // We handled holds inside this phase
-                break;
-            }
-        }
+    long total_duration_ms = duration_minutes * 60L * 1000L;
 
-        long remaining_time = total_duration_ms - accumulated_duration_ms;
-        if (scene_duration_ms > remaining_time && remaining_time > 1000) scene_duration_ms = remaining_time;
-        script.push_back(format_command("hold", scene_duration_ms));
-        accumulated_duration_ms += scene_duration_ms;
-    }
+    // --- Command Limit ---
+    // The script is written into a statically sized buffer, so the limit is fixed
+    // rather than derived from free heap.
+    const int max_commands = script_line_budget();
 
-    // --- 3. COOL DOWN ---
-    if (cool_down_duration_ms > 1000) {
-        script.push_back(format_phase_comment("COOL_DOWN"));
-        script.push_back(format_command("led_display_brightness", (long)random(20, 41))); // Dim for cooldown
-        script.push_back("led_reset");
-
-        int cooldown_effect = random(100);
-        if (cooldown_effect < 40) { // 40% chance for a final noise effect
-            script.push_back(format_command("motor_speed", (long)random(200, 301)));
-            const char* palette = calm_noise_palettes[random(calm_noise_palettes.size())];
-            char buffer[64];
-            sprintf(buffer, "led_effect:noise,%s,4,50", palette); // very slow and smooth
-            script.push_back(buffer);
-            script.push_back(format_command("hold", (long)cool_down_duration_ms));
-        } else if (cooldown_effect < 70) { // 30% chance for a twinkle effect
-            script.push_back(format_command("motor_speed", (long)random(200, 301)));
-            char buffer[64];
-            sprintf(buffer, "led_effect:twinkle,%d,80", (int)random(256));
-            script.push_back(buffer);
-            script.push_back(format_command("hold", (long)cool_down_duration_ms));
-        } else {
-            script.push_back(format_command("motor_speed", (long)random(400, 501)));
-            script.push_back(format_command("led_background", (int)random(256), (int)random(5, 15))); // Dim background
-            script.push_back(format_command("led_tails", (int)random(256), (int)random(20, 30), 1)); // One long tail
-            script.push_back(format_command("hold", (long)cool_down_duration_ms / 2));
-            script.push_back(format_command("motor_speed", (long)random(200, 301)));
-            script.push_back(format_command("hold", (long)cool_down_duration_ms / 2));
-        }
+    if (verbose) {
+        AUTO_LOG("Generating auto-script for %d minutes (%ld ms)...", duration_minutes, total_duration_ms);
+        AUTO_LOG("Max commands: %d", max_commands);
     }
 
-    // --- 4. FINALE ---
-    script.push_back("system_off");
+    PhaseTemplates::Context context;
+    context.random = templateRandom;
+    context.revTimeMs = templateRevTimeMs<Config>;
+    context.rampMs = rampDurationMs;
+    context.wouldLimit = PowerBudget::wouldLimit; // Learned from the frames shown so far
+    PhaseTemplates::Composition plan;
+    PhaseTemplates::compose(total_duration_ms, max_commands, context, script, &plan);
+    if (plan.fitFailed) {
+        AUTO_LOG("Hold fitting failed: the script pool is full. The show runs %ld ms instead of %ld ms.",
+                 plan.fittedMs, total_duration_ms);
+    }
 
-    AUTO_LOG("Generated %d script commands for a total duration of ~%ld ms.", script.size(), accumulated_duration_ms);
-    Serial.println("\n--- BEGIN AUTO-GENERATED SCRIPT ---");
-    for (const auto& cmd : script) { Serial.println(cmd.c_str()); }
-    Serial.println("--- END AUTO-GENERATED SCRIPT ---");
-    Serial.printf("Total script lines generated: %d\n\n", (int)script.size());
+    if (!verbose) return;
 
-    return script;
+    AUTO_LOG("Composition Overview for %d minutes:", duration_minutes);
+    AUTO_LOG("  - INTRODUCTION: ~%lds", plan.introMs / 1000);
+    AUTO_LOG("  - MAIN BODY:    ~%ldm", plan.bodyMs / 60000);
+    AUTO_LOG("  - COOL_DOWN:    ~%lds", plan.coolDownMs / 1000);
+
+    AUTO_LOG("Generated %d script commands. Budgeted %ld ms; step model predicted %ld ms (%+ld ms).",
+             script.size(), plan.plannedMs, plan.predictedMs, plan.predictedMs - total_duration_ms);
+    AUTO_LOG("Holds scaled to %d%%: predicted %ld ms (%+ld ms, tolerance %ld ms).", plan.holdScalePercent,
+             plan.fittedMs, plan.fittedMs - total_duration_ms, PhaseTemplates::FIT_TOLERANCE_MS);
+    if (script.dropped() > 0) AUTO_LOG("Script buffer full: %d lines dropped.", script.dropped());
 }
 
-std::vector<std::string> generateSteadyRotateScript(int duration_minutes) {
-    std::vector<std::string> script;
-    if (duration_minutes <= 0) return script;
+template <typename Config>
+void generateSteadyRotateScript(int duration_minutes, ScriptBuffer& script, uint32_t seed, bool verbose) {
+    script.clear();
+    if (duration_minutes <= 0) return;
 
-    // --- Configuration for auto_steady_rotate mode ---
-    const float AUTO_STEADY_ROTATE_LED_MOTOR_MAX_RATIO = 4.0;
-    const float AUTO_STEADY_ROTATE_LED_MOTOR_MIN_RATIO = 1.0;
-    const int AUTO_STEADY_ROTATE_LED_EFFECT_STEPS = 10;
-    const float AUTO_STEADY_ROTATE_LED_EFFECT_STEP_DURATION_S = 2.0;
-    const long STEADY_MOTOR_SPEED = 500; // Default speed for this mode
+    randomSeed(seed != 0 ? seed : millis());
+    if (verbose) AUTO_LOG("Generating auto_steady_rotate script for %d minutes...", duration_minutes);
 
-    randomSeed(millis());
-    long total_duration_ms = duration_minutes * 60L * 1000L;
-    long accumulated_duration_ms = 0;
-
-    AUTO_LOG("Generating auto_steady_rotate script for %d minutes...", duration_minutes);
-
-    script.push_back("led_global_brightness:20");
-    script.push_back(format_command("motor_speed", STEADY_MOTOR_SPEED));
-    script.push_back("hold:3000"); // Give motor time to spin up to steady speed
-    accumulated_duration_ms += 3000;
-
-    long step_duration_ms = (long)(AUTO_STEADY_ROTATE_LED_EFFECT_STEP_DURATION_S * 1000.0);
-    long one_way_ramp_duration_ms = AUTO_STEADY_ROTATE_LED_EFFECT_STEPS * step_duration_ms;
-    long full_cycle_duration_ms = 2 * (AUTO_STEADY_ROTATE_LED_EFFECT_STEPS + 1) * step_duration_ms;
-
-    // Dynamic command limit
-    const long HEAP_SAFETY_MARGIN = 50 * 1024;
-    const int AVG_COMMAND_MEMORY_COST = 48;
-    const int ABSOLUTE_MAX_COMMANDS = 2000;
-    long free_heap = ESP.getFreeHeap();
-    long available_for_script = free_heap - HEAP_SAFETY_MARGIN;
-    int max_commands = 100;
-    if (available_for_script > 0) {
-        max_commands = min(ABSOLUTE_MAX_COMMANDS, (int)(available_for_script / AVG_COMMAND_MEMORY_COST));
-    }
-    AUTO_LOG("Heap: %ldB free. Dynamic max commands set to: %d", free_heap, max_commands);
-
-    while (accumulated_duration_ms < total_duration_ms && script.size() < max_commands - 25) {
-        script.push_back(format_phase_comment("NEW STEADY CYCLE"));
-
-        script.push_back("led_reset"); // Clear previous effects
-
-        // Rotational effect (Comet or Marquee)
-        bool use_comet = random(100) < 50;
-        uint8_t fg_hue = random(256);
-        uint8_t bg_hue = (fg_hue + random(80, 177)) % 256; // Contrasting bg
-
-        if (use_comet) {
-            script.push_back(format_phase_comment("COMET EFFECT"));
-            int length = random(15, 41);
-            int num_tails = random(1, 6);
-            script.push_back(format_command("led_tails", (int)fg_hue, length, num_tails));
-
-            // Add layering for more color variety
-            int color_mod_choice = random(100);
-            if (color_mod_choice < 33) {
-                script.push_back("led_rainbow");
-            } else if (color_mod_choice < 66) {
-                uint8_t hue_low = random(256);
-                uint8_t hue_high = (hue_low + random(60, 120)) % 256;
-                script.push_back(format_command("led_sine_hue", (int)hue_low, (int)hue_high));
-            }
-            // else: plain comet color
-        } else { // marquee
-            script.push_back(format_phase_comment("MARQUEE EFFECT"));
-            int light_width = random(2, 6);
-            int dark_width = random(4, 11);
-            char buffer[64];
-            sprintf(buffer, "led_effect:marquee,%d,%d,%d", fg_hue, light_width, dark_width);
-            script.push_back(buffer);
-        }
-        script.push_back(format_command("led_background", (int)bg_hue, (int)random(10, 26)));
+    PhaseTemplates::Context context;
+    context.random = templateRandom;
+    context.revTimeMs = templateRevTimeMs<Config>;
+    context.rampMs = 0;         // Not used: the motor holds one speed
+    context.wouldLimit = nullptr;
+    SteadyRotate::compose(duration_minutes * 60L * 1000L, script_line_budget(), context, script);
 
-        // Randomly set LED direction for this cycle
-        if (random(100) < 50) {
-            script.push_back("led_reverse");
-        }
-
-        long est_rev_time = calculate_rev_time_ms(STEADY_MOTOR_SPEED);
-
-        // Ramp from slow to fast (MAX_RATIO to MIN_RATIO)
-        script.push_back(format_phase_comment("Ramp Up LED Speed"));
-        for (int i = 0; i <= AUTO_STEADY_ROTATE_LED_EFFECT_STEPS; i++) {
-            float ratio = map(i, 0, AUTO_STEADY_ROTATE_LED_EFFECT_STEPS, (long)(AUTO_STEADY_ROTATE_LED_MOTOR_MAX_RATIO * 100), (long)(AUTO_STEADY_ROTATE_LED_MOTOR_MIN_RATIO * 100)) / 100.0f;
-            long cycle_time = (long)(est_rev_time * ratio);
-            script.push_back(format_command("led_cycle_time", cycle_time));
-            script.push_back(format_command("hold", step_duration_ms));
-        }
-        accumulated_duration_ms += (AUTO_STEADY_ROTATE_LED_EFFECT_STEPS + 1) * step_duration_ms;
-
-        // Ramp from fast to slow (MIN_RATIO to MAX_RATIO)
-        script.push_back(format_phase_comment("Ramp Down LED Speed"));
-        for (int i = 0; i <= AUTO_STEADY_ROTATE_LED_EFFECT_STEPS; i++) {
-            float ratio = map(i, 0, AUTO_STEADY_ROTATE_LED_EFFECT_STEPS, (long)(AUTO_STEADY_ROTATE_LED_MOTOR_MIN_RATIO * 100), (long)(AUTO_STEADY_ROTATE_LED_MOTOR_MAX_RATIO * 100)) / 100.0f;
-            long cycle_time = (long)(est_rev_time * ratio);
-            script.push_back(format_command("led_cycle_time", cycle_time));
-            script.push_back(format_command("hold", step_duration_ms));
-        }
-        accumulated_duration_ms += (AUTO_STEADY_ROTATE_LED_EFFECT_STEPS + 1) * step_duration_ms;
-    }
-
-    script.push_back("system_off");
+    if (!verbose) return;
 
     AUTO_LOG("Generated %d script commands for auto_steady_rotate.", script.size());
-    Serial.println("\n--- BEGIN AUTO-STEADY-ROTATE SCRIPT ---");
-    for (const auto& cmd : script) { Serial.println(cmd.c_str()); }
-    Serial.println("--- END AUTO-STEADY-ROTATE SCRIPT ---");
-    Serial.printf("Total script lines generated: %d\n\n", (int)script.size());
-
-    return script;
+    if (script.dropped() > 0) AUTO_LOG("Script buffer full: %d lines dropped.", script.dropped());
 }
 
+// Instantiate the generators for the sculpture variant being built.
+template void generateScript<Sculpture>(int duration_minutes, uint32_t rampDurationMs, ScriptBuffer& script, uint32_t seed, bool verbose);
+template void generateSteadyRotateScript<Sculpture>(int duration_minutes, ScriptBuffer& script, uint32_t seed, bool verbose);
+
 } // namespace AutoGenerator
\ No newline at end of file
@@ -1,14 +1,33 @@
 #pragma once
 
-#include <vector>
-#include <string>
+#include <stdint.h>
+#include "script_buffer.h"
 
 namespace AutoGenerator {
 
-// Generates a script of commands for a given duration in minutes.
-std::vector<std::string> generateScript(int duration_minutes);
+// Both generators are templated on the sculpture variant (see sculpture_config.h)
+// and explicitly instantiated for the variant being built. They write straight into
+// the caller's script buffer (clearing it first) and never allocate.
+
+// Loads the auto_mode phase templates: /phases.txt on LittleFS if it is present and
+// valid, otherwise the built-in set. Call from setup(); it reads a file, so calls
+// after that need a HeapGuard::Exempt.
+void loadPhaseTemplates();
+// Logs where the active phase templates came from and their phases.
+void logPhaseTemplates();
+
+// `seed` 0 seeds the random generator from millis(); any other value repeats a show.
+// With `verbose` false nothing is logged (used by gen_bench). The script itself is never
+// printed here; main.cpp's script_dump exports it a few lines per loop pass.
+
+// Generates a script of commands for a given duration in minutes. Holds are fitted so
+// that, with the motor ramping over `rampDurationMs`, the show runs that long.
+template <typename Config>
+void generateScript(int duration_minutes, uint32_t rampDurationMs, ScriptBuffer& script,
+                    uint32_t seed = 0, bool verbose = true);
 
 // Generates a script for the "steady rotate" mode for a given duration.
-std::vector<std::string> generateSteadyRotateScript(int duration_minutes);
+template <typename Config>
+void generateSteadyRotateScript(int duration_minutes, ScriptBuffer& script, uint32_t seed = 0, bool verbose = true);
 
-} // namespace AutoGenerator
\ No newline at end of file
+} // namespace AutoGenerator
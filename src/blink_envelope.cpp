@@ -0,0 +1,35 @@
+#include "blink_envelope.h"
+#include <math.h>
+
+namespace BlinkEnvelope {
+
+// FastLED's scale8_video(): scales without ever taking a non-zero value to zero.
+static uint8_t scaleVideo(uint8_t value, uint8_t scale) {
+    return (uint8_t)(((int)value * (int)scale >> 8) + ((value && scale) ? 1 : 0));
+}
+
+void build(uint8_t* envelope, BlinkEase ease, uint8_t maxBri) {
+    for (int v = 0; v < BLINK_ENVELOPE_SIZE; v++) {
+        if (ease == BLINK_EASE_QUADRATIC) {
+            envelope[v] = scaleVideo((uint8_t)v, (uint8_t)v);
+        } else if (ease == BLINK_EASE_GAMMA && maxBri > 0) {
+            float t = (float)(v < maxBri ? v : maxBri) / maxBri;
+            envelope[v] = (uint8_t)(powf(t, 2.2f) * maxBri + 0.5f);
+        } else {
+            envelope[v] = (uint8_t)v;
+        }
+    }
+}
+
+uint8_t level(const uint8_t* envelope, uint8_t maxBri, unsigned long upMs, unsigned long downMs, unsigned long cyclePos) {
+    // The linear ramp, truncating as the map() calls it replaces did.
+    uint32_t linear;
+    if (cyclePos < upMs) {
+        linear = (uint32_t)((uint64_t)cyclePos * maxBri / upMs);
+    } else {
+        linear = maxBri - (uint32_t)((uint64_t)(cyclePos - upMs) * maxBri / downMs);
+    }
+    return envelope[linear < (uint32_t)BLINK_ENVELOPE_SIZE ? linear : BLINK_ENVELOPE_SIZE - 1];
+}
+
+} // namespace BlinkEnvelope
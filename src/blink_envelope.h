@@ -0,0 +1,36 @@
+#pragma once
+
+#include <stdint.h>
+
+// The brightness envelope of the "blink" LED effect.
+//
+// A blink ramps linearly from 0 up to its peak level and back down, repeating, as it
+// always has. The easing is a lookup table from that linear level to the level the
+// frame is drawn at, built once per led_blink, so a frame costs one divide and one
+// lookup rather than an HSV conversion.
+//
+// Nothing here touches FastLED or Arduino APIs, so it also builds on the host.
+
+// How blink brightness follows the linear ramp. Quadratic is the default and is the
+// look blinks had when each frame was drawn as CHSV(hue, 255, bri): FastLED's rainbow
+// conversion dims by scale8_video(bri, bri). Gamma (2.2) ramps evenly as the eye sees it.
+enum BlinkEase : uint8_t {
+    BLINK_EASE_LINEAR,
+    BLINK_EASE_QUADRATIC,
+    BLINK_EASE_GAMMA,
+};
+
+// Entries in the blink envelope: one per linear level.
+const int BLINK_ENVELOPE_SIZE = 256;
+
+namespace BlinkEnvelope {
+
+// Fills `envelope` (BLINK_ENVELOPE_SIZE levels) with the eased level for each linear
+// level from 0 to `maxBri`. Levels scale the blink's full-brightness colour.
+void build(uint8_t* envelope, BlinkEase ease, uint8_t maxBri);
+
+// The level at `cyclePos` ms into a cycle of `upMs` ramping up to `maxBri` then `downMs`
+// down. Both durations must be at least 1 ms and cyclePos less than their sum.
+uint8_t level(const uint8_t* envelope, uint8_t maxBri, unsigned long upMs, unsigned long downMs, unsigned long cyclePos);
+
+} // namespace BlinkEnvelope
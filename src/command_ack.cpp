@@ -0,0 +1,81 @@
+#include "command_ack.h"
+#include <stdio.h>
+
+namespace CommandAck {
+
+struct PendingAck {
+    int32_t seq;
+    Result result;
+    uint32_t receivedUs;
+    uint32_t decidedUs;
+    bool waitingForFrame;
+    int32_t frameUs; // apply -> frame, or -1
+};
+
+// Oldest first, so acknowledgements go out in the order commands were decided.
+static PendingAck __pending[PENDING_CAPACITY];
+static int __pendingHead = 0;
+static int __pendingCount = 0;
+static uint32_t __sent = 0;
+static uint32_t __overflowed = 0;
+
+static const char* const __resultNames[] = {
+    "applied",
+    "invalid",
+    "ignored",
+    "superseded",
+    "deferred"
+};
+
+void complete(int32_t seq, Result result, uint32_t receivedUs, uint32_t decidedUs) {
+    if (seq < 0) return;
+    if (__pendingCount == PENDING_CAPACITY) {
+        // Full: the oldest ACK is lost, which the client sees as a drop.
+        __pendingHead = (__pendingHead + 1) % PENDING_CAPACITY;
+        __pendingCount--;
+        __overflowed++;
+    }
+    PendingAck& a = __pending[(__pendingHead + __pendingCount) % PENDING_CAPACITY];
+    a.seq = seq;
+    a.result = result;
+    a.receivedUs = receivedUs;
+    a.decidedUs = decidedUs;
+    a.waitingForFrame = (result == RESULT_APPLIED);
+    a.frameUs = -1;
+    __pendingCount++;
+}
+
+void frameShown(uint32_t nowUs) {
+    for (int i = 0; i < __pendingCount; i++) {
+        PendingAck& a = __pending[(__pendingHead + i) % PENDING_CAPACITY];
+        if (!a.waitingForFrame) continue;
+        a.frameUs = (int32_t)(nowUs - a.decidedUs);
+        a.waitingForFrame = false;
+    }
+}
+
+bool takeReady(uint32_t nowUs, char* out, size_t len) {
+    if (__pendingCount == 0) return false;
+    PendingAck& a = __pending[__pendingHead];
+    if (a.waitingForFrame) {
+        if ((nowUs - a.decidedUs) < FRAME_TIMEOUT_US) return false;
+        a.waitingForFrame = false; // No frame came; report it without one
+    }
+    snprintf(out, len, "ACK %ld %s %lu %ld", (long)a.seq, resultName(a.result),
+             (unsigned long)(a.decidedUs - a.receivedUs), (long)a.frameUs);
+    __pendingHead = (__pendingHead + 1) % PENDING_CAPACITY;
+    __pendingCount--;
+    __sent++;
+    return true;
+}
+
+const char* resultName(Result result) {
+    if (result >= sizeof(__resultNames) / sizeof(__resultNames[0])) return "?";
+    return __resultNames[result];
+}
+
+uint32_t sent() { return __sent; }
+
+uint32_t overflowed() { return __overflowed; }
+
+} // namespace CommandAck
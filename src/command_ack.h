@@ -0,0 +1,65 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Acknowledgements for sequence-numbered BLE commands.
+//
+// A client that prefixes a command with "#<seq> " (e.g. "#42 led_global_brightness:80")
+// gets one line back on the Status characteristic once the command has been decided:
+//
+//   ACK <seq> <result> <recv_to_apply_us> <apply_to_frame_us>
+//
+// result is one of:
+//   applied    - processCommand() accepted it (values out of range are clamped)
+//   invalid    - processCommand() rejected the name or parameters, e.g. an unknown
+//                script or a cycle time of 0; nothing changed
+//   ignored    - not allowed right now (rejected lane, deferred queue full, script
+//                transport with no script running, or dropped because the show was
+//                stopped before it could apply)
+//   superseded - a newer value for the same parameter replaced it while coalescing
+//   deferred   - interim: held for the next scene boundary. A second ACK with the
+//                final result follows when it is applied or dropped.
+// recv_to_apply_us runs from the BLE write arriving to the command being decided.
+// apply_to_frame_us runs from then to the end of the next strip show(), i.e. the first
+// frame that can reflect the change; it is -1 for anything that was not applied, or if
+// no frame was shown within FRAME_TIMEOUT_US (e.g. the strip is idle). Blackouts
+// (led_reset, system_off, the end of a blink) are shown frames too.
+//
+// Commands without a prefix cost nothing here. Commands the BLE task had to drop
+// before loop() saw them (too long, queue full) are never acknowledged; the client
+// should treat a missing ACK as a drop. Only the loop task may call these functions.
+namespace CommandAck {
+
+enum Result : uint8_t {
+    RESULT_APPLIED,
+    RESULT_INVALID,
+    RESULT_IGNORED,
+    RESULT_SUPERSEDED,
+    RESULT_DEFERRED
+};
+
+const int PENDING_CAPACITY = 8;
+const uint32_t FRAME_TIMEOUT_US = 1000000;
+// Long enough for "ACK <seq> superseded <us> <us>" with 32-bit values.
+const size_t MAX_LINE_LEN = 48;
+
+// Records the outcome of command `seq` (ignored when seq < 0). Applied results wait
+// for the next frame; everything else is ready to send at once. If the pending list
+// is full the oldest entry is discarded.
+void complete(int32_t seq, Result result, uint32_t receivedUs, uint32_t decidedUs);
+
+// Call right after each strip show(). Stamps every applied command still waiting.
+void frameShown(uint32_t nowUs);
+
+// Formats the oldest acknowledgement that is ready (or has timed out waiting for a
+// frame) into `out` and removes it. Returns false if none is ready.
+bool takeReady(uint32_t nowUs, char* out, size_t len);
+
+const char* resultName(Result result);
+
+// Acknowledgements sent so far, and how many were lost to a full pending list.
+uint32_t sent();
+uint32_t overflowed();
+
+} // namespace CommandAck
@@ -0,0 +1,18 @@
+#include "command_limits.h"
+
+namespace CommandLimits {
+
+bool cometsFit(int count, int tailLength, int logicalLength) {
+    if (count < 1) return true;
+    if (count > logicalLength) return false; // Even one-LED comets would not fit
+    int64_t covered = (int64_t)count * (tailLength < 1 ? 1 : tailLength);
+    return covered * 100 <= (int64_t)logicalLength * COMET_COVER_PERCENT;
+}
+
+uint32_t seekMs(int seconds) {
+    if (seconds <= 0) return 0;
+    uint64_t ms = (uint64_t)seconds * 1000;
+    return (ms > UINT32_MAX) ? UINT32_MAX : (uint32_t)ms;
+}
+
+} // namespace CommandLimits
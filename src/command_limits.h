@@ -0,0 +1,25 @@
+#pragma once
+
+#include <stdint.h>
+
+// Limits processCommand() in main.cpp checks on a command's parsed fields before it
+// acts on them, kept apart so the fuzz harness (src/sim/command_fuzz.cpp) runs them on
+// every command it parses.
+//
+// Fields come from atoi(), so any int can arrive, INT_MAX and INT_MIN included. Nothing
+// here overflows on one: products are taken in 64 bits and results saturate.
+namespace CommandLimits {
+
+// Share of the logical strip that comets and their tails may cover.
+const int COMET_COVER_PERCENT = 80;
+
+// led_tails' LENGTH,COUNT and led_comet_group's COUNT,TAIL. A count below 1 means the
+// comets are off and always fits; a tail below 1 counts as 1. True if `count` comets
+// with `tailLength`-LED tails cover at most COMET_COVER_PERCENT of the strip.
+bool cometsFit(int count, int tailLength, int logicalLength);
+
+// script_seek:SECONDS as milliseconds. Negative seconds read as 0; the product
+// saturates at UINT32_MAX (the seek then stops just short of the end).
+uint32_t seekMs(int seconds);
+
+} // namespace CommandLimits
@@ -0,0 +1,70 @@
+#include "command_parser.h"
+#include <stdlib.h>
+#include <string.h>
+
+namespace CommandParser {
+
+bool split(const char* line, char* name, const char** params) {
+    const char* colon = strchr(line, ':');
+    size_t len = colon ? (size_t)(colon - line) : strlen(line);
+    if (len > MAX_NAME_LEN) return false;
+    memcpy(name, line, len);
+    name[len] = '\0';
+    *params = colon ? colon + 1 : nullptr;
+    return true;
+}
+
+int fieldCount(const char* params) {
+    int count = 1;
+    for (const char* p = params; *p; p++) {
+        if (*p == ',') count++;
+    }
+    return count;
+}
+
+int parseInts(const char* params, int* out, int maxCount) {
+    int count = 0;
+    const char* p = params;
+    while (true) {
+        if (count < maxCount) out[count] = atoi(p);
+        count++;
+        const char* comma = strchr(p, ',');
+        if (comma == nullptr) break;
+        p = comma + 1;
+    }
+    return count;
+}
+
+bool copyField(const char* params, int index, char* out, size_t len) {
+    const char* p = params;
+    for (int i = 0; i < index; i++) {
+        p = strchr(p, ',');
+        if (p == nullptr) return false;
+        p++;
+    }
+    const char* end = strchr(p, ',');
+    size_t fieldLen = end ? (size_t)(end - p) : strlen(p);
+    if (len == 0) return true;
+    if (fieldLen > len - 1) fieldLen = len - 1;
+    memcpy(out, p, fieldLen);
+    out[fieldLen] = '\0';
+    return true;
+}
+
+const char* stripSequence(const char* line, int32_t* seq) {
+    *seq = -1;
+    if (line[0] != '#') return line;
+    const char* p = line + 1;
+    int32_t value = 0;
+    int digits = 0;
+    while (*p >= '0' && *p <= '9' && digits < 9) {
+        value = value * 10 + (*p - '0');
+        p++;
+        digits++;
+    }
+    if (digits == 0 || *p != ' ') return line; // Not a sequence prefix; leave it to the parser
+    *seq = value;
+    return p + 1;
+}
+
+} // namespace CommandParser
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Allocation-free helpers for parsing "name:p1,p2,..." command lines in place.
+//
+// Fields are parsed with atoi() semantics, matching how commands have always been
+// read: a field that is empty or not a number reads as 0, and trailing text after
+// the digits is ignored.
+namespace CommandParser {
+
+// Longest command name (the part before ':'), excluding the terminator.
+const size_t MAX_NAME_LEN = 31;
+
+// Splits `line` at the first ':'. Copies the name into `name` (which must hold
+// MAX_NAME_LEN + 1 chars) and points `params` at the text after the colon, or sets it
+// to nullptr if there is no colon. Returns false if the name is too long.
+bool split(const char* line, char* name, const char** params);
+
+// Number of comma-separated fields in `params` (an empty string is one empty field).
+int fieldCount(const char* params);
+
+// Parses up to `maxCount` comma-separated integers into `out`. Returns the number of
+// fields present in `params` (which may exceed maxCount).
+int parseInts(const char* params, int* out, int maxCount);
+
+// Copies field `index` (0-based) of `params` into `out`. Returns false if there is no
+// such field; the copy is truncated to fit.
+bool copyField(const char* params, int index, char* out, size_t len);
+
+// Strips an optional "#<seq> " prefix (e.g. "#42 motor_speed:500"), used by clients
+// that want an acknowledgement. Sets `seq` to the number, or to -1 if there is no
+// prefix, and returns the command text after it.
+const char* stripSequence(const char* line, int32_t* seq);
+
+inline bool startsWith(const char* s, const char* prefix) {
+    while (*prefix) {
+        if (*s++ != *prefix++) return false;
+    }
+    return true;
+}
+
+} // namespace CommandParser
@@ -0,0 +1,48 @@
+#include "command_queue.h"
+#include <atomic>
+#include <string.h>
+
+namespace CommandQueue {
+
+struct Slot {
+    char text[MAX_COMMAND_LEN + 1];
+    uint32_t receivedUs;
+};
+
+static Slot __slots[CAPACITY];
+// Free-running counters; the slot is the counter modulo CAPACITY.
+static std::atomic<uint32_t> __head(0); // Next slot to write. Only the producer stores.
+static std::atomic<uint32_t> __tail(0); // Next slot to read. Only the consumer stores.
+static std::atomic<uint32_t> __dropped(0);
+
+bool push(const char* data, size_t len, uint32_t receivedUs) {
+    uint32_t head = __head.load(std::memory_order_relaxed);
+    uint32_t tail = __tail.load(std::memory_order_acquire);
+    if (len > MAX_COMMAND_LEN || head - tail >= (uint32_t)CAPACITY) {
+        __dropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    Slot& slot = __slots[head % CAPACITY];
+    memcpy(slot.text, data, len);
+    slot.text[len] = '\0';
+    slot.receivedUs = receivedUs;
+    __head.store(head + 1, std::memory_order_release);
+    return true;
+}
+
+bool pop(char* out, uint32_t* receivedUs) {
+    uint32_t tail = __tail.load(std::memory_order_relaxed);
+    uint32_t head = __head.load(std::memory_order_acquire);
+    if (tail == head) return false;
+    const Slot& slot = __slots[tail % CAPACITY];
+    memcpy(out, slot.text, sizeof(slot.text));
+    if (receivedUs) *receivedUs = slot.receivedUs;
+    __tail.store(tail + 1, std::memory_order_release);
+    return true;
+}
+
+uint32_t dropped() {
+    return __dropped.load(std::memory_order_relaxed);
+}
+
+} // namespace CommandQueue
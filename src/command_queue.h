@@ -0,0 +1,28 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Hands BLE commands from the BLE task to loop() without locks or heap.
+//
+// A fixed ring of fixed-size slots with exactly one producer (the BLE write callback)
+// and one consumer (loop()). Each side only ever advances its own index, and the
+// indices are published with release/acquire ordering, so a slot's text is complete
+// before the consumer can see it. Commands that arrive while the ring is full are
+// dropped and counted.
+namespace CommandQueue {
+
+const int CAPACITY = 8;
+// Longest command accepted, excluding the terminator.
+const size_t MAX_COMMAND_LEN = 127;
+
+// Producer side (BLE task). Returns false if the command is too long or the ring is full.
+bool push(const char* data, size_t len, uint32_t receivedUs);
+
+// Consumer side (loop task). Copies the oldest command into `out` (which must hold
+// MAX_COMMAND_LEN + 1 chars). Returns false if the ring is empty.
+bool pop(char* out, uint32_t* receivedUs);
+
+uint32_t dropped();
+
+} // namespace CommandQueue
@@ -0,0 +1,287 @@
+#include "command_router.h"
+#include <string.h>
+
+namespace CommandRouter {
+
+// True if the command name (the part before any ':') is exactly `name`.
+static bool nameIs(const char* cmd, const char* name) {
+    size_t len = strlen(name);
+    return strncmp(cmd, name, len) == 0 && (cmd[len] == '\0' || cmd[len] == ':');
+}
+
+static bool nameIn(const char* cmd, const char* const* names, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        if (nameIs(cmd, names[i])) return true;
+    }
+    return false;
+}
+
+#define COUNT_OF(a) (sizeof(a) / sizeof((a)[0]))
+
+// Show control: applied at once, and the running script is stopped first.
+static const char* const __scriptStoppingCommands[] = {
+    "system_reset", "system_off", "motor_stop", "run_script", "auto_mode", "auto_steady_rotate"
+};
+// Diagnostics, router control and script transport: applied at once without stopping
+// the show.
+static const char* const __passThroughCommands[] = {
+    "lcd", "lcd_stats", "trace", "heap_guard", "router_status", "clear_overrides",
+    "script_pause", "script_resume", "script_seek", "script_next", "script_prev",
+    "script_status", "auto_templates", "render_split", "render_bench", "power_status",
+    "script_dump", "loop_watchdog", "loop_budget",
+    "sys_stats", "particle_bench"
+};
+// Only meaningful outside a script. The debug generators would overwrite the
+// running script's buffer.
+static const char* const __rejectedCommands[] = {
+    "hold", "auto_mode_debug", "auto_steady_rotate_debug", "gen_bench"
+};
+
+struct ParamCommand {
+    const char* name;
+    ParamKey key;
+};
+static const ParamCommand __paramCommands[] = {
+    { "led_global_brightness", PARAM_GLOBAL_BRIGHTNESS },
+    { "led_display_brightness", PARAM_DISPLAY_BRIGHTNESS },
+    { "motor_speed", PARAM_MOTOR_SPEED },
+    { "motor_speed_up", PARAM_MOTOR_SPEED },
+    { "motor_speed_down", PARAM_MOTOR_SPEED },
+    { "motor_ramp", PARAM_MOTOR_RAMP },
+    { "led_cycle_time", PARAM_LED_CYCLE_TIME },
+    { "led_cycle_up", PARAM_LED_CYCLE_TIME },
+    { "led_cycle_down", PARAM_LED_CYCLE_TIME },
+    { "led_background", PARAM_BACKGROUND },
+};
+
+static const char* const __paramNames[PARAM_COUNT] = {
+    "global_brightness",
+    "display_brightness",
+    "motor_speed",
+    "motor_ramp",
+    "led_cycle_time",
+    "background"
+};
+
+Lane classify(const char* cmd) {
+    if (nameIn(cmd, __scriptStoppingCommands, COUNT_OF(__scriptStoppingCommands))) return LANE_OVERRIDE;
+    if (nameIn(cmd, __passThroughCommands, COUNT_OF(__passThroughCommands))) return LANE_OVERRIDE;
+    if (nameIn(cmd, __rejectedCommands, COUNT_OF(__rejectedCommands))) return LANE_REJECT;
+    if (paramKey(cmd) != PARAM_NONE) return LANE_PARAM;
+    return LANE_DEFERRED;
+}
+
+bool stopsScript(const char* cmd) {
+    return nameIn(cmd, __scriptStoppingCommands, COUNT_OF(__scriptStoppingCommands));
+}
+
+ParamKey paramKey(const char* cmd) {
+    for (size_t i = 0; i < COUNT_OF(__paramCommands); i++) {
+        if (nameIs(cmd, __paramCommands[i].name)) return __paramCommands[i].key;
+    }
+    return PARAM_NONE;
+}
+
+const char* paramName(ParamKey key) {
+    if (key < 0 || key >= PARAM_COUNT) return "?";
+    return __paramNames[key];
+}
+
+// --- Parameter Overrides ---
+static uint32_t __overrideMask = 0;
+
+void setOverride(ParamKey key) {
+    if (key >= 0 && key < PARAM_COUNT) __overrideMask |= (1u << key);
+}
+
+bool isOverridden(ParamKey key) {
+    return key >= 0 && key < PARAM_COUNT && (__overrideMask & (1u << key)) != 0;
+}
+
+uint32_t overrideMask() { return __overrideMask; }
+
+void clearOverrides() { __overrideMask = 0; }
+
+uint32_t expireOverrides() {
+    uint32_t expired = __overrideMask;
+    __overrideMask = 0;
+    return expired;
+}
+
+// --- Deferred Commands ---
+static char __deferred[DEFERRED_CAPACITY][MAX_DEFERRED_LEN + 1];
+static CommandTag __deferredTags[DEFERRED_CAPACITY];
+static int __deferredHead = 0; // Oldest entry
+static int __deferredCount = 0;
+
+bool defer(const char* cmd, const CommandTag& tag) {
+    size_t len = strlen(cmd);
+    if (len > MAX_DEFERRED_LEN || __deferredCount >= DEFERRED_CAPACITY) return false;
+    int slot = (__deferredHead + __deferredCount) % DEFERRED_CAPACITY;
+    memcpy(__deferred[slot], cmd, len + 1);
+    __deferredTags[slot] = tag;
+    __deferredCount++;
+    return true;
+}
+
+bool popDeferred(char* out, CommandTag* tag) {
+    if (__deferredCount == 0) return false;
+    memcpy(out, __deferred[__deferredHead], MAX_DEFERRED_LEN + 1);
+    if (tag) *tag = __deferredTags[__deferredHead];
+    __deferredHead = (__deferredHead + 1) % DEFERRED_CAPACITY;
+    __deferredCount--;
+    return true;
+}
+
+int deferredCount() { return __deferredCount; }
+
+void clearDeferred() {
+    __deferredHead = 0;
+    __deferredCount = 0;
+}
+
+// --- Coalescing ---
+// Only setters that carry an absolute value can have older writes discarded.
+static const char* const __coalescedCommands[] = {
+    "led_global_brightness", "led_display_brightness", "motor_speed", "motor_ramp",
+    "led_cycle_time", "led_background"
+};
+
+struct StagedCommand {
+    bool pending;
+    char text[MAX_DEFERRED_LEN + 1];
+    CommandTag tag;
+    uint32_t stagedOrder;      // When it was staged, relative to the others
+    uint32_t lastAppliedMs;
+    bool everApplied;
+    uint32_t applied;
+    uint32_t replaced;
+};
+static StagedCommand __staged[PARAM_COUNT];
+static uint32_t __stageCounter = 0;
+
+ParamKey coalesceKey(const char* cmd) {
+    if (!nameIn(cmd, __coalescedCommands, COUNT_OF(__coalescedCommands))) return PARAM_NONE;
+    return paramKey(cmd);
+}
+
+bool offerCoalesced(ParamKey key, const char* cmd, const CommandTag& tag, uint32_t now_ms, CommandTag* replaced) {
+    if (replaced) replaced->seq = -1;
+    if (key < 0 || key >= PARAM_COUNT) return true;
+    StagedCommand& s = __staged[key];
+    bool intervalUp = !s.everApplied || (now_ms - s.lastAppliedMs) >= COALESCE_INTERVAL_MS;
+    if (!s.pending && intervalUp) {
+        s.everApplied = true;
+        s.lastAppliedMs = now_ms;
+        s.applied++;
+        return true;
+    }
+    size_t len = strlen(cmd);
+    if (len > MAX_DEFERRED_LEN) return true; // Cannot stage it; let it through
+    if (s.pending) {
+        s.replaced++;
+        if (replaced) *replaced = s.tag;
+    }
+    memcpy(s.text, cmd, len + 1);
+    s.tag = tag;
+    s.stagedOrder = __stageCounter++;
+    s.pending = true;
+    return false;
+}
+
+static void takeStaged(StagedCommand& s, uint32_t now_ms, char* out, CommandTag* tag) {
+    memcpy(out, s.text, sizeof(s.text));
+    if (tag) *tag = s.tag;
+    s.pending = false;
+    s.lastAppliedMs = now_ms;
+    s.applied++;
+}
+
+bool takeDueCoalesced(uint32_t now_ms, char* out, CommandTag* tag) {
+    for (int k = 0; k < PARAM_COUNT; k++) {
+        StagedCommand& s = __staged[k];
+        if (!s.pending || (now_ms - s.lastAppliedMs) < COALESCE_INTERVAL_MS) continue;
+        takeStaged(s, now_ms, out, tag);
+        return true;
+    }
+    return false;
+}
+
+bool takeStagedBefore(const char* cmd, uint32_t now_ms, char* out, CommandTag* tag) {
+    if (coalesceKey(cmd) != PARAM_NONE) return false;
+    StagedCommand* oldest = nullptr;
+    for (int k = 0; k < PARAM_COUNT; k++) {
+        StagedCommand& s = __staged[k];
+        // Counter order, so it holds across a wrap of the counter.
+        if (s.pending && (!oldest || (int32_t)(s.stagedOrder - oldest->stagedOrder) < 0)) oldest = &s;
+    }
+    if (!oldest) return false;
+    takeStaged(*oldest, now_ms, out, tag);
+    return true;
+}
+
+int discardStaged(CommandTag* dropped) {
+    int count = 0;
+    for (int k = 0; k < PARAM_COUNT; k++) {
+        if (!__staged[k].pending) continue;
+        __staged[k].pending = false;
+        if (dropped) dropped[count] = __staged[k].tag;
+        count++;
+    }
+    return count;
+}
+
+uint32_t coalesceApplied(ParamKey key) {
+    return (key >= 0 && key < PARAM_COUNT) ? __staged[key].applied : 0;
+}
+
+uint32_t coalesceReplaced(ParamKey key) {
+    return (key >= 0 && key < PARAM_COUNT) ? __staged[key].replaced : 0;
+}
+
+void resetCoalesceStats() {
+    for (int k = 0; k < PARAM_COUNT; k++) {
+        __staged[k].applied = 0;
+        __staged[k].replaced = 0;
+    }
+}
+
+// --- Status Ring ---
+static StatusEntry __ring[STATUS_RING_SIZE];
+static int __ringHead = 0; // Next slot to write
+static int __ringCount = 0;
+
+static const char* const __decisionNames[] = {
+    "applied",
+    "override",
+    "param_override",
+    "deferred",
+    "deferred_applied",
+    "shadowed",
+    "rejected",
+    "dropped"
+};
+
+void record(Decision decision, const char* cmd, uint32_t now_ms) {
+    StatusEntry& e = __ring[__ringHead];
+    e.ms = now_ms;
+    e.decision = decision;
+    strncpy(e.text, cmd, sizeof(e.text) - 1);
+    e.text[sizeof(e.text) - 1] = '\0';
+    __ringHead = (__ringHead + 1) % STATUS_RING_SIZE;
+    if (__ringCount < STATUS_RING_SIZE) __ringCount++;
+}
+
+int statusCount() { return __ringCount; }
+
+const StatusEntry& statusAt(int index) {
+    int oldest = (__ringHead - __ringCount + STATUS_RING_SIZE) % STATUS_RING_SIZE;
+    return __ring[(oldest + index) % STATUS_RING_SIZE];
+}
+
+const char* decisionName(Decision decision) {
+    if (decision >= COUNT_OF(__decisionNames)) return "?";
+    return __decisionNames[decision];
+}
+
+} // namespace CommandRouter
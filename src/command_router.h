@@ -0,0 +1,137 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Decides what happens to a BLE command that arrives while a script is running.
+//
+// Commands are sorted into lanes by name:
+//   LANE_OVERRIDE      - applied immediately. Show control (system_off, motor_stop,
+//                        run_script, ...) also stops the running script.
+//   LANE_PARAM         - a parameter tweak (brightness, motor speed, cycle time, ...).
+//                        Applied immediately and recorded as an override of that
+//                        parameter; the script's own writes to it are then skipped
+//                        for the rest of the scene.
+//   LANE_DEFERRED      - anything else that changes the look (effects, tails,
+//                        reverse). Held until the next scene boundary so it does not
+//                        fight the scene currently playing.
+//   LANE_REJECT        - only meaningful outside a script (hold, *_debug generators).
+// When no script is running every command is simply applied.
+//
+// Every decision is written to a small status ring that can be inspected later.
+// Nothing here allocates; the deferred queue and the ring are fixed arrays.
+namespace CommandRouter {
+
+enum Lane {
+    LANE_OVERRIDE,
+    LANE_PARAM,
+    LANE_DEFERRED,
+    LANE_REJECT
+};
+
+// Parameters a user can override. Several commands can map to one parameter
+// (e.g. motor_speed and motor_speed_up).
+enum ParamKey {
+    PARAM_NONE = -1,
+    PARAM_GLOBAL_BRIGHTNESS,
+    PARAM_DISPLAY_BRIGHTNESS,
+    PARAM_MOTOR_SPEED,
+    PARAM_MOTOR_RAMP,
+    PARAM_LED_CYCLE_TIME,
+    PARAM_BACKGROUND,
+    PARAM_COUNT
+};
+
+Lane classify(const char* cmd);
+// True for override commands that end the running script (show control).
+bool stopsScript(const char* cmd);
+ParamKey paramKey(const char* cmd);
+const char* paramName(ParamKey key);
+
+// Where a BLE command came from, carried with it through deferral and coalescing so
+// its acknowledgement (see command_ack.h) can be sent whenever it is finally decided.
+struct CommandTag {
+    int32_t seq;         // Client sequence number, or -1 if none was given
+    uint32_t receivedUs; // When the BLE write arrived
+};
+
+// --- Parameter Overrides ---
+// An override lasts until the next scene boundary (a phase marker, the end of the
+// script, or the start of a new or regenerated one), where expireOverrides() hands
+// the parameter back to the script. clearOverrides() drops them at any time.
+void setOverride(ParamKey key);
+bool isOverridden(ParamKey key);
+uint32_t overrideMask();
+void clearOverrides();
+// Clears every override and returns the mask of those that were set, so the caller
+// can say which parameters the script controls again.
+uint32_t expireOverrides();
+
+// --- Deferred Commands ---
+const int DEFERRED_CAPACITY = 8;
+const size_t MAX_DEFERRED_LEN = 127;
+
+// Returns false if the queue is full or the command is too long.
+bool defer(const char* cmd, const CommandTag& tag);
+// Copies the oldest deferred command into `out` (MAX_DEFERRED_LEN + 1 chars).
+bool popDeferred(char* out, CommandTag* tag);
+int deferredCount();
+void clearDeferred();
+
+// --- Coalescing ---
+// Absolute parameter setters (e.g. a slider sending led_global_brightness:N) are
+// coalesced last-writer-wins: a command for a key that was applied less than
+// COALESCE_INTERVAL_MS ago is staged instead, replacing any older staged value for
+// that key, and the newest is applied when the interval is up. A lone tap still
+// applies at once; a drag applies at most once per interval however fast the phone
+// sends. Relative commands (motor_speed_up, led_cycle_up, ...) are never coalesced.
+const uint32_t COALESCE_INTERVAL_MS = 40;
+
+// The key a command coalesces under, or PARAM_NONE.
+ParamKey coalesceKey(const char* cmd);
+// Returns true if `cmd` should be applied now. Otherwise it has been staged; if that
+// replaced an older staged command, its tag is copied to `replaced` (seq -1 if none).
+bool offerCoalesced(ParamKey key, const char* cmd, const CommandTag& tag, uint32_t now_ms, CommandTag* replaced);
+// Takes one staged command whose interval is up. Call until it returns false.
+bool takeDueCoalesced(uint32_t now_ms, char* out, CommandTag* tag);
+// Any command that is not coalesced must not overtake a staged value sent before it
+// (motor_speed:N then motor_reverse, led_background:... then led_reset). Before such a
+// `cmd` is routed, this takes the staged commands, oldest first, to be applied ahead
+// of it. Call until it returns false; it never returns a command for coalesced `cmd`.
+bool takeStagedBefore(const char* cmd, uint32_t now_ms, char* out, CommandTag* tag);
+// Drops staged values without applying them (e.g. when the show is stopped, so a
+// slider's last value cannot restart the motor afterwards). The dropped commands'
+// tags are copied to `dropped`, which must hold PARAM_COUNT entries; returns how many.
+int discardStaged(CommandTag* dropped);
+// Per key: commands applied, and commands replaced by a newer one before applying.
+uint32_t coalesceApplied(ParamKey key);
+uint32_t coalesceReplaced(ParamKey key);
+void resetCoalesceStats();
+
+// --- Status Ring ---
+enum Decision : uint8_t {
+    DECISION_APPLIED,          // No script running; applied normally
+    DECISION_OVERRIDE,         // Applied immediately during a script
+    DECISION_PARAM_OVERRIDE,   // Applied and recorded as a parameter override
+    DECISION_DEFERRED,         // Queued for the next scene boundary
+    DECISION_DEFERRED_APPLIED, // Applied at a scene boundary
+    DECISION_SHADOWED,         // A script command skipped because the user overrode it
+    DECISION_REJECTED,         // Not allowed while a script is running
+    DECISION_DROPPED           // Deferred queue full
+};
+
+const int STATUS_RING_SIZE = 16;
+
+struct StatusEntry {
+    uint32_t ms;
+    Decision decision;
+    char text[27]; // Command, truncated
+};
+
+void record(Decision decision, const char* cmd, uint32_t now_ms);
+int statusCount();
+// Entry `index` counting from the oldest still held.
+const StatusEntry& statusAt(int index);
+const char* decisionName(Decision decision);
+
+} // namespace CommandRouter
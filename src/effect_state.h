@@ -0,0 +1,91 @@
+#pragma once
+
+#include <FastLED.h>
+#include "blink_envelope.h"
+#include "sculpture_config.h"
+
+// Per-effect state for the full-strip LED effects.
+//
+// Only one effect runs at a time, so their state shares a single union instead of
+// each effect keeping its own statics permanently. The active LedEffect is the tag.
+// Switching effects re-initialises the incoming member to its defaults, so effect
+// state memory scales with the largest effect rather than the sum of all of them.
+//
+// Comet state is not in here: comet hue, tail and count are shared with the
+// sine/rainbow modifiers and survive switching to other effects and back.
+
+struct BlinkState {
+    uint8_t hue = 0;
+    uint8_t maxBri = 255;
+    unsigned long upDuration = 1000;
+    unsigned long downDuration = 1000;
+    unsigned long startTime = 0;
+    int targetCount = 0; // 0 means loop indefinitely
+    BlinkEase ease = BLINK_EASE_QUADRATIC;
+    CRGB color = CRGB::Black; // CHSV(hue, 255, 255), converted once per blink
+    // The eased level for each linear level of the ramp (see blink_envelope.h).
+    uint8_t envelope[BLINK_ENVELOPE_SIZE] = {};
+    int16_t shownLevel = -1;        // Level of the last frame pushed, -1 before the first
+    uint8_t shownBrightness = 0;    // FastLED brightness that frame went out at
+};
+
+struct NoiseState {
+    CRGBPalette16 palette;
+    uint8_t scale = 30;
+    uint16_t x = 0, y = 0, z = 0;
+    uint8_t speed = 10;
+};
+
+template <typename Config>
+struct FireState {
+    byte heat[Config::NUM_LEDS] = {};
+};
+
+struct MarqueeState {
+    uint8_t hue = 0;
+    uint8_t litWidth = 4;
+    uint8_t darkWidth = 8;
+    uint8_t offset = 0;
+};
+
+struct TwinkleState {
+    uint8_t hue = 0;
+    uint8_t density = 50; // 0-255 chance per frame
+};
+
+// The particles themselves live in ParticleSystem's pool, which is too large to share.
+struct ParticleState {
+    uint8_t fade = 64; // Trail: how much of the previous frame is faded out, 0-255
+};
+
+template <typename Config>
+union EffectStateStorage {
+    BlinkState blink;
+    NoiseState noise;
+    FireState<Config> fire;
+    MarqueeState marquee;
+    TwinkleState twinkle;
+    ParticleState particles;
+
+    // Members are constructed in place by the effect switch; all are trivially destructible.
+    EffectStateStorage() {}
+};
+
+#ifdef REPORT_EFFECT_RAM
+// Build with -DREPORT_EFFECT_RAM (see the m5stack-atoms3-ram-report env) to have the
+// compiler print each effect's state size as a warning of the form
+//   'void reportEffectRam() [with State = FireState<...>; unsigned int Bytes = 198]'
+template <typename State, size_t Bytes>
+__attribute__((deprecated("effect state RAM report"))) inline void reportEffectRam() {}
+
+template <typename Config>
+inline void reportAllEffectRam() {
+    reportEffectRam<BlinkState, sizeof(BlinkState)>();
+    reportEffectRam<NoiseState, sizeof(NoiseState)>();
+    reportEffectRam<FireState<Config>, sizeof(FireState<Config>)>();
+    reportEffectRam<MarqueeState, sizeof(MarqueeState)>();
+    reportEffectRam<TwinkleState, sizeof(TwinkleState)>();
+    reportEffectRam<ParticleState, sizeof(ParticleState)>();
+    reportEffectRam<EffectStateStorage<Config>, sizeof(EffectStateStorage<Config>)>();
+}
+#endif
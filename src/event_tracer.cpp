@@ -0,0 +1,100 @@
+#include "event_tracer.h"
+#include <stdio.h>
+
+#ifdef ARDUINO
+#include <Arduino.h>
+#else
+#include <chrono>
+#endif
+
+namespace EventTracer {
+
+static Event __ring[EVENT_TRACE_CAPACITY];
+static size_t __head = 0;   // Next slot to write
+static size_t __count = 0;
+static uint32_t __dropped = 0;
+static bool __enabled = false;
+
+static const char* const __eventNames[EV_COUNT] = {
+    "command_received",
+    "command",
+    "script_step",
+    "ramp_tick",
+    "frame_render",
+    "show"
+};
+
+void setEnabled(bool enabled) { __enabled = enabled; }
+bool isEnabled() { return __enabled; }
+
+void clear() {
+    __head = 0;
+    __count = 0;
+    __dropped = 0;
+}
+
+uint32_t now() {
+#ifdef ARDUINO
+    return micros();
+#else
+    static const auto start = std::chrono::steady_clock::now();
+    return (uint32_t)std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start).count();
+#endif
+}
+
+void recordAt(uint32_t ts_us, EventType type, EventId id, uint16_t arg) {
+    if (!__enabled) return;
+    Event& e = __ring[__head];
+    e.ts_us = ts_us;
+    e.type = type;
+    e.id = id;
+    e.arg = arg;
+    __head = (__head + 1) % EVENT_TRACE_CAPACITY;
+    if (__count < EVENT_TRACE_CAPACITY) __count++;
+    else __dropped++;
+}
+
+size_t count() { return __count; }
+uint32_t dropped() { return __dropped; }
+
+const Event& at(size_t i) {
+    size_t oldest = (__head + EVENT_TRACE_CAPACITY - __count) % EVENT_TRACE_CAPACITY;
+    return __ring[(oldest + i) % EVENT_TRACE_CAPACITY];
+}
+
+const char* eventName(uint8_t id) {
+    return (id < EV_COUNT) ? __eventNames[id] : "unknown";
+}
+
+bool formatDumpLine(size_t line, char* out, size_t out_len) {
+    if (line == 0) {
+        snprintf(out, out_len, "TH %u %lu", (unsigned)__count, (unsigned long)__dropped);
+        return true;
+    }
+    line -= 1;
+    if (line < EV_COUNT) {
+        snprintf(out, out_len, "TN %u %s", (unsigned)line, __eventNames[line]);
+        return true;
+    }
+    line -= EV_COUNT;
+    if (line >= __count) return false;
+
+    // Serialise explicitly as little-endian so the host side doesn't depend on struct layout.
+    const Event& e = at(line);
+    uint8_t bytes[8] = {
+        (uint8_t)(e.ts_us), (uint8_t)(e.ts_us >> 8), (uint8_t)(e.ts_us >> 16), (uint8_t)(e.ts_us >> 24),
+        e.type, e.id, (uint8_t)(e.arg), (uint8_t)(e.arg >> 8)
+    };
+    if (out_len < 3 + 16 + 1) return false;
+    static const char hex[] = "0123456789abcdef";
+    out[0] = 'T'; out[1] = 'E'; out[2] = ' ';
+    for (int i = 0; i < 8; i++) {
+        out[3 + i * 2] = hex[bytes[i] >> 4];
+        out[3 + i * 2 + 1] = hex[bytes[i] & 0x0F];
+    }
+    out[19] = '\0';
+    return true;
+}
+
+} // namespace EventTracer
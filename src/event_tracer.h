@@ -0,0 +1,84 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+// A compact binary event tracer for diagnosing stutters.
+//
+// Begin/end/instant events with microsecond timestamps are recorded into a fixed
+// RAM ring (8 bytes per event). The ring can be dumped as text lines over Serial or
+// BLE; tools/trace_to_chrome.py converts a dump into Chrome trace JSON that can be
+// opened in Perfetto (ui.perfetto.dev) or chrome://tracing.
+//
+// Dump format (one record per line, so partial BLE captures are still usable):
+//   TH <count> <dropped>      - header
+//   TN <id> <name>            - event name table
+//   TE <16 hex chars>         - one event: ts_us (u32 LE), type (u8), id (u8), arg (u16 LE)
+//
+// The recorder is not thread-safe by design: only the loop task records. Events that
+// happen on other tasks (e.g. a BLE write) pass their own timestamp to recordAt().
+// The module has no Arduino dependency beyond micros(), so it also builds natively.
+
+#ifndef EVENT_TRACE_CAPACITY
+#define EVENT_TRACE_CAPACITY 1024
+#endif
+
+namespace EventTracer {
+
+enum EventType : uint8_t {
+    TRACE_BEGIN = 'B',
+    TRACE_END = 'E',
+    TRACE_INSTANT = 'i'
+};
+
+// Event ids. Keep in sync with the name table in event_tracer.cpp.
+enum EventId : uint8_t {
+    EV_COMMAND_RECEIVED, // A BLE write arrived (instant, timestamped on the BLE task)
+    EV_COMMAND,          // processCommand() span. arg = source (0 = BLE, 1 = script)
+    EV_SCRIPT_STEP,      // Script engine executed a step (instant). arg = step index
+    EV_RAMP_TICK,        // Motor ramp step (instant). arg = logical speed
+    EV_FRAME_RENDER,     // Effect rendering span, up to the show() call
+    EV_SHOW,             // FastLED.show() span
+    EV_COUNT
+};
+
+struct Event {
+    uint32_t ts_us;
+    uint8_t type;
+    uint8_t id;
+    uint16_t arg;
+};
+
+static_assert(sizeof(Event) == 8, "Trace events must stay 8 bytes");
+
+// Recording is off by default so tracing costs nothing until asked for.
+void setEnabled(bool enabled);
+bool isEnabled();
+void clear();
+
+// Current tracer clock in microseconds (micros() on the device).
+uint32_t now();
+
+void recordAt(uint32_t ts_us, EventType type, EventId id, uint16_t arg = 0);
+
+inline void record(EventType type, EventId id, uint16_t arg = 0) {
+    if (isEnabled()) recordAt(now(), type, id, arg);
+}
+inline void begin(EventId id, uint16_t arg = 0) { record(TRACE_BEGIN, id, arg); }
+inline void end(EventId id, uint16_t arg = 0) { record(TRACE_END, id, arg); }
+inline void instant(EventId id, uint16_t arg = 0) { record(TRACE_INSTANT, id, arg); }
+
+// Number of events currently held, and events overwritten since the last clear().
+size_t count();
+uint32_t dropped();
+
+// Returns the i-th oldest event held in the ring. i must be < count().
+const Event& at(size_t i);
+
+const char* eventName(uint8_t id);
+
+// Formats line number `line` of a dump (see format above) into `out`.
+// Returns false once `line` is past the end of the dump.
+bool formatDumpLine(size_t line, char* out, size_t out_len);
+
+} // namespace EventTracer
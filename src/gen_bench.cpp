@@ -0,0 +1,80 @@
+#include "gen_bench.h"
+#include <stdio.h>
+
+namespace GenBench {
+
+// Ascending insertion sort; the sample sets are tiny.
+template <typename T>
+static void sortAscending(T* values, int count) {
+    for (int i = 1; i < count; i++) {
+        T v = values[i];
+        int j = i - 1;
+        while (j >= 0 && values[j] > v) {
+            values[j + 1] = values[j];
+            j--;
+        }
+        values[j + 1] = v;
+    }
+}
+
+void summarize(const Sample* samples, int count, int minutes, Summary* out) {
+    if (count > MAX_SAMPLES) count = MAX_SAMPLES;
+    Summary s = {};
+    s.runs = count;
+    if (count <= 0) {
+        *out = s;
+        return;
+    }
+    uint32_t us[MAX_SAMPLES];
+    uint16_t lines[MAX_SAMPLES];
+    uint32_t bytes[MAX_SAMPLES];
+    s.heapMeasured = true;
+    s.heapDeltaMin = samples[0].heapDelta;
+    for (int i = 0; i < count; i++) {
+        us[i] = samples[i].us;
+        lines[i] = samples[i].lines;
+        bytes[i] = samples[i].bytes;
+        s.dropped += samples[i].dropped;
+        if (!samples[i].heapMeasured) s.heapMeasured = false;
+        if (samples[i].heapDelta < s.heapDeltaMin) s.heapDeltaMin = samples[i].heapDelta;
+        // An exact peak at least as large as every bound is the case's peak.
+        if (i == 0 || samples[i].heapPeak > s.heapPeakMax ||
+            (samples[i].heapPeak == s.heapPeakMax && samples[i].heapPeakExact)) {
+            s.heapPeakMax = samples[i].heapPeak;
+            s.heapPeakExact = samples[i].heapPeakExact;
+        }
+    }
+    sortAscending(us, count);
+    sortAscending(lines, count);
+    sortAscending(bytes, count);
+    s.usMin = us[0];
+    s.usMedian = us[count / 2];
+    s.usMax = us[count - 1];
+    s.linesMin = lines[0];
+    s.linesMedian = lines[count / 2];
+    s.linesP90 = lines[(count * 9) / 10 < count ? (count * 9) / 10 : count - 1];
+    s.linesMax = lines[count - 1];
+    s.bytesMax = bytes[count - 1];
+    s.bytesPerMinute = (minutes > 0) ? bytes[count / 2] / (uint32_t)minutes : 0;
+    s.bytesPerLine = (s.linesMedian > 0) ? bytes[count / 2] / s.linesMedian : 0;
+    *out = s;
+}
+
+int format(const char* name, int minutes, const Summary& s, char* out, size_t len) {
+    char heap[48];
+    if (s.heapMeasured) {
+        snprintf(heap, sizeof(heap), "heap net %+ld B, peak %s%lu B", (long)s.heapDeltaMin,
+                 s.heapPeakExact ? "" : "<=", (unsigned long)s.heapPeakMax);
+    } else {
+        snprintf(heap, sizeof(heap), "heap n/a");
+    }
+    return snprintf(out, len,
+                    "%s %dm x%d: %lu/%lu/%lu us (min/med/max), steps %u/%u/%u/%u (min/med/p90/max), "
+                    "%lu B max, %lu B/min, %lu B/step, %lu dropped, %s",
+                    name, minutes, s.runs, (unsigned long)s.usMin, (unsigned long)s.usMedian, (unsigned long)s.usMax,
+                    (unsigned)s.linesMin, (unsigned)s.linesMedian, (unsigned)s.linesP90, (unsigned)s.linesMax,
+                    (unsigned long)s.bytesMax, (unsigned long)s.bytesPerMinute, (unsigned long)s.bytesPerLine,
+                    (unsigned long)s.dropped, heap);
+}
+
+} // namespace GenBench
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Statistics for the script generator benchmark.
+//
+// The device's gen_bench command and the host harness (src/sim/generator_sim.cpp) run
+// a generator several times per case, one seed per run, and hand the samples here.
+// The summary gives generation time, step counts and script pool use per planned
+// minute, so changes to the generators or the script format can be compared against a
+// recorded baseline. Nothing here allocates or touches Arduino APIs.
+namespace GenBench {
+
+const int MAX_SAMPLES = 16;
+
+struct Sample {
+    uint32_t us;        // Time spent in the generator
+    uint16_t lines;     // Steps generated
+    uint16_t dropped;   // Steps lost to a full script buffer
+    uint32_t bytes;     // Script pool bytes used
+    bool heapMeasured;  // The heap fields below were read (device only; the host leaves them 0)
+    int32_t heapDelta;  // Free heap after minus before
+    uint32_t heapPeak;  // Free heap before minus the low-water mark after
+    bool heapPeakExact; // The run set a new low-water mark; otherwise heapPeak is an upper bound
+};
+
+struct Summary {
+    int runs;
+    uint32_t usMin, usMedian, usMax;
+    uint16_t linesMin, linesMedian, linesP90, linesMax;
+    uint32_t bytesMax;
+    uint32_t bytesPerMinute;  // Median pool bytes / planned minutes
+    uint32_t bytesPerLine;    // Median pool bytes / median lines
+    uint32_t dropped;         // Total over all runs
+    bool heapMeasured;        // Every run measured the heap; otherwise it prints "heap n/a"
+    int32_t heapDeltaMin;     // Largest drop in free heap seen across a run
+    uint32_t heapPeakMax;     // Largest peak heap use of a run
+    bool heapPeakExact;       // heapPeakMax is measured, not an upper bound
+};
+
+// Summarises `count` samples (at most MAX_SAMPLES) of a case lasting `minutes`.
+void summarize(const Sample* samples, int count, int minutes, Summary* out);
+
+// One log line: "<name> <minutes>m x<runs>: ...". Returns the formatted length.
+int format(const char* name, int minutes, const Summary& summary, char* out, size_t len);
+
+} // namespace GenBench
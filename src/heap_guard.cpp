@@ -0,0 +1,75 @@
+#include "heap_guard.h"
+#include <Arduino.h>
+#include <assert.h>
+#include "esp_rom_sys.h"
+
+namespace HeapGuard {
+
+static TaskHandle_t __lockedTask = nullptr;
+static volatile uint32_t __violations = 0;
+static volatile size_t __lastBytes = 0;
+static void* volatile __lastCaller = nullptr;
+static int __exemptDepth = 0;
+static volatile uint32_t __exemptAllocations = 0;
+
+void lockOnCurrentTask() {
+#ifdef HEAP_FREE_STEADY_STATE
+    __lockedTask = xTaskGetCurrentTaskHandle();
+#endif
+}
+
+bool isLocked() { return __lockedTask != nullptr; }
+uint32_t violations() { return __violations; }
+size_t lastViolationBytes() { return __lastBytes; }
+void* lastViolationCaller() { return __lastCaller; }
+uint32_t exemptAllocations() { return __exemptAllocations; }
+
+Exempt::Exempt() { __exemptDepth++; }
+Exempt::~Exempt() { __exemptDepth--; }
+
+#ifdef HEAP_FREE_STEADY_STATE
+// Called from the malloc wrappers below, on whatever task is allocating.
+static void checkAllocation(size_t bytes, void* caller) {
+    if (__lockedTask == nullptr || xTaskGetCurrentTaskHandle() != __lockedTask) return;
+    if (__exemptDepth > 0) {
+        __exemptAllocations++;
+        return;
+    }
+    __violations++;
+    __lastBytes = bytes;
+    __lastCaller = caller;
+    // ROM printf: Serial may itself allocate, and we are inside malloc.
+    esp_rom_printf("HeapGuard: %u byte allocation on the loop task after setup(), caller %p\n",
+                   (unsigned)bytes, caller);
+#ifndef NDEBUG
+    assert(!"heap allocation on the loop task after setup()");
+#endif
+}
+#endif
+
+} // namespace HeapGuard
+
+#ifdef HEAP_FREE_STEADY_STATE
+// Linked with -Wl,--wrap=malloc etc., so every call to malloc() in the image
+// (including operator new, std::string and Arduino's String) lands here first.
+extern "C" {
+void* __real_malloc(size_t size);
+void* __real_calloc(size_t n, size_t size);
+void* __real_realloc(void* ptr, size_t size);
+
+void* __wrap_malloc(size_t size) {
+    HeapGuard::checkAllocation(size, __builtin_return_address(0));
+    return __real_malloc(size);
+}
+
+void* __wrap_calloc(size_t n, size_t size) {
+    HeapGuard::checkAllocation(n * size, __builtin_return_address(0));
+    return __real_calloc(n, size);
+}
+
+void* __wrap_realloc(void* ptr, size_t size) {
+    HeapGuard::checkAllocation(size, __builtin_return_address(0));
+    return __real_realloc(ptr, size);
+}
+}
+#endif
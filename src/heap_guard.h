@@ -0,0 +1,39 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Enforces a heap-free steady state on the loop task.
+//
+// Every run-time buffer (script storage, command queue, effect state, trace ring) is
+// statically sized, so once setup() has finished the loop task should never touch the
+// heap. In builds with -DHEAP_FREE_STEADY_STATE (the m5stack-atoms3-heap-free env)
+// malloc, calloc and realloc are wrapped at link time; after lockOnCurrentTask() any
+// allocation made from the locked task is counted and, unless NDEBUG is defined,
+// trips an assertion naming the size and caller. Allocations on other tasks (the BLE
+// stack, WiFi, timers) are not affected. Direct heap_caps_malloc() calls (DMA buffers)
+// bypass malloc and are not seen.
+//
+// In other builds these functions are no-ops, apart from the counters reading zero.
+namespace HeapGuard {
+
+// Locks the calling task. Call once, at the end of setup().
+void lockOnCurrentTask();
+bool isLocked();
+
+// Allocations made by the locked task since lockOnCurrentTask().
+uint32_t violations();
+// Size and return address of the most recent one.
+size_t lastViolationBytes();
+void* lastViolationCaller();
+
+// Allocations inside a library call we cannot avoid (e.g. the BLE stack copying a
+// notify value) are let through while one of these is in scope, and counted separately.
+class Exempt {
+public:
+    Exempt();
+    ~Exempt();
+};
+uint32_t exemptAllocations();
+
+} // namespace HeapGuard
@@ -0,0 +1,273 @@
+#include "lcd_dashboard.h"
+#include <M5GFX.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+namespace LcdDashboard {
+
+// --- Layout ---
+// One region per line of text. The speed line uses a larger font.
+enum RegionId {
+    REGION_SPEED,
+    REGION_DIRECTION,
+    REGION_EFFECT,
+    REGION_PHASE,
+    REGION_HOLD,
+    REGION_FPS,
+    REGION_HEAP,
+    REGION_COUNT
+};
+
+struct Region {
+    int16_t y;
+    int16_t h;
+    const lgfx::IFont* font;
+    uint16_t color;
+};
+
+static const int __WIDTH = 128;
+static const int __MAX_REGION_HEIGHT = 26;
+
+static const Region __regions[REGION_COUNT] = {
+    {   0, 26, &lgfx::fonts::Font4, TFT_WHITE },
+    {  26, 16, &lgfx::fonts::Font2, TFT_GREEN },
+    {  42, 16, &lgfx::fonts::Font2, TFT_CYAN },
+    {  58, 16, &lgfx::fonts::Font2, TFT_YELLOW },
+    {  74, 16, &lgfx::fonts::Font2, TFT_ORANGE },
+    {  90, 16, &lgfx::fonts::Font2, TFT_DARKGREY },
+    { 106, 16, &lgfx::fonts::Font2, TFT_DARKGREY },
+};
+
+// --- State ---
+static M5GFX* __display = nullptr;
+static M5Canvas __sprites[2];
+static int __nextSprite = 0;
+static Mode __mode = MODE_DASHBOARD;
+static bool __forceRedraw = true;
+static uint32_t __lastUpdateMs = 0;
+static char __shownText[REGION_COUNT][24];
+static Stats __stats = {};
+
+// --- Preview State ---
+// Screen position of each preview point, laid out once by setStripGeometry().
+static uint8_t __pointX[PREVIEW_MAX_POINTS];
+static uint8_t __pointY[PREVIEW_MAX_POINTS];
+static bool __pointIsBack[PREVIEW_MAX_POINTS]; // Far side of the helix; drawn dimmer
+static int __numPoints = 0;
+static int __ledsPerPoint = 1;
+// Downsampled copy of the last submitted frame, and what is currently on screen.
+static uint8_t __snapshot[PREVIEW_MAX_POINTS * 3];
+static bool __snapshotReady = false;
+static uint32_t __snapshotCopyUs = 0;
+static uint32_t __lastSnapshotMs = 0;
+static uint16_t __shownPointColor[PREVIEW_MAX_POINTS];
+static const int __POINT_SIZE = 3;
+
+void begin(M5GFX& display) {
+    __display = &display;
+    __display->setRotation(0);
+    __display->fillScreen(TFT_BLACK);
+    for (int i = 0; i < 2; i++) {
+        __sprites[i].setColorDepth(16);
+        __sprites[i].createSprite(__WIDTH, __MAX_REGION_HEIGHT);
+    }
+    invalidate();
+}
+
+void setMode(Mode mode) {
+    __mode = mode;
+    __snapshotReady = false;
+    if (__display == nullptr) return;
+    __display->waitDMA();
+    __display->fillScreen(TFT_BLACK);
+    __display->setBrightness(mode == MODE_OFF ? 0 : 128);
+    invalidate();
+}
+
+Mode mode() { return __mode; }
+
+void invalidate() {
+    __forceRedraw = true;
+    // A preview redraw is forced by forgetting what is on screen.
+    memset(__shownPointColor, 0, sizeof(__shownPointColor));
+}
+
+void setStripGeometry(int numLeds, int logicalNumLeds) {
+    if (numLeds <= 0 || logicalNumLeds < numLeds) return;
+    __ledsPerPoint = (numLeds + PREVIEW_MAX_POINTS - 1) / PREVIEW_MAX_POINTS;
+    __numPoints = (numLeds + __ledsPerPoint - 1) / __ledsPerPoint;
+
+    // The strip runs up the outer helix and back down the inner one, three turns
+    // around the loop. Project it side-on: x follows cos(angle), y follows height.
+    const float TURNS = 3.0f;
+    const float OUTER_RADIUS = 56.0f;
+    const float INNER_RADIUS = 36.0f;
+    const float TOP = 6.0f;
+    const float BOTTOM = 121.0f;
+    for (int p = 0; p < __numPoints; p++) {
+        float led = (float)(p * __ledsPerPoint) + (__ledsPerPoint - 1) * 0.5f;
+        float t = led / (float)logicalNumLeds; // 0..1 around the closed loop
+        float angle = t * TURNS * 2.0f * (float)M_PI;
+        bool ascending = t < 0.5f;
+        float height = ascending ? (t * 2.0f) : (2.0f - t * 2.0f);
+        float radius = ascending ? OUTER_RADIUS : INNER_RADIUS;
+        __pointX[p] = (uint8_t)(64.0f + radius * cosf(angle) - __POINT_SIZE / 2);
+        __pointY[p] = (uint8_t)(BOTTOM - height * (BOTTOM - TOP) - __POINT_SIZE / 2);
+        __pointIsBack[p] = sinf(angle) < 0.0f;
+    }
+    invalidate();
+}
+
+void submitFrame(const uint8_t* rgb, int numLeds, uint32_t now_ms) {
+    if (__mode != MODE_PREVIEW || __numPoints == 0) return;
+    if ((now_ms - __lastSnapshotMs) < PREVIEW_INTERVAL_MS) return;
+    __lastSnapshotMs = now_ms;
+
+    uint32_t start = lgfx::micros();
+    for (int p = 0; p < __numPoints; p++) {
+        int first = p * __ledsPerPoint;
+        int last = first + __ledsPerPoint;
+        if (last > numLeds) last = numLeds;
+        uint16_t sum[3] = { 0, 0, 0 };
+        for (int i = first; i < last; i++) {
+            sum[0] += rgb[i * 3];
+            sum[1] += rgb[i * 3 + 1];
+            sum[2] += rgb[i * 3 + 2];
+        }
+        int n = (last > first) ? (last - first) : 1;
+        __snapshot[p * 3] = (uint8_t)(sum[0] / n);
+        __snapshot[p * 3 + 1] = (uint8_t)(sum[1] / n);
+        __snapshot[p * 3 + 2] = (uint8_t)(sum[2] / n);
+    }
+    __snapshotReady = true;
+    __snapshotCopyUs = lgfx::micros() - start;
+}
+
+static void formatRegion(RegionId id, const Status& s, char* out, size_t len) {
+    switch (id) {
+        case REGION_SPEED:
+            if (s.currentSpeed == s.speedSetting || !s.motorRunning) snprintf(out, len, "%d", s.currentSpeed);
+            else snprintf(out, len, "%d>%d", s.currentSpeed, s.speedSetting);
+            break;
+        case REGION_DIRECTION:
+            snprintf(out, len, "%s %s", s.clockwise ? "CW" : "CCW", s.motorRunning ? "running" : "stopped");
+            break;
+        case REGION_EFFECT:
+            snprintf(out, len, "FX %s", s.effectName);
+            break;
+        case REGION_PHASE:
+            snprintf(out, len, "%s", (s.phaseName && s.phaseName[0]) ? s.phaseName : "no script");
+            break;
+        case REGION_HOLD: {
+            // Tenths of a second are enough; finer resolution would redraw every refresh.
+            // The script ETA is shown in whole minutes once it is over a minute away.
+            char eta[12] = "";
+            if (s.scriptRemainingMs >= 0) {
+                long etaS = s.scriptRemainingMs / 1000;
+                if (etaS >= 60) snprintf(eta, sizeof(eta), " ETA %ldm", (etaS + 59) / 60);
+                else snprintf(eta, sizeof(eta), " ETA %lds", etaS);
+            }
+            if (s.holdRemainingMs >= 0) snprintf(out, len, "H %ld.%lds%s", s.holdRemainingMs / 1000, (s.holdRemainingMs / 100) % 10, eta);
+            else snprintf(out, len, "HOLD -%s", eta);
+            break;
+        }
+        case REGION_FPS:
+            snprintf(out, len, "LOOP %u/s", (unsigned)s.loopFps);
+            break;
+        case REGION_HEAP:
+            snprintf(out, len, "HEAP %luk", (unsigned long)(s.freeHeap / 1024));
+            break;
+        default:
+            out[0] = '\0';
+            break;
+    }
+}
+
+static void pushRegion(RegionId id, const char* text) {
+    const Region& r = __regions[id];
+    M5Canvas& sprite = __sprites[__nextSprite];
+    __nextSprite ^= 1;
+
+    // Drawing into this sprite overlaps with the DMA transfer of the other one.
+    // Wait only before starting the next transfer, which needs the bus.
+    sprite.fillSprite(TFT_BLACK);
+    sprite.setFont(r.font);
+    sprite.setTextColor(r.color, TFT_BLACK);
+    sprite.setTextDatum(lgfx::middle_left);
+    sprite.drawString(text, 2, r.h / 2);
+    __display->waitDMA();
+    __display->pushImageDMA(0, r.y, __WIDTH, r.h, (const lgfx::swap565_t*)sprite.getBuffer());
+}
+
+static bool updatePreview() {
+    if (!__snapshotReady) return false;
+    __snapshotReady = false;
+
+    uint32_t start = lgfx::micros();
+    bool writing = false;
+    for (int p = 0; p < __numPoints; p++) {
+        uint8_t r = __snapshot[p * 3];
+        uint8_t g = __snapshot[p * 3 + 1];
+        uint8_t b = __snapshot[p * 3 + 2];
+        if (__pointIsBack[p]) { r >>= 1; g >>= 1; b >>= 1; }
+        // Bit 0 of blue is forced on so black points still differ from "never drawn".
+        uint16_t color = (uint16_t)(((r & 0xF8) << 8) | ((g & 0xFC) << 3) | (b >> 3) | 1);
+        if (color == __shownPointColor[p]) continue;
+        if (!writing) {
+            __display->startWrite();
+            writing = true;
+        }
+        __display->fillRect(__pointX[p], __pointY[p], __POINT_SIZE, __POINT_SIZE, color);
+        __shownPointColor[p] = color;
+        __stats.previewPointsDrawn++;
+    }
+    if (writing) __display->endWrite();
+
+    uint32_t elapsed = (lgfx::micros() - start) + __snapshotCopyUs;
+    __stats.previewFrames++;
+    __stats.avgPreviewUs = (__stats.previewFrames == 1) ? elapsed : (__stats.avgPreviewUs * 7 + elapsed) / 8;
+    if (elapsed > __stats.maxPreviewUs) __stats.maxPreviewUs = elapsed;
+    return true;
+}
+
+bool update(const Status& status, uint32_t now_ms) {
+    if (__mode == MODE_OFF || __display == nullptr) return false;
+    if (__mode == MODE_PREVIEW) return updatePreview();
+    if (!__forceRedraw && (now_ms - __lastUpdateMs) < UPDATE_INTERVAL_MS) return false;
+    __lastUpdateMs = now_ms;
+
+    uint32_t start = lgfx::micros();
+    char text[24];
+    bool writing = false;
+    for (int i = 0; i < REGION_COUNT; i++) {
+        formatRegion((RegionId)i, status, text, sizeof(text));
+        if (!__forceRedraw && strcmp(text, __shownText[i]) == 0) continue;
+        if (!writing) {
+            __display->startWrite();
+            writing = true;
+        }
+        pushRegion((RegionId)i, text);
+        strncpy(__shownText[i], text, sizeof(__shownText[i]) - 1);
+        __shownText[i][sizeof(__shownText[i]) - 1] = '\0';
+        __stats.regionsPushed++;
+    }
+    // endWrite() completes the last outstanding transfer before releasing the bus.
+    if (writing) __display->endWrite();
+    __forceRedraw = false;
+
+    uint32_t elapsed = lgfx::micros() - start;
+    __stats.refreshes++;
+    __stats.lastRefreshUs = elapsed;
+    __stats.avgRefreshUs = (__stats.refreshes == 1) ? elapsed : (__stats.avgRefreshUs * 7 + elapsed) / 8;
+    if (elapsed > __stats.maxRefreshUs) __stats.maxRefreshUs = elapsed;
+    return true;
+}
+
+const Stats& stats() { return __stats; }
+
+void resetStats() {
+    __stats = Stats();
+}
+
+} // namespace LcdDashboard
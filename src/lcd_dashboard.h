@@ -0,0 +1,88 @@
+#pragma once
+
+#include <stdint.h>
+
+class M5GFX;
+
+// Status dashboard for the AtomS3's 128x128 LCD.
+//
+// The screen is split into fixed text regions. Each update formats every region's
+// text, and only regions whose text changed are redrawn into a small sprite and
+// pushed to the panel by DMA. Two sprites are used ping-pong so one can be drawn
+// while the previous one is still transferring.
+//
+// An optional preview mode instead draws a downsampled copy of the finished LED frame
+// folded onto a side view of the helix, so the renderer's output can be seen when the
+// sculpture is out of sight or the strip is blacked out.
+//
+// This module depends only on M5GFX (no Arduino or M5Unified), so it also builds
+// against M5GFX's SDL backend on a Linux host (see the native_sdl env and src/sim/).
+namespace LcdDashboard {
+
+// A snapshot of everything the dashboard shows. Filled in by the caller each update.
+struct Status {
+    int currentSpeed;          // Actual logical motor speed
+    int speedSetting;          // Requested logical motor speed
+    bool clockwise;
+    bool motorRunning;
+    const char* effectName;
+    const char* phaseName;     // Current script phase, or "" if no script is running
+    long holdRemainingMs;      // Remaining script hold, or -1 if not holding
+    long scriptRemainingMs;    // Planned time left in the script, or -1 if none is running
+    uint16_t loopFps;          // loop() iterations per second
+    uint32_t freeHeap;         // Bytes
+};
+
+enum Mode {
+    MODE_OFF,
+    MODE_DASHBOARD,
+    MODE_PREVIEW
+};
+
+// Minimum time between dashboard refreshes.
+const uint32_t UPDATE_INTERVAL_MS = 100;
+// Minimum time between preview frames.
+const uint32_t PREVIEW_INTERVAL_MS = 50;
+// Longer strips are averaged down to this many preview points.
+const int PREVIEW_MAX_POINTS = 256;
+
+void begin(M5GFX& display);
+
+// Switches what the panel shows. MODE_OFF also turns the backlight off.
+void setMode(Mode mode);
+Mode mode();
+inline bool isEnabled() { return mode() != MODE_OFF; }
+
+// Lays out the helix projection for a strip of `numLeds` physical LEDs on a loop of
+// `logicalNumLeds` positions (physical LEDs plus the virtual gap).
+void setStripGeometry(int numLeds, int logicalNumLeds);
+
+// Offers a finished frame (RGB triplets) to the preview. In preview mode, at most once
+// per PREVIEW_INTERVAL_MS the frame is averaged down into a private snapshot; drawing
+// happens later from that snapshot, so the caller's buffer is never held.
+void submitFrame(const uint8_t* rgb, int numLeds, uint32_t now_ms);
+
+// Redraws whatever the current mode needs: changed dashboard regions (if
+// UPDATE_INTERVAL_MS has passed) or changed preview points (if a new snapshot is
+// waiting). Returns true if anything was drawn.
+bool update(const Status& status, uint32_t now_ms);
+
+// Forces every region to be redrawn on the next refresh.
+void invalidate();
+
+// --- Cost Statistics ---
+struct Stats {
+    uint32_t refreshes;        // Refreshes that ran
+    uint32_t regionsPushed;    // Regions redrawn and pushed
+    uint32_t lastRefreshUs;    // CPU time of the last refresh
+    uint32_t avgRefreshUs;     // Exponential moving average of refresh CPU time
+    uint32_t maxRefreshUs;
+    uint32_t previewFrames;    // Preview snapshots drawn
+    uint32_t previewPointsDrawn;
+    uint32_t avgPreviewUs;     // Moving average of snapshot copy + draw CPU time per frame
+    uint32_t maxPreviewUs;
+};
+const Stats& stats();
+void resetStats();
+
+} // namespace LcdDashboard
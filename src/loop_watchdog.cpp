@@ -0,0 +1,142 @@
+#include "loop_watchdog.h"
+#include <stdio.h>
+#include <string.h>
+#if defined(ARDUINO)
+#include <esp_attr.h>
+#else
+#define RTC_NOINIT_ATTR
+#endif
+
+namespace LoopWatchdog {
+
+static const uint32_t __MAGIC = 0x57444F31; // "WDO1"
+
+// Survives resets other than power loss. Validated by the magic number at boot.
+struct Retained {
+    uint32_t magic;
+    uint32_t boots;
+    uint32_t overruns;
+    int head;
+    int count;
+    Overrun ring[RING_CAPACITY];
+};
+static RTC_NOINIT_ATTR Retained __retained;
+
+static const char* const __stageNames[STAGE_COUNT] = {
+    "input", "commands", "script", "render", "motor", "buttons", "diagnostics"
+};
+
+static uint32_t __budgetUs = DEFAULT_BUDGET_US;
+static uint32_t __passes = 0;
+static uint32_t __overruns = 0;
+static uint32_t __stageOverruns[STAGE_COUNT];
+static uint32_t __maxPassUs = 0;
+
+// The pass in progress.
+static bool __inPass = false;
+static uint32_t __passStartUs = 0;
+static uint32_t __stageStartUs = 0;
+static uint8_t __stage = STAGE_INPUT;
+static uint32_t __stageUs[STAGE_COUNT];
+static char __work[CONTEXT_LEN];
+static uint32_t __workUs = 0;
+
+void begin() {
+    if (__retained.magic != __MAGIC || __retained.head < 0 || __retained.head >= RING_CAPACITY ||
+        __retained.count < 0 || __retained.count > RING_CAPACITY) {
+        memset(&__retained, 0, sizeof(__retained));
+        __retained.magic = __MAGIC;
+    }
+    __retained.boots++;
+}
+
+uint32_t bootCount() { return __retained.boots; }
+
+void setBudgetUs(uint32_t budgetUs) { __budgetUs = budgetUs; }
+uint32_t budgetUs() { return __budgetUs; }
+
+void beginPass(uint32_t nowUs, uint32_t nowMs) {
+    if (__inPass) endPass(nowUs, nowMs, -1); // The previous pass returned early
+    __inPass = true;
+    __passStartUs = __stageStartUs = nowUs;
+    __stage = STAGE_INPUT;
+    memset(__stageUs, 0, sizeof(__stageUs));
+    __work[0] = '\0';
+    __workUs = 0;
+}
+
+void enterStage(Stage stage, uint32_t nowUs) {
+    __stageUs[__stage] += nowUs - __stageStartUs;
+    __stageStartUs = nowUs;
+    __stage = stage;
+}
+
+void noteWork(const char* what, uint32_t us) {
+    if (!__inPass || us < __workUs) return;
+    __workUs = us;
+    strncpy(__work, what, CONTEXT_LEN - 1);
+    __work[CONTEXT_LEN - 1] = '\0';
+}
+
+void endPass(uint32_t nowUs, uint32_t nowMs, int step) {
+    if (!__inPass) return;
+    __inPass = false;
+    enterStage((Stage)__stage, nowUs);
+    uint32_t passUs = nowUs - __passStartUs;
+    __passes++;
+    if (passUs > __maxPassUs) __maxPassUs = passUs;
+    if (passUs <= __budgetUs) return;
+
+    uint8_t worst = 0;
+    for (uint8_t s = 1; s < STAGE_COUNT; s++) {
+        if (__stageUs[s] > __stageUs[worst]) worst = s;
+    }
+    __overruns++;
+    __stageOverruns[worst]++;
+    __retained.overruns++;
+
+    Overrun& o = __retained.ring[__retained.head];
+    o.boot = __retained.boots;
+    o.uptimeMs = nowMs;
+    o.passUs = passUs;
+    o.stageUs = __stageUs[worst];
+    o.step = (int16_t)step;
+    o.stage = worst;
+    memcpy(o.context, __work, CONTEXT_LEN);
+    __retained.head = (__retained.head + 1) % RING_CAPACITY;
+    if (__retained.count < RING_CAPACITY) __retained.count++;
+}
+
+uint32_t passes() { return __passes; }
+uint32_t overruns() { return __overruns; }
+uint32_t stageOverruns(Stage stage) { return __stageOverruns[stage]; }
+uint32_t maxPassUs() { return __maxPassUs; }
+uint32_t retainedOverruns() { return __retained.overruns; }
+
+int count() { return __retained.count; }
+
+const Overrun& at(int index) {
+    int oldest = (__retained.head - __retained.count + RING_CAPACITY) % RING_CAPACITY;
+    return __retained.ring[(oldest + index) % RING_CAPACITY];
+}
+
+void clear() {
+    __retained.head = 0;
+    __retained.count = 0;
+    __retained.overruns = 0;
+    __overruns = 0;
+    __maxPassUs = 0;
+    memset(__stageOverruns, 0, sizeof(__stageOverruns));
+}
+
+const char* stageName(uint8_t stage) {
+    return (stage < STAGE_COUNT) ? __stageNames[stage] : "?";
+}
+
+int formatOverrun(const Overrun& o, char* out, size_t len) {
+    return snprintf(out, len, "WDO %lu %lu %lu %s %lu %d %s", (unsigned long)o.boot, (unsigned long)o.uptimeMs,
+                    (unsigned long)o.passUs, stageName(o.stage), (unsigned long)o.stageUs, o.step,
+                    o.context[0] ? o.context : "-");
+}
+
+} // namespace LoopWatchdog
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Loop overrun watchdog.
+//
+// loop() marks the start of each stage it runs through. Each pass is timed against a
+// budget. A pass that goes over it is an overrun and is recorded with:
+//   - the stage that took longest;
+//   - the slowest piece of work noted during the pass (a command or script step,
+//     or a script generation);
+//   - the script step being played;
+//   - the uptime.
+// The last RING_CAPACITY overruns are kept in RTC memory that is not cleared on
+// reset, so they can still be read after a crash, a watchdog reset or a brown-out
+// reboot. A power cycle clears them.
+//
+// Only the loop task may call these functions. Times are in microseconds from
+// EventTracer::now() (or any free-running counter); the module itself has no Arduino
+// dependencies.
+namespace LoopWatchdog {
+
+enum Stage : uint8_t {
+    STAGE_INPUT,       // M5.update()
+    STAGE_COMMANDS,    // BLE command handling
+    STAGE_SCRIPT,      // Script engine, including generation at rollover
+    STAGE_RENDER,      // Effect rendering and show()
+    STAGE_MOTOR,       // Motor ramp state machine
+    STAGE_BUTTONS,
+    STAGE_DIAGNOSTICS, // The incremental service*() calls
+    STAGE_COUNT
+};
+
+const int RING_CAPACITY = 16;
+const size_t CONTEXT_LEN = 40;
+const uint32_t DEFAULT_BUDGET_US = 15000; // About one frame at the strip's fastest rate
+// Long enough for an overrun or summary line.
+const size_t MAX_LINE_LEN = 96;
+
+struct Overrun {
+    uint32_t boot;       // Boot number it happened in (see bootCount())
+    uint32_t uptimeMs;
+    uint32_t passUs;
+    uint32_t stageUs;    // Time in the slowest stage
+    int16_t step;        // Script step being played, or -1
+    uint8_t stage;       // Stage
+    char context[CONTEXT_LEN];
+};
+
+// Call once from setup(). Keeps a ring that survived a reset and counts the boot.
+void begin();
+uint32_t bootCount();
+
+void setBudgetUs(uint32_t budgetUs);
+uint32_t budgetUs();
+
+// `nowMs` is uptime (millis()), recorded with an overrun.
+void beginPass(uint32_t nowUs, uint32_t nowMs);
+void enterStage(Stage stage, uint32_t nowUs);
+// Notes a piece of work (command text or similar) that took `us`. The slowest one of
+// the pass becomes the context of an overrun.
+void noteWork(const char* what, uint32_t us);
+// Ends the pass. `step` is the script step being played, or -1.
+void endPass(uint32_t nowUs, uint32_t nowMs, int step);
+
+// Since boot.
+uint32_t passes();
+uint32_t overruns();
+uint32_t stageOverruns(Stage stage);
+uint32_t maxPassUs();
+// Across resets (until power is lost or clear() is called).
+uint32_t retainedOverruns();
+
+// Overruns in the ring, oldest first.
+int count();
+const Overrun& at(int index);
+void clear();
+
+const char* stageName(uint8_t stage);
+// "WDO <boot> <uptime_ms> <pass_us> <stage> <stage_us> <step> <context>"
+int formatOverrun(const Overrun& o, char* out, size_t len);
+
+} // namespace LoopWatchdog
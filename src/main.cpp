@@ -8,11 +8,32 @@
 #include <BLEDevice.h>
 #include <BLEServer.h>
 #include <BLEUtils.h>
+#include <BLE2902.h>
 #include <stdarg.h>
+#include "esp_heap_caps.h"
 #include "shared.h"
 #include "auto_generator.h"
-#include <vector>
-#include <string>
+#include "event_tracer.h"
+#include "lcd_dashboard.h"
+#include "effect_state.h"
+#include "script_buffer.h"
+#include "command_parser.h"
+#include "command_queue.h"
+#include "command_router.h"
+#include "command_ack.h"
+#include "command_limits.h"
+#include "heap_guard.h"
+#include "script_timeline.h"
+#include "gen_bench.h"
+#include "parallel_render.h"
+#include "power_budget.h"
+#include "show_checkpoint.h"
+#include "loop_watchdog.h"
+#include "sys_stats.h"
+#include "particle_system.h"
+#include "strip_render.h"
+#include <LittleFS.h>
+#include <new>
 
 /*
  * --- Bluetooth Command Reference ---
@@ -25,6 +46,11 @@
  * led_display_brightness:XX - Set scene/display brightness percentage (0-100). This is scaled by the global master brightness.
  * led_background:H,B - Set background Hue (0-255) and Brightness % (0-50). Example: "led_background:160,20"
  * led_tails:H,L,C    - Set Comet Hue (0-255), Tail Length (LEDs), and Count. Example: "led_tails:0,15,3"
+ * led_comet_group:G,C,L,H,S,D - Comet group G (1-3) alongside led_tails' comets: C comets (0 = off) with
+ *                      L-LED tails, moving at S% of motor sync (0-800) in direction D (1 = with the
+ *                      comets, -1 = against). H is a hue (0-255), "shared" (follows the comet hue and
+ *                      its rainbow/sine modes) or "+N"/"-N" (that far from it). Example:
+ *                      "led_comet_group:1,2,8,+128,50,-1". led_reset and system_reset clear the groups.
  * led_cycle_time:MS  - Set absolute time (ms) for one full LED revolution. Example: "led_cycle_time:5000"
  * system_off         - Ramp down motor and blackout LEDs immediately.
  * motor_start        - Start the motor using current speed settings.
@@ -39,32 +65,106 @@
  * run_script:NAME    - Start a named script (e.g., "run_script:funky").
  * auto_mode:MMM      - Generate and run a script for MMM minutes.
  * auto_steady_rotate:MMM - Generate and run a steady rotation script for MMM minutes.
- * auto_mode_debug:MMM - Generate and print a script for MMM minutes without running.
+ *                      Both shows are checkpointed to NVS and resume at their position after a
+ *                      power loss or reset. Stopping the show (motor_stop, system_off, ...) clears it.
+ * auto_mode_debug:MMM - Generate and print a script for MMM minutes without running (printed as by
+ *                      script_dump:serial).
+ * gen_bench[:N]      - Benchmark both generators over several durations with N seeds each (default 5,
+ *                      max 16): time, steps, script bytes per minute, net heap change and peak heap
+ *                      use (from the heap low-water mark; "<=" when no run went below the earlier
+ *                      mark). Not while a script runs; it overwrites the script buffer.
+ * render_split:MODE  - Split noise, fire, comet and marquee pixel work across both cores (on, default) or not (off).
+ *                      Splitting switches itself off if the other core stalls; on turns it back on.
+ * render_bench       - Time those stages serially (also as ns per pixel) and split at 198, 1024 and 4096 LEDs.
+ * particle_bench     - Time a particle frame (update and render) at 10, 100 and 1000 particles.
+ *                      Not while the particles effect runs; it uses the same particle pool.
+ * auto_templates     - Log where auto_mode's phase templates came from and their phases.
+ * auto_templates:reload - Re-read /phases.txt from LittleFS (built-in templates if absent or invalid).
  * hold:XXXX          - (Script only) Wait XXXX ms before next command.
  * [comment]          - (Script only, internal) A comment line, logged to terminal and ignored.
- * led_blink:H,B,U,D,C - Pulse Hue (0-255), Brightness % (0-100), Ramp Up (ms), Ramp Down (ms), Count (0=loop).
+ * led_blink:H,B,U,D,C[,EASE] - Pulse Hue (0-255), Brightness % (0-100), Ramp Up (ms), Ramp Down (ms), Count (0=loop).
+ *                      EASE shapes the ramps: quadratic (default, as before), linear or gamma (even to the eye).
  * led_sine_hue:L,H   - Oscillate Comet Hue between L and H (0-255) synced to motor speed.
  * led_rainbow        - Cycle Comet Hue through full rainbow synced to motor speed.
  * led_sine_pulse:L,H - Oscillate Display Brightness between L and H % (0-100) synced to motor speed. Scaled by Global Master Brightness.
  * led_effect:NAME,P1.. - Activate a full-strip effect (e.g., 'fire', 'noise', 'marquee', 'twinkle'). Replaces comet tails.
+ *                      led_effect:particles,FADE shows particles along the helix, added onto the last
+ *                      frame faded by FADE (0-255, default 64). The commands below switch to it.
+ * led_emitter:S,P,R,V,SP,H,L - Particle emitter S (0-3) at LED P: R particles/s moving at V LEDs/s
+ *                      (+/- SP), hue H, life L ms. R=0 turns it off.
+ * led_gravity:G      - Particle acceleration along the height in LEDs/s^2; negative falls toward LED 0.
+ *                      With gravity, particles leaving either end die instead of wrapping round.
+ * led_burst:P,N,V,H,L - Add N particles at LED P with random speeds up to V LEDs/s either way, hue H,
+ *                      life L ms.
  * led_reset          - Clear all dynamic effects, background, and comets to black.
+ * script_dump:TARGET - Export the loaded script a few lines per loop pass. TARGET is serial, file
+ *                      (/script.txt on LittleFS) or off (stop a dump in progress). A serial dump
+ *                      gives up after 3 s with nothing read from the port.
+ * loop_watchdog      - Log loop overrun counts (per stage) and the retained overruns, which survive
+ *                      resets other than power loss, and notify "WDG <passes> <overruns> <retained>
+ *                      <max_pass_us> <budget_us> <boot>". loop_watchdog:ble notifies each retained
+ *                      overrun as "WDO <boot> <uptime_ms> <pass_us> <stage> <stage_us> <step> <context>",
+ *                      then "WDO end". loop_watchdog:clear forgets them.
+ * sys_stats          - Log every FreeRTOS task (core, priority, least free stack, CPU use since the
+ *                      last sys_stats) and notify "SYS <uptime_s> <heap_free> <heap_min> <heap_largest>
+ *                      <cpu0_permille> <cpu1_permille> <loop_stack_free> <tasks> <collect_us>".
+ *                      sys_stats:ble also notifies "TSK <name> <core> <prio> <stack_free> <cpu_permille>"
+ *                      per task. CPU use reads -1 on the first call.
+ * loop_budget:US     - Loop pass budget in microseconds (default 15000); longer passes are overruns.
+ * trace:ACTION       - Event tracer control. ACTION is on, off, clear, dump (Serial) or dump_ble (Status notify).
+ *                      Convert a dump to Chrome/Perfetto JSON with tools/trace_to_chrome.py.
+ * lcd:MODE           - LCD view. MODE is dashboard (status), preview (live strip on the helix) or off.
+ * lcd_stats          - Log the LCD dashboard and preview refresh counts and CPU cost.
+ * heap_guard         - Log heap use and any loop-task allocations seen after setup() (heap-free build).
+ * router_status      - Log active parameter overrides, deferred commands, recent routing decisions
+ *                      and per-parameter coalescing counts (then resets the counts).
+ * power_status       - Notify (Status) and log strip current: "PWR <last_mA> <avg10_mA> <avg60_mA>
+ *                      <peak60_mA> <limited10_%> <limited60_%> <cut60_%> <budget_mA>". Averages are
+ *                      per frame over the last 10 s and 60 s; peak is the highest requested frame.
+ * clear_overrides    - Drop all parameter overrides so the running script controls them again.
+ * script_pause       - Freeze the running script on its current scene (motor and LEDs keep running).
+ * script_resume      - Continue a paused script where it left off.
+ * script_seek:SSS    - Jump the running script to SSS seconds of planned script time.
+ * script_next        - Jump to the start of the next phase (the next "[...]" marker line).
+ * script_prev        - Restart the current phase, or go to the previous one if just started.
+ * script_status      - Log the step, phase, elapsed time and planned time left, and notify
+ *                      "SCRIPT STATE STEP/STEPS POS_S/PLANNED_S ELAPSED_S PHASE" on the Status
+ *                      characteristic. Planned time counts holds plus estimated ramps and blinks.
+ *
+ * Any BLE command may be prefixed with "#SEQ " (e.g. "#17 motor_speed:500"). The device then
+ * notifies "ACK SEQ RESULT RECV_TO_APPLY_US APPLY_TO_FRAME_US" on the Status characteristic,
+ * where RESULT is applied, invalid, ignored, superseded or deferred (followed later by a
+ * final ACK). See command_ack.h.
+ *
+ * While a script is running, BLE commands are routed by lane (see command_router.h):
+ * show control (system_off, system_reset, motor_stop, run_script, auto_mode, auto_steady_rotate)
+ * stops the script and applies at once; parameter tweaks (brightness, motor speed/ramp, cycle
+ * time, background) apply at once and override the script's own writes to that parameter
+ * until the next scene (phase marker, script end or regeneration), which takes it back;
+ * other look changes (effects, tails, reverse, ...) are deferred to the next scene boundary;
+ * hold, gen_bench and the *_debug generators are rejected.
+ *
+ * Absolute parameter setters from BLE (brightness, motor_speed, motor_ramp, led_cycle_time,
+ * led_background) are coalesced: during a slider drag only the newest value per parameter is
+ * applied, at most once every 40 ms. Any other command applies a staged value first, so
+ * commands still take effect in the order they were sent.
  */
 
+// Hardware values (pins, PWM limits, strip length, speed sync table) come from the
+// sculpture variant selected at build time. See sculpture_config.h.
+
 // Atomic H-Driver Pin Definitions
-static const int __IN1_PIN = 6;
-static const int __IN2_PIN = 7;
+static const int __IN1_PIN = Sculpture::MOTOR_IN1_PIN;
+static const int __IN2_PIN = Sculpture::MOTOR_IN2_PIN;
 
 // PWM Settings
-static const int __freq = 25000;
-static const int __resolution = 10; // 0-1023
+static const int __freq = Sculpture::PWM_FREQ;
+static const int __resolution = Sculpture::PWM_RESOLUTION;
 static const int __ledChannel1 = 0;
 static const int __ledChannel2 = 1;
 
 // Speed Control Settings
-static const int __PHYSICAL_MAX_SPEED = 900; // The PWM duty cycle for maximum speed
-static const int __PHYSICAL_MIN_SPEED = 500; // The PWM duty cycle to overcome friction and start moving
-
-static const int __LOGICAL_MAX_SPEED = 1000; // A linear scale for speed control
+static const int __LOGICAL_MAX_SPEED = LOGICAL_MAX_SPEED; // A linear scale for speed control
 static const int __LOGICAL_SPEED_INCREMENT = 50;
 static const int __LOGICAL_INITIAL_SPEED = 600; // The default logical speed
 static const int __LOGICAL_REVERSE_INTERMEDIATE_SPEED = 200; // The speed to ramp down to during a reversal
@@ -74,12 +174,12 @@ static const int __RAMP_STEP = 5;            // How much to change speed in each
 static int __currentRampDuration = DEFAULT_RAMP_DURATION_MS; // Variable to change ramp duration (in milliseconds)
 
 // --- LED Strip Settings ---
-static const int __ONBOARD_LED_PIN = 35;
-static const int __LED_STRIP_PIN = 2;  // Grove Port Pin (Yellow wire) on AtomS3. (G1 is Pin 1).
-static const int __NUM_LEDS = 198;      // Number of LEDs on your strip.
-static const int __VIRTUAL_GAP = 25;    // Non-existent pixels to match mechanical rotation
-static const int __LOGICAL_NUM_LEDS = __NUM_LEDS + __VIRTUAL_GAP;
-static const uint8_t __INITIAL_GLOBAL_BRIGHTNESS = 76;  //30% initially. 100% is really quite bright in a darkened room.
+static const int __ONBOARD_LED_PIN = Sculpture::ONBOARD_LED_PIN;
+static const int __LED_STRIP_PIN = Sculpture::LED_STRIP_PIN;
+static const int __NUM_LEDS = Sculpture::NUM_LEDS;
+static const int __LOGICAL_NUM_LEDS = Sculpture::LOGICAL_NUM_LEDS;
+static const uint8_t __INITIAL_GLOBAL_BRIGHTNESS = Sculpture::INITIAL_GLOBAL_BRIGHTNESS;
+static const uint32_t __POWER_BUDGET_MA = 500;   // 5V strip budget, safe for the AtomS3 internal regulator
 
 
 // --- Remote Control ---
@@ -87,6 +187,9 @@ static const uint8_t __INITIAL_GLOBAL_BRIGHTNESS = 76;  //30% initially. 100% is
 // https://www.uuidgenerator.net/
 static const char* __SERVICE_UUID = "4fafc201-1fb5-459e-8fcc-c5c9c331914b";
 static const char* __COMMAND_CHAR_UUID = "beb5483e-36e1-4688-b7f5-ea07361b26a8";
+static const char* __STATUS_CHAR_UUID = "a1c6e5d2-7b3f-4c8e-9d21-6f0e8b4a3c57"; // Read/Notify: diagnostics output
+static BLECharacteristic* __statusCharacteristic = nullptr;
+static volatile bool __bleClientConnected = false;
 
 // --- Motor State Machine ---
 // This replaces the blocking delay() functions with a responsive state machine.
@@ -109,19 +212,9 @@ static bool __pendingOff = false; // Flag to handle "off" command safely in the
 static bool __isDirectionClockwise = true; // Default startup direction. Set to false for the quieter direction.
 static bool __isMotorRunning = false;
 
-// --- Speed Sync Lookup Table ---
-// This table is now defined globally and shared with auto_generator.cpp
-const SpeedSyncPair g_speedSyncTable[] = {
-    { 400, 5200 },
-    { 700, 2096 },
-    { 1000, 1250 }
-};
-const int g_speedSyncTableSize = sizeof(g_speedSyncTable) / sizeof(SpeedSyncPair);
-
 // --- LED Strip Objects & State ---
 static CRGB __onboard_led[1];
 static CRGB __leds[__NUM_LEDS];
-static int __led_position = 0;
 static bool __isLedReversed = false;    
 static uint8_t __globalMasterBrightness = __INITIAL_GLOBAL_BRIGHTNESS; // Global master brightness (0-255)
 static int __lastDisplayBrightnessPercent = 100; // Last requested display brightness %
@@ -133,6 +226,31 @@ static int __cometCount = 3;           // Default number of moving points
 static float __ledIntervalMs = 20.0f;  // Absolute time between LED steps in ms
 static unsigned long __last_led_strip_update = 0;
 
+// --- Comet Groups ---
+// The comet effect draws up to __COMET_GROUPS groups of evenly spaced comets. Group 0
+// is the one led_tails sets up (__cometCount, __cometTailLength, in __cometHue, which
+// the hue modes drive); led_comet_group sets up the others, each with its own count,
+// tail, hue, speed and direction. Positions are in 1/256 LED so a group can move at a
+// fraction of motor sync.
+enum CometHueSource : uint8_t { COMET_HUE_SHARED, COMET_HUE_FIXED, COMET_HUE_OFFSET };
+struct CometGroup {
+    int count = 0;               // Comets in the group; 0 when off
+    uint8_t tailLength = 10;     // As led_tails: the tail loses 255 / tailLength per LED
+    CometHueSource hueSource = COMET_HUE_SHARED;
+    uint8_t hue = 0;             // The fixed hue, or the offset from __cometHue
+    uint16_t speedPercent = 100; // LEDs per step, in percent of motor sync
+    int8_t direction = 1;        // 1 with the LED direction, -1 against it
+    uint32_t position = 0;       // Head of the first comet, in 1/256 LED
+};
+static const int __COMET_GROUPS = 4;
+static_assert(__COMET_GROUPS <= StripRender::MAX_COMET_DRAWS, "Every comet group is drawn in one pass");
+static const uint16_t __COMET_MAX_SPEED_PERCENT = 800;
+static CometGroup __cometGroups[__COMET_GROUPS];
+// Each group's tail brightness by distance from the head, rebuilt when its length changes.
+static uint8_t __cometTailLevels[__COMET_GROUPS][__LOGICAL_NUM_LEDS];
+static int __cometTailPixels[__COMET_GROUPS] = {};
+static uint8_t __cometTailBuiltFor[__COMET_GROUPS] = {}; // 0 = not built
+
 // --- Manual LED Sync State ---
 static bool __isManualLedInterval = false;    // Flag to override the sync table
 static float __manualLedIntervalMs = 0;       // The base interval set by the user
@@ -145,36 +263,19 @@ enum LedEffect {
     EFFECT_NOISE,
     EFFECT_FIRE,
     EFFECT_TWINKLE,
-    EFFECT_MARQUEE
+    EFFECT_MARQUEE,
+    EFFECT_PARTICLES // Keep last: __LED_EFFECT_COUNT follows it
 };
+// Loops over every effect stop here. Not an enumerator, so switches stay exhaustive.
+static const int __LED_EFFECT_COUNT = EFFECT_PARTICLES + 1;
+static_assert(__LED_EFFECT_COUNT <= PowerBudget::MAX_EFFECTS, "PowerBudget cannot learn a load for every effect");
+static_assert(__LED_EFFECT_COUNT <= ShowCheckpoint::MAX_EFFECT_LOADS, "The checkpoint cannot hold a load for every effect");
 static LedEffect __activeLedEffect = EFFECT_COMET;
 
-// Blink State
-static uint8_t __blinkHue = 0;
-static uint8_t __blinkMaxBri = 255;
-static unsigned long __blinkUpDuration = 1000;
-static unsigned long __blinkDownDuration = 1000;
-static unsigned long __blinkStartTime = 0;
-static int __blinkTargetCount = 0; // 0 means loop indefinitely
-
-// Noise State
-static CRGBPalette16 __noise_palette;
-static uint8_t __noise_scale = 30;
-static uint16_t __noise_x, __noise_y, __noise_z;
-static uint8_t __noise_speed = 10;
-
-// Fire State
-static byte __heat[__NUM_LEDS];
-
-// Marquee State
-static uint8_t __marquee_hue = 0;
-static uint8_t __marquee_lit_width = 4;
-static uint8_t __marquee_dark_width = 8;
-static uint8_t __marquee_offset = 0;
-
-// Twinkle State
-static uint8_t __twinkle_hue = 0;
-static uint8_t __twinkle_density = 50; // 0-255 chance per frame
+// Effect State
+// Blink, noise, fire, marquee, twinkle and particle settings share one union tagged by __activeLedEffect.
+// Always switch effects through beginEffect() so the incoming state is initialised.
+static EffectStateStorage<Sculpture> __effectState;
 
 
 // --- Dynamic LED State (Synced to Motor RPM) ---
@@ -192,7 +293,12 @@ static int __scriptCommandIndex = 0;
 static unsigned long __scriptLastCommandTime = 0;
 static unsigned long __scriptStartTime = 0;
 static unsigned long __scriptHoldDuration = 0;
-static std::vector<std::string> __activeScriptCommands;
+static ScriptBuffer __activeScript; // Statically sized; see script_buffer.h
+static uint32_t __scriptLoadCount = 0; // Bumped whenever __activeScript is rewritten
+static char __scriptPhaseName[24] = ""; // Taken from the script's most recent "[--- NAME ---]" comment
+static bool __sceneBoundaryPending = false; // A "[...]" marker ran; deferred commands apply at the scene's first hold
+static bool __isScriptPaused = false;
+static unsigned long __scriptPausedHeldMs = 0; // How far into the current hold the script was paused
 enum AutoModeType {
     AUTO_MODE_NONE,
     AUTO_MODE_NORMAL,
@@ -201,7 +307,7 @@ enum AutoModeType {
 static AutoModeType __autoModeType = AUTO_MODE_NONE;
 static int __autoModeDurationMinutes = 0;
 
-static const std::vector<std::string> __script_funky = {
+static const char* const __script_funky[] = {
     "led_reset",
     "hold:10000",
     "led_display_brightness:75",
@@ -279,6 +385,11 @@ static const std::vector<std::string> __script_funky = {
     "hold:10004",
 };
 
+// --- LCD Dashboard State ---
+static uint32_t __loopCountThisSecond = 0;
+static uint16_t __loopFps = 0;
+static unsigned long __loopFpsWindowStart = 0;
+
 // --- Throttled Logging --- DO NOT REMOVE THIS. It is useful to have. 
 
 // --- Throttled Logging --- DO NOT REMOVE THIS. It is useful to have. 
@@ -301,43 +412,760 @@ static void log_t(const char* format, ...) {
         (now - __lastLogTimestamp > __MIN_LOG_GAP_MS) || 
         strcmp(buf, __lastLogBuffer) != 0) {
         
-        Serial.printf("%lu ms: %s\n", now, buf);
+        // Formatted on the stack and written whole; Serial.printf() would allocate for long lines.
+        char line[sizeof(buf) + 16];
+        int len = snprintf(line, sizeof(line), "%lu ms: %s\n", now, buf);
+        if (len > 0) Serial.write(line, min((size_t)len, sizeof(line) - 1));
         __lastLogTimestamp = now;
         strncpy(__lastLogBuffer, buf, sizeof(__lastLogBuffer) - 1);
         __lastLogBuffer[sizeof(__lastLogBuffer) - 1] = '\0';
     }
 }
 
-// Calculates the estimated revolution time in ms for a given logical speed.
-// This logic is shared between the main loop (for LED sync) and the auto-generator.
-long calculate_rev_time_ms(int speed) {
-    if (g_speedSyncTableSize < 2) return 2000; // Fallback
-    
-    float targetRevTime = 0;
-
-    if (speed <= g_speedSyncTable[0].logicalSpeed) {
-        // Linear extrapolation using the first segment
-        float m = (float)(g_speedSyncTable[1].revTimeMs - g_speedSyncTable[0].revTimeMs) /
-                  (float)(g_speedSyncTable[1].logicalSpeed - g_speedSyncTable[0].logicalSpeed);
-        targetRevTime = g_speedSyncTable[0].revTimeMs + m * (speed - g_speedSyncTable[0].logicalSpeed);
-    } else if (speed >= g_speedSyncTable[g_speedSyncTableSize - 1].logicalSpeed) {
-        // Linear extrapolation using the last segment
-        int last = g_speedSyncTableSize - 1;
-        float m = (float)(g_speedSyncTable[last].revTimeMs - g_speedSyncTable[last-1].revTimeMs) /
-                  (float)(g_speedSyncTable[last].logicalSpeed - g_speedSyncTable[last-1].logicalSpeed);
-        targetRevTime = g_speedSyncTable[last].revTimeMs + m * (speed - g_speedSyncTable[last].logicalSpeed);
-    } else {
-        // Piecewise linear interpolation
-        for (int i = 0; i < g_speedSyncTableSize - 1; i++) {
-            if (speed >= g_speedSyncTable[i].logicalSpeed && speed <= g_speedSyncTable[i+1].logicalSpeed) {
-                float fraction = (float)(speed - g_speedSyncTable[i].logicalSpeed) /
-                                 (float)(g_speedSyncTable[i+1].logicalSpeed - g_speedSyncTable[i].logicalSpeed);
-                targetRevTime = g_speedSyncTable[i].revTimeMs + fraction * (g_speedSyncTable[i+1].revTimeMs - g_speedSyncTable[i].revTimeMs);
-                break;
+/**
+ * @brief Returns a short display name for an LED effect.
+ */
+const char* ledEffectName(LedEffect effect) {
+    switch (effect) {
+        case EFFECT_COMET:   return "comet";
+        case EFFECT_BLINK:   return "blink";
+        case EFFECT_NOISE:   return "noise";
+        case EFFECT_FIRE:    return "fire";
+        case EFFECT_TWINKLE: return "twinkle";
+        case EFFECT_MARQUEE: return "marquee";
+        case EFFECT_PARTICLES: return "particles";
+    }
+    return "?";
+}
+
+// Noise palette table, defined with the split pixel work.
+void buildNoisePaletteTable(const CRGBPalette16& palette);
+
+/**
+ * @brief Makes `effect` the active LED effect and resets its state to defaults.
+ */
+void beginEffect(LedEffect effect) {
+    __activeLedEffect = effect;
+    switch (effect) {
+        case EFFECT_BLINK:   new (&__effectState.blink) BlinkState(); break;
+        case EFFECT_NOISE:
+            new (&__effectState.noise) NoiseState();
+            buildNoisePaletteTable(__effectState.noise.palette);
+            break;
+        case EFFECT_FIRE:    new (&__effectState.fire) FireState<Sculpture>(); break;
+        case EFFECT_MARQUEE: new (&__effectState.marquee) MarqueeState(); break;
+        case EFFECT_TWINKLE: new (&__effectState.twinkle) TwinkleState(); break;
+        case EFFECT_PARTICLES:
+            new (&__effectState.particles) ParticleState();
+            ParticleSystem::reset();
+            break;
+        case EFFECT_COMET:   break; // Comet state lives outside the union
+    }
+}
+
+/**
+ * @brief Remembers the phase name from a script comment such as "[---------- VIBE ----------]".
+ */
+void updateScriptPhaseName(const char* comment) {
+    const char* start = comment + strspn(comment, "[- ");
+    const char* end = comment + strlen(comment);
+    while (end > start && strchr("]- ", end[-1]) != nullptr) end--;
+    if (end == start) return;
+    size_t len = min((size_t)(end - start), sizeof(__scriptPhaseName) - 1);
+    memcpy(__scriptPhaseName, start, len);
+    __scriptPhaseName[len] = '\0';
+}
+
+/**
+ * @brief Starts playing __activeScript from its first step and indexes it for seeking.
+ */
+void beginScriptPlayback() {
+    __scriptCommandIndex = 0;
+    __scriptStartTime = __scriptLastCommandTime = millis();
+    __scriptPhaseName[0] = '\0';
+    __scriptHoldDuration = 0;
+    __isScriptRunning = true;
+    __isScriptPaused = false;
+    __scriptLoadCount++;
+    ScriptTimeline::build(__activeScript, (uint32_t)__currentRampDuration);
+}
+
+/**
+ * @brief How far into the current hold the script is (frozen while paused).
+ */
+unsigned long scriptHeldMs() {
+    return __isScriptPaused ? __scriptPausedHeldMs : millis() - __scriptLastCommandTime;
+}
+
+/**
+ * @brief Current position in planned script time (see script_timeline.h).
+ */
+uint32_t scriptPositionMs() {
+    unsigned long held = scriptHeldMs();
+    unsigned long remaining = (held < __scriptHoldDuration) ? __scriptHoldDuration - held : 0;
+    uint32_t end = ScriptTimeline::stepStartMs(__scriptCommandIndex);
+    return (end > remaining) ? end - (uint32_t)remaining : 0;
+}
+
+/**
+ * @brief Planned time left until the script ends, or -1 if none is running.
+ */
+long scriptRemainingMs() {
+    if (!__isScriptRunning) return -1;
+    uint32_t pos = scriptPositionMs();
+    uint32_t total = ScriptTimeline::totalMs();
+    return (total > pos) ? (long)(total - pos) : 0;
+}
+
+/**
+ * @brief Feeds the current system state to the LCD dashboard. The dashboard itself
+ * rate-limits refreshes and only redraws the regions that changed.
+ */
+void serviceLcdDashboard() {
+    unsigned long now = millis();
+    __loopCountThisSecond++;
+    if (now - __loopFpsWindowStart >= 1000) {
+        __loopFps = (uint16_t)min(__loopCountThisSecond, (uint32_t)65535);
+        __loopCountThisSecond = 0;
+        __loopFpsWindowStart = now;
+    }
+    if (!LcdDashboard::isEnabled()) return;
+
+    LcdDashboard::Status status;
+    status.currentSpeed = __currentLogicalSpeed;
+    status.speedSetting = __speedSetting;
+    status.clockwise = __isDirectionClockwise;
+    status.motorRunning = __isMotorRunning;
+    status.effectName = ledEffectName(__activeLedEffect);
+    status.phaseName = __isScriptRunning ? __scriptPhaseName : "";
+    status.holdRemainingMs = -1;
+    if (__isScriptRunning && __scriptHoldDuration > 0) {
+        unsigned long held = scriptHeldMs();
+        status.holdRemainingMs = (held < __scriptHoldDuration) ? (long)(__scriptHoldDuration - held) : 0;
+    }
+    status.scriptRemainingMs = scriptRemainingMs();
+    status.loopFps = __loopFps;
+    status.freeHeap = ESP.getFreeHeap();
+    LcdDashboard::update(status, now);
+}
+
+/**
+ * @brief Sends a line of diagnostics text to a connected client via the Status characteristic.
+ */
+void notifyStatus(const char* text) {
+    if (__statusCharacteristic == nullptr || !__bleClientConnected) return;
+    // The BLE library copies the value into a std::string internally.
+    HeapGuard::Exempt exempt;
+    __statusCharacteristic->setValue((uint8_t*)text, strlen(text));
+    __statusCharacteristic->notify();
+}
+
+// --- Event Trace Dump ---
+// Dumps are emitted a few lines per loop pass so they never stall rendering.
+// Recording is paused while a dump is in progress so the ring stays consistent.
+enum TraceDumpTarget {
+    TRACE_DUMP_NONE,
+    TRACE_DUMP_SERIAL,
+    TRACE_DUMP_BLE
+};
+static TraceDumpTarget __traceDumpTarget = TRACE_DUMP_NONE;
+static size_t __traceDumpLine = 0;
+static bool __traceWasEnabled = false;
+static const int __TRACE_DUMP_SERIAL_LINES_PER_PASS = 16;
+static const int __TRACE_DUMP_BLE_LINES_PER_PASS = 4;
+
+void startTraceDump(TraceDumpTarget target) {
+    if (__traceDumpTarget == TRACE_DUMP_NONE) {
+        __traceWasEnabled = EventTracer::isEnabled();
+    }
+    EventTracer::setEnabled(false);
+    __traceDumpTarget = target;
+    __traceDumpLine = 0;
+    if (target == TRACE_DUMP_SERIAL) Serial.println("--- BEGIN EVENT TRACE ---");
+}
+
+void serviceTraceDump() {
+    if (__traceDumpTarget == TRACE_DUMP_NONE) return;
+    int budget = (__traceDumpTarget == TRACE_DUMP_SERIAL) ? __TRACE_DUMP_SERIAL_LINES_PER_PASS : __TRACE_DUMP_BLE_LINES_PER_PASS;
+    char line[48];
+    for (int i = 0; i < budget; i++) {
+        if (!EventTracer::formatDumpLine(__traceDumpLine, line, sizeof(line))) {
+            if (__traceDumpTarget == TRACE_DUMP_SERIAL) Serial.println("--- END EVENT TRACE ---");
+            else notifyStatus("TD");
+            log_t("Trace dump complete: %u events.", (unsigned)EventTracer::count());
+            __traceDumpTarget = TRACE_DUMP_NONE;
+            EventTracer::setEnabled(__traceWasEnabled);
+            return;
+        }
+        if (__traceDumpTarget == TRACE_DUMP_SERIAL) Serial.println(line);
+        else notifyStatus(line);
+        __traceDumpLine++;
+    }
+}
+
+// --- Script Dump ---
+// Exports __activeScript on request, a bounded number of bytes per loop pass, so a
+// printout never stalls rendering. Serial output, framing lines included, only takes
+// what the USB CDC buffer can accept without blocking; the rest waits for the next
+// pass. The dump is abandoned if a new script is loaded under it, or if Serial takes
+// nothing for __SCRIPT_DUMP_STALL_MS (no host reading the port).
+enum ScriptDumpTarget {
+    SCRIPT_DUMP_NONE,
+    SCRIPT_DUMP_SERIAL,
+    SCRIPT_DUMP_FILE
+};
+static const char* const __SCRIPT_DUMP_PATH = "/script.txt";
+static const size_t __SCRIPT_DUMP_SERIAL_BYTES_PER_PASS = 256;
+static const size_t __SCRIPT_DUMP_FILE_BYTES_PER_PASS = 1024;
+static const unsigned long __SCRIPT_DUMP_STALL_MS = 3000;
+static ScriptDumpTarget __scriptDumpTarget = SCRIPT_DUMP_NONE;
+static int __scriptDumpLine = 0;
+static uint32_t __scriptDumpLoadCount = 0;
+static const char* __scriptDumpTitle = "";
+static File __scriptDumpFile;
+static char __scriptDumpFrame[96];      // BEGIN or END lines not yet written to Serial
+static bool __scriptDumpEnding = false; // The END lines are in __scriptDumpFrame
+static unsigned long __scriptDumpProgressMs = 0;
+
+/**
+ * @brief Writes `len` bytes to Serial only if they all fit without blocking.
+ */
+bool writeSerialWhole(const char* text, size_t len) {
+    if ((size_t)Serial.availableForWrite() < len) return false;
+    Serial.write(text, len);
+    __scriptDumpProgressMs = millis();
+    return true;
+}
+
+/**
+ * @brief Finishes (or abandons) the dump in progress and logs how far it got.
+ */
+void endScriptDump(const char* outcome) {
+    if (__scriptDumpTarget == SCRIPT_DUMP_SERIAL && !__scriptDumpEnding && __scriptDumpFrame[0] == '\0') {
+        // Abandoned after the BEGIN line: close the block if Serial takes it now, but never wait.
+        snprintf(__scriptDumpFrame, sizeof(__scriptDumpFrame), "--- END %s ---\nTotal script lines: %d\n\n",
+                 __scriptDumpTitle, __scriptDumpLine);
+        writeSerialWhole(__scriptDumpFrame, strlen(__scriptDumpFrame));
+    } else if (__scriptDumpTarget == SCRIPT_DUMP_FILE) {
+        HeapGuard::Exempt exempt; // The VFS frees the file's buffers
+        __scriptDumpFile.close();
+    }
+    log_t("Script dump %s: %d of %d lines%s.", outcome, __scriptDumpLine, __activeScript.size(),
+          __scriptDumpTarget == SCRIPT_DUMP_FILE ? " written to /script.txt" : "");
+    __scriptDumpTarget = SCRIPT_DUMP_NONE;
+    __scriptDumpFrame[0] = '\0';
+    __scriptDumpEnding = false;
+}
+
+/**
+ * @brief Starts exporting __activeScript to `target`, replacing any dump in progress.
+ */
+void startScriptDump(ScriptDumpTarget target, const char* title) {
+    if (__scriptDumpTarget != SCRIPT_DUMP_NONE) endScriptDump("abandoned");
+    if (target == SCRIPT_DUMP_FILE) {
+        HeapGuard::Exempt exempt; // Opening a file allocates its buffers
+        if (LittleFS.begin(false)) __scriptDumpFile = LittleFS.open(__SCRIPT_DUMP_PATH, "w");
+        if (!__scriptDumpFile) {
+            log_t("Script dump: cannot open %s.", __SCRIPT_DUMP_PATH);
+            return;
+        }
+    } else if (target == SCRIPT_DUMP_SERIAL) {
+        snprintf(__scriptDumpFrame, sizeof(__scriptDumpFrame), "\n--- BEGIN %s ---\n", title);
+    }
+    __scriptDumpTarget = target;
+    __scriptDumpTitle = title;
+    __scriptDumpLine = 0;
+    __scriptDumpLoadCount = __scriptLoadCount;
+    __scriptDumpEnding = false;
+    __scriptDumpProgressMs = millis();
+}
+
+void serviceScriptDump() {
+    if (__scriptDumpTarget == SCRIPT_DUMP_NONE) return;
+    if (__scriptDumpLoadCount != __scriptLoadCount) {
+        endScriptDump("abandoned (script replaced)");
+        return;
+    }
+    bool toSerial = (__scriptDumpTarget == SCRIPT_DUMP_SERIAL);
+    if (toSerial && millis() - __scriptDumpProgressMs > __SCRIPT_DUMP_STALL_MS) {
+        endScriptDump("abandoned (nothing is reading Serial)");
+        return;
+    }
+    if (__scriptDumpFrame[0] != '\0') {
+        if (!writeSerialWhole(__scriptDumpFrame, strlen(__scriptDumpFrame))) return; // Would block; try next pass
+        __scriptDumpFrame[0] = '\0';
+        if (__scriptDumpEnding) {
+            endScriptDump("complete");
+            return;
+        }
+    }
+    size_t budget = toSerial ? __SCRIPT_DUMP_SERIAL_BYTES_PER_PASS : __SCRIPT_DUMP_FILE_BYTES_PER_PASS;
+    size_t written = 0;
+    while (__scriptDumpLine < __activeScript.size()) {
+        const char* line = __activeScript[__scriptDumpLine];
+        size_t len = strlen(line) + 1; // With the newline
+        if (written > 0 && written + len > budget) return;
+        if (toSerial) {
+            if ((size_t)Serial.availableForWrite() < len) return; // Would block; try next pass
+            Serial.write(line, len - 1);
+            Serial.write('\n');
+            __scriptDumpProgressMs = millis();
+        } else {
+            HeapGuard::Exempt exempt;
+            if (__scriptDumpFile.write((const uint8_t*)line, len - 1) != len - 1 || __scriptDumpFile.write((const uint8_t*)"\n", 1) != 1) {
+                endScriptDump("failed (file system full?)");
+                return;
             }
         }
+        __scriptDumpLine++;
+        written += len;
+    }
+    if (!toSerial) {
+        endScriptDump("complete");
+        return;
+    }
+    // The END lines go out like the rest, on this pass or a later one.
+    snprintf(__scriptDumpFrame, sizeof(__scriptDumpFrame), "--- END %s ---\nTotal script lines: %d\n\n",
+             __scriptDumpTitle, __scriptDumpLine);
+    __scriptDumpEnding = true;
+}
+
+// --- Loop Watchdog ---
+// Retained overruns are notified over BLE a couple per pass, like trace dumps.
+static int __watchdogDumpIndex = -1; // -1 when idle
+static const int __WATCHDOG_DUMP_LINES_PER_PASS = 2;
+
+/**
+ * @brief Logs the overrun counters and every retained overrun, and notifies a summary.
+ */
+void reportLoopWatchdog() {
+    char line[LoopWatchdog::MAX_LINE_LEN];
+    snprintf(line, sizeof(line), "WDG %lu %lu %lu %lu %lu %lu", (unsigned long)LoopWatchdog::passes(),
+             (unsigned long)LoopWatchdog::overruns(), (unsigned long)LoopWatchdog::retainedOverruns(),
+             (unsigned long)LoopWatchdog::maxPassUs(), (unsigned long)LoopWatchdog::budgetUs(),
+             (unsigned long)LoopWatchdog::bootCount());
+    notifyStatus(line);
+    log_t("Loop watchdog (boot %lu): %lu passes, %lu over %lu us (%lu across resets), longest %lu us.",
+          (unsigned long)LoopWatchdog::bootCount(), (unsigned long)LoopWatchdog::passes(),
+          (unsigned long)LoopWatchdog::overruns(), (unsigned long)LoopWatchdog::budgetUs(),
+          (unsigned long)LoopWatchdog::retainedOverruns(), (unsigned long)LoopWatchdog::maxPassUs());
+    for (int s = 0; s < LoopWatchdog::STAGE_COUNT; s++) {
+        uint32_t n = LoopWatchdog::stageOverruns((LoopWatchdog::Stage)s);
+        if (n) log_t("  %-12s %lu overruns", LoopWatchdog::stageName(s), (unsigned long)n);
+    }
+    for (int i = 0; i < LoopWatchdog::count(); i++) {
+        LoopWatchdog::formatOverrun(LoopWatchdog::at(i), line, sizeof(line));
+        log_t("  %s", line);
+    }
+}
+
+void serviceWatchdogDump() {
+    if (__watchdogDumpIndex < 0) return;
+    char line[LoopWatchdog::MAX_LINE_LEN];
+    for (int i = 0; i < __WATCHDOG_DUMP_LINES_PER_PASS; i++) {
+        if (__watchdogDumpIndex >= LoopWatchdog::count()) {
+            notifyStatus("WDO end");
+            __watchdogDumpIndex = -1;
+            return;
+        }
+        LoopWatchdog::formatOverrun(LoopWatchdog::at(__watchdogDumpIndex++), line, sizeof(line));
+        notifyStatus(line);
     }
-    return (long)max(500.0f, targetRevTime); // Ensure a minimum reasonable time
+}
+
+// --- System Statistics ---
+static SysStats::Snapshot __sysStats; // Static: a snapshot holds every task
+static int __sysStatsDumpIndex = -1;  // Next task to notify, -1 when idle
+static const int __SYS_STATS_DUMP_LINES_PER_PASS = 2;
+
+/**
+ * @brief Takes a task/heap snapshot, logs it and notifies the SYS summary. With
+ * `perTaskBle`, the TSK lines follow over BLE a couple per pass.
+ */
+void reportSysStats(bool perTaskBle) {
+    SysStats::collect(&__sysStats);
+    const SysStats::Snapshot& st = __sysStats;
+    char line[SysStats::MAX_LINE_LEN];
+    SysStats::formatSummary(st, line, sizeof(line));
+    notifyStatus(line);
+    log_t("System: up %lu s. Heap %lu free, %lu min, %lu largest. CPU %d/%d permille over %lu ms. Loop stack %lu bytes free.",
+          (unsigned long)st.uptimeS, (unsigned long)st.heapFree, (unsigned long)st.heapMinFree,
+          (unsigned long)st.heapLargest, st.coreLoadPermille[0], st.coreLoadPermille[1],
+          (unsigned long)st.intervalMs, (unsigned long)st.callerStackFreeBytes);
+    for (int i = 0; i < st.taskCount; i++) {
+        const SysStats::Task& t = st.tasks[i];
+        log_t("  %-16s core %2d prio %2u stack free %5lu  cpu %4d permille", t.name, t.core, (unsigned)t.priority,
+              (unsigned long)t.stackFreeBytes, t.cpuPermille);
+    }
+    if (st.taskListOverflow) {
+        log_t("Task list unavailable: %d tasks running, more than the %d a snapshot holds.", st.tasksRunning,
+              SysStats::MAX_TASKS);
+    }
+    log_t("Collected %d of %d tasks in %lu us.", st.taskCount, st.tasksRunning, (unsigned long)st.collectUs);
+    __sysStatsDumpIndex = perTaskBle ? 0 : -1;
+}
+
+void serviceSysStatsDump() {
+    if (__sysStatsDumpIndex < 0) return;
+    char line[SysStats::MAX_LINE_LEN];
+    for (int i = 0; i < __SYS_STATS_DUMP_LINES_PER_PASS && __sysStatsDumpIndex < __sysStats.taskCount; i++) {
+        SysStats::formatTask(__sysStats.tasks[__sysStatsDumpIndex++], line, sizeof(line));
+        notifyStatus(line);
+    }
+    if (__sysStatsDumpIndex >= __sysStats.taskCount) __sysStatsDumpIndex = -1;
+}
+
+/**
+ * @brief Sends the command acknowledgements that are ready. They go out after the
+ * pass's frame so an applied command normally carries its apply->frame time.
+ */
+void serviceCommandAcks() {
+    char line[CommandAck::MAX_LINE_LEN];
+    while (CommandAck::takeReady(EventTracer::now(), line, sizeof(line))) {
+        notifyStatus(line);
+        log_t("%s", line);
+    }
+}
+
+// --- Generator Benchmark ---
+// gen_bench runs each case once per seed, one generation per loop pass, into the
+// active script buffer (so it refuses to start, and stops, if a script is running).
+struct GenBenchCase {
+    const char* name;
+    bool steadyRotate;
+    int minutes;
+};
+static const GenBenchCase __genBenchCases[] = {
+    { "auto_mode", false, 5 },
+    { "auto_mode", false, 30 },
+    { "auto_mode", false, 60 },
+    { "auto_mode", false, 240 },
+    { "auto_steady_rotate", true, 60 },
+    { "auto_steady_rotate", true, 240 },
+    { "auto_steady_rotate", true, 480 }
+};
+static const int __GEN_BENCH_CASE_COUNT = sizeof(__genBenchCases) / sizeof(__genBenchCases[0]);
+static const int __GEN_BENCH_DEFAULT_SEEDS = 5;
+static int __genBenchCase = -1; // -1 when idle
+static int __genBenchSeeds = 0;
+static int __genBenchRun = 0;
+static GenBench::Sample __genBenchSamples[GenBench::MAX_SAMPLES];
+
+/**
+ * @brief Starts gen_bench. Returns false (and does nothing) while a script runs.
+ */
+bool startGenBench(int seeds) {
+    if (__isScriptRunning) {
+        log_t("gen_bench ignored: stop the running script first.");
+        return false;
+    }
+    __genBenchSeeds = constrain(seeds, 1, GenBench::MAX_SAMPLES);
+    __genBenchCase = 0;
+    __genBenchRun = 0;
+    log_t("Generator benchmark: %d cases x %d seeds, Serial dump off.", __GEN_BENCH_CASE_COUNT, __genBenchSeeds);
+    return true;
+}
+
+void serviceGenBench() {
+    if (__genBenchCase < 0) return;
+    if (__isScriptRunning) {
+        log_t("Generator benchmark stopped: a script started.");
+        __genBenchCase = -1;
+        return;
+    }
+
+    const GenBenchCase& c = __genBenchCases[__genBenchCase];
+    uint32_t seed = (uint32_t)__genBenchRun + 1; // Same seeds every run, so results compare
+    // Internal heap, as ESP.getFreeHeap(). The low-water mark cannot be reset, so the
+    // peak is only exact when the run sets a new one.
+    uint32_t heapBefore = heap_caps_get_free_size(MALLOC_CAP_INTERNAL);
+    uint32_t lowWaterBefore = heap_caps_get_minimum_free_size(MALLOC_CAP_INTERNAL);
+    uint32_t startUs = EventTracer::now();
+    __scriptLoadCount++;
+    if (c.steadyRotate) {
+        AutoGenerator::generateSteadyRotateScript<Sculpture>(c.minutes, __activeScript, seed, false);
+    } else {
+        AutoGenerator::generateScript<Sculpture>(c.minutes, (uint32_t)__currentRampDuration, __activeScript, seed, false);
+    }
+    GenBench::Sample& sample = __genBenchSamples[__genBenchRun];
+    sample.us = EventTracer::now() - startUs;
+    uint32_t lowWaterAfter = heap_caps_get_minimum_free_size(MALLOC_CAP_INTERNAL);
+    sample.heapMeasured = true;
+    sample.heapDelta = (int32_t)heap_caps_get_free_size(MALLOC_CAP_INTERNAL) - (int32_t)heapBefore;
+    sample.heapPeak = (heapBefore > lowWaterAfter) ? heapBefore - lowWaterAfter : 0;
+    sample.heapPeakExact = lowWaterAfter < lowWaterBefore;
+    sample.lines = (uint16_t)__activeScript.size();
+    sample.dropped = (uint16_t)__activeScript.dropped();
+    sample.bytes = (uint32_t)__activeScript.bytesUsed();
+
+    if (++__genBenchRun < __genBenchSeeds) return;
+
+    GenBench::Summary summary;
+    GenBench::summarize(__genBenchSamples, __genBenchRun, c.minutes, &summary);
+    char line[256];
+    GenBench::format(c.name, c.minutes, summary, line, sizeof(line));
+    log_t("%s", line);
+    __genBenchRun = 0;
+    if (++__genBenchCase < __GEN_BENCH_CASE_COUNT) return;
+
+    __genBenchCase = -1;
+    __activeScript.clear();
+    log_t("Generator benchmark done. Loop task stack: %u bytes never used. Heap guard: %lu allocations after setup.",
+          (unsigned)uxTaskGetStackHighWaterMark(nullptr), (unsigned long)HeapGuard::violations());
+}
+
+// --- Split Pixel Work ---
+// The per-pixel stages that ParallelRender may split across the two cores are
+// StripRender's range functions; main.cpp builds their jobs and colour tables.
+
+// Below this many pixels a stage is cheaper to run on one core than to split.
+// Noise costs a few microseconds per pixel; the heat map (a table lookup since it
+// moved to StripRender), fades and fills are memory bound and only pay off on long
+// strips.
+static const int __SPLIT_MIN_PIXELS_HEAVY = 64;
+static const int __SPLIT_MIN_PIXELS_LIGHT = 512;
+
+static const ParallelRender::RangeFn renderNoiseRange = StripRender::renderNoiseRange<inoise8>;
+using StripRender::renderHeatRange;
+using StripRender::renderCometRange;
+using StripRender::renderMarqueeRange;
+using StripRender::fillCometTailLevels;
+
+static void setRgb(uint8_t* rgb, const CRGB& color) {
+    rgb[0] = color.r;
+    rgb[1] = color.g;
+    rgb[2] = color.b;
+}
+
+// FastLED's colour maps for the noise and heat stages, converted once per palette.
+static uint8_t __heatRgb[256][3];
+static uint8_t __noisePaletteRgb[256][3]; // The noise effect's current palette
+
+void buildHeatTable() {
+    for (int i = 0; i < 256; i++) setRgb(__heatRgb[i], HeatColor((uint8_t)i));
+}
+
+void buildNoisePaletteTable(const CRGBPalette16& palette) {
+    for (int i = 0; i < 256; i++) setRgb(__noisePaletteRgb[i], ColorFromPalette(palette, (uint8_t)i, 255, LINEARBLEND));
+}
+
+void resetCometPositions() {
+    for (int g = 0; g < __COMET_GROUPS; g++) __cometGroups[g].position = 0;
+}
+
+// Turns off every group but led_tails' own.
+void clearCometGroups() {
+    for (int g = 1; g < __COMET_GROUPS; g++) __cometGroups[g].count = 0;
+}
+
+// Moves every group one LED step on, each by its own share of it.
+void stepCometGroups(bool ledForward) {
+    const uint32_t length = (uint32_t)__LOGICAL_NUM_LEDS << 8;
+    for (int g = 0; g < __COMET_GROUPS; g++) {
+        CometGroup& group = __cometGroups[g];
+        uint32_t step = ((uint32_t)group.speedPercent * 256 / 100) % length;
+        if (ledForward == (group.direction > 0)) group.position = (group.position + step) % length;
+        else group.position = (group.position + length - step) % length;
+    }
+}
+
+// Draws every group into __leds at its current position.
+void renderCometGroups(bool ledForward) {
+    __cometGroups[0].count = __cometCount;
+    __cometGroups[0].tailLength = (uint8_t)constrain(__cometTailLength, 1, 255);
+
+    StripRender::CometJob job;
+    job.rgb = (uint8_t*)__leds;
+    setRgb(job.background, CHSV(__bgHue, 255, __bgBrightness));
+    job.logicalLength = __LOGICAL_NUM_LEDS;
+    job.drawCount = 0;
+    for (int g = 0; g < __COMET_GROUPS; g++) {
+        const CometGroup& group = __cometGroups[g];
+        if (group.count <= 0) continue;
+        if (__cometTailBuiltFor[g] != group.tailLength) {
+            __cometTailPixels[g] = fillCometTailLevels(__cometTailLevels[g], __LOGICAL_NUM_LEDS, group.tailLength);
+            __cometTailBuiltFor[g] = group.tailLength;
+        }
+        uint8_t hue = (group.hueSource == COMET_HUE_FIXED) ? group.hue
+                    : (group.hueSource == COMET_HUE_OFFSET) ? (uint8_t)(__cometHue + group.hue) : __cometHue;
+        StripRender::CometDraw& d = job.draws[job.drawCount++];
+        setRgb(d.color, CHSV(hue, 255, 255));
+        d.head = (int)(group.position >> 8);
+        d.tailStep = (ledForward == (group.direction > 0)) ? -1 : 1;
+        d.count = min(group.count, __LOGICAL_NUM_LEDS);
+        d.spacing = __LOGICAL_NUM_LEDS / d.count;
+        d.levels = __cometTailLevels[g];
+        d.tailPixels = __cometTailPixels[g];
+    }
+    ParallelRender::forEach(renderCometRange, &job, __NUM_LEDS, __SPLIT_MIN_PIXELS_LIGHT);
+}
+
+// --- Render Benchmark ---
+// render_bench times the splittable stages serially and split at several strip
+// lengths, one stage and length per loop pass. It renders into its own buffer, never
+// shown, so the sculpture keeps running; the longest case blocks loop() for about
+// 0.1 s.
+static const int __RENDER_BENCH_MAX_LEDS = 4096;
+static const int __renderBenchSizes[] = { 198, 1024, __RENDER_BENCH_MAX_LEDS };
+static const int __RENDER_BENCH_SIZE_COUNT = sizeof(__renderBenchSizes) / sizeof(__renderBenchSizes[0]);
+static const char* const __renderBenchStages[] = { "noise", "heat", "comets", "marquee" };
+static const int __RENDER_BENCH_STAGE_COUNT = sizeof(__renderBenchStages) / sizeof(__renderBenchStages[0]);
+static const int __RENDER_BENCH_ITERATIONS = 10;
+static CRGB __renderBenchLeds[__RENDER_BENCH_MAX_LEDS]; // 12 KB, static so the bench stays heap-free
+static byte __renderBenchHeat[__RENDER_BENCH_MAX_LEDS];  // Fire's heat map, as the heat stage's input
+static int __renderBenchCase = -1; // -1 when idle
+
+void startRenderBench() {
+    if (!ParallelRender::isEnabled()) log_t("render_bench: splitting is off; both columns will be serial.");
+    // A spread of heat values, so HeatColor() takes each of its branches.
+    for (int i = 0; i < __RENDER_BENCH_MAX_LEDS; i++) __renderBenchHeat[i] = (byte)(i * 7);
+    __renderBenchCase = 0;
+}
+
+// Runs one stage over `count` pixels and returns the average time per call.
+uint32_t timeRenderStage(int stage, int count, bool split) {
+    uint8_t* rgb = (uint8_t*)__renderBenchLeds;
+    NoiseState noise;
+    StripRender::NoiseJob noiseJob = { rgb, __noisePaletteRgb, noise.x, noise.y, noise.z, noise.scale };
+    // Three comets with 10-LED tails, as system_reset leaves them.
+    static uint8_t cometLevels[__LOGICAL_NUM_LEDS];
+    StripRender::CometJob cometJob;
+    cometJob.rgb = rgb;
+    setRgb(cometJob.background, CRGB(20, 10, 5));
+    cometJob.logicalLength = __LOGICAL_NUM_LEDS;
+    cometJob.drawCount = 1;
+    cometJob.draws[0] = { { 255, 0, 0 }, 0, -1, 3, __LOGICAL_NUM_LEDS / 3, cometLevels,
+                          fillCometTailLevels(cometLevels, __LOGICAL_NUM_LEDS, 10) };
+    StripRender::MarqueeJob marqueeJob = { rgb, { 255, 0, 0 }, 0, 4, 12 };
+    StripRender::HeatJob heatJob = { rgb, __renderBenchHeat, __heatRgb };
+    static const ParallelRender::RangeFn fns[] = { renderNoiseRange, renderHeatRange, renderCometRange, renderMarqueeRange };
+    void* const jobs[] = { &noiseJob, &heatJob, &cometJob, &marqueeJob };
+    static_assert(sizeof(fns) / sizeof(fns[0]) == __RENDER_BENCH_STAGE_COUNT, "One range function per bench stage");
+    ParallelRender::RangeFn fn = fns[stage];
+    void* job = jobs[stage];
+    int minCount = split ? 0 : count + 1;
+    uint32_t startUs = EventTracer::now();
+    for (int i = 0; i < __RENDER_BENCH_ITERATIONS; i++) {
+        noiseJob.z += noise.speed;
+        marqueeJob.offset = (uint8_t)(i % marqueeJob.totalWidth);
+        cometJob.draws[0].head = i;
+        ParallelRender::forEach(fn, job, count, minCount);
+    }
+    return (EventTracer::now() - startUs) / __RENDER_BENCH_ITERATIONS;
+}
+
+void serviceRenderBench() {
+    if (__renderBenchCase < 0) return;
+    int stage = __renderBenchCase / __RENDER_BENCH_SIZE_COUNT;
+    int count = __renderBenchSizes[__renderBenchCase % __RENDER_BENCH_SIZE_COUNT];
+    uint32_t serialUs = timeRenderStage(stage, count, false);
+    uint32_t splitUs = timeRenderStage(stage, count, true);
+    log_t("render_bench %-10s %4d LEDs: serial %5lu us (%4lu ns/pixel), split %5lu us (x%.2f)", __renderBenchStages[stage],
+          count, (unsigned long)serialUs, (unsigned long)((uint64_t)serialUs * 1000 / count), (unsigned long)splitUs,
+          splitUs ? (float)serialUs / (float)splitUs : 0.0f);
+    if (++__renderBenchCase < __RENDER_BENCH_STAGE_COUNT * __RENDER_BENCH_SIZE_COUNT) return;
+    __renderBenchCase = -1;
+    log_t("render_bench done. Since boot: %lu split calls, %lu serial, longest join wait %lu us, %lu join timeouts.",
+          (unsigned long)ParallelRender::splitCalls(), (unsigned long)ParallelRender::serialCalls(),
+          (unsigned long)ParallelRender::maxJoinWaitUs(), (unsigned long)ParallelRender::joinTimeouts());
+}
+
+// --- Particles ---
+// Full-brightness colour of each hue, converted once so a particle costs no HSV maths.
+static uint8_t __particleHueRgb[256][3];
+
+void buildParticleHueTable() {
+    for (int h = 0; h < 256; h++) {
+        CRGB color = CHSV((uint8_t)h, 255, 255);
+        __particleHueRgb[h][0] = color.r;
+        __particleHueRgb[h][1] = color.g;
+        __particleHueRgb[h][2] = color.b;
+    }
+}
+
+/**
+ * @brief Switches to the particles effect unless it is already running, so emitter,
+ * gravity and burst commands work on their own.
+ */
+void ensureParticlesEffect() {
+    if (__activeLedEffect != EFFECT_PARTICLES) beginEffect(EFFECT_PARTICLES);
+}
+
+// particle_bench times a particle frame (update and render) at 10, 100 and 1000 live
+// particles, one count per loop pass, rendering into the render bench's buffer. It
+// uses the effect's particle pool, so it is refused while the particles effect runs.
+static const int __particleBenchCounts[] = { 10, 100, 1000 };
+static const int __PARTICLE_BENCH_CASE_COUNT = sizeof(__particleBenchCounts) / sizeof(__particleBenchCounts[0]);
+static const int __PARTICLE_BENCH_FRAMES = 20;
+static int __particleBenchCase = -1; // -1 when idle
+
+void startParticleBench() {
+    if (__activeLedEffect == EFFECT_PARTICLES) {
+        log_t("particle_bench ignored: switch off the particles effect first.");
+        return;
+    }
+    __particleBenchCase = 0;
+}
+
+void serviceParticleBench() {
+    if (__particleBenchCase < 0) return;
+    if (__activeLedEffect == EFFECT_PARTICLES) {
+        log_t("particle_bench stopped: the particles effect started.");
+        __particleBenchCase = -1;
+        return;
+    }
+    int count = __particleBenchCounts[__particleBenchCase];
+    ParticleSystem::reset();
+    // Lives far longer than the run, so the count holds throughout.
+    ParticleSystem::burst(__LOGICAL_NUM_LEDS / 2, count, 60, 0, 60000);
+    ParticleSystem::setGravity(-5);
+    uint32_t startUs = EventTracer::now();
+    for (int i = 0; i < __PARTICLE_BENCH_FRAMES; i++) {
+        ParticleSystem::update(16);
+        ParticleSystem::render((uint8_t*)__renderBenchLeds, __particleHueRgb);
+    }
+    uint32_t frameUs = (EventTracer::now() - startUs) / __PARTICLE_BENCH_FRAMES;
+    log_t("particle_bench %4d particles (%4d live at the end): %5lu us/frame, %4lu ns/particle", count,
+          ParticleSystem::liveCount(), (unsigned long)frameUs, (unsigned long)(frameUs * 1000UL / count));
+    if (++__particleBenchCase < __PARTICLE_BENCH_CASE_COUNT) return;
+    __particleBenchCase = -1;
+    ParticleSystem::reset();
+    log_t("particle_bench done.");
+}
+
+// --- Frame Output ---
+// Set at the start of the effect stage each loop pass so showStrip() can record the
+// render span that produced the frame. Zero means "not inside an effect render".
+static uint32_t __frameRenderStartUs = 0;
+
+/**
+ * @brief Pushes the frame buffer to the strip. All effect renders go through here so
+ * frame timing can be traced in one place.
+ */
+void showStrip() {
+    if (EventTracer::isEnabled()) {
+        if (__frameRenderStartUs != 0) {
+            EventTracer::recordAt(__frameRenderStartUs, EventTracer::TRACE_BEGIN, EventTracer::EV_FRAME_RENDER);
+            EventTracer::end(EventTracer::EV_FRAME_RENDER);
+        }
+        EventTracer::begin(EventTracer::EV_SHOW);
+    }
+    // The brightness last set by applyBrightness() (display brightness scaled by the global
+    // master brightness), lowered by the power budget if the frame would draw too much.
+    FastLED.show(PowerBudget::limitFrame((const uint8_t*)__leds, __NUM_LEDS, FastLED.getBrightness(),
+                                         ledEffectName(__activeLedEffect), millis()));
+    EventTracer::end(EventTracer::EV_SHOW);
+    CommandAck::frameShown(EventTracer::now());
+    LcdDashboard::submitFrame((const uint8_t*)__leds, __NUM_LEDS, millis());
+}
+
+/**
+ * @brief Blacks out every LED at once. Shown through showStrip(), so acknowledgements
+ * and the LCD preview see the blackout like any other frame.
+ */
+void blackoutStrip() {
+    FastLED.clearData();
+    showStrip();
 }
 
 /**
@@ -352,7 +1180,7 @@ void applySpeedSyncLookup(int speed) {
         return;
     }
 
-    float targetRevTime = calculate_rev_time_ms(speed);
+    float targetRevTime = calculateRevTimeMs<Sculpture>(speed);
     __ledIntervalMs = targetRevTime / (float)__LOGICAL_NUM_LEDS;
 }
 
@@ -395,19 +1223,6 @@ void setMotorDuty(int duty, bool clockwise) {
     }
 }
 
-/**
- * @brief Maps a linear logical speed (0-1000) to the non-linear physical PWM duty cycle.
- * This accounts for the motor's dead zone.
- * 
- * @param logicalSpeed The desired speed on a linear scale.
- * @return The calculated PWM duty cycle for the motor.
- */
-int mapSpeedToDuty(int logicalSpeed) {
-    if (logicalSpeed <= 0) return 0;
-    // Map the logical speed (1-1000) to the physical PWM duty range (MIN to MAX)
-    return map(logicalSpeed, 1, __LOGICAL_MAX_SPEED, __PHYSICAL_MIN_SPEED, __PHYSICAL_MAX_SPEED);
-}
-
 /**
  * @brief Calculates the delay between ramp steps to achieve a specific duration.
  */
@@ -423,7 +1238,7 @@ void triggerStart() {
     if (!__isMotorRunning) {
         __rampStartSpeed = __currentLogicalSpeed;
         __rampStartTime = millis();
-        __led_position = 0; // Start LED cycle at the beginning
+        resetCometPositions(); // Start LED cycle at the beginning
         __targetLogicalSpeed = __speedSetting;
         applySpeedSyncLookup(__targetLogicalSpeed);
         updateRampTiming();
@@ -504,7 +1319,7 @@ void triggerSetSpeed(int newSpeed) {
     applySpeedSyncLookup(__targetLogicalSpeed);
     updateRampTiming();
     if (!__isMotorRunning) {
-        __led_position = 0; // Start LED cycle at the beginning
+        resetCometPositions(); // Start LED cycle at the beginning
         __isMotorRunning = true;
     }
 
@@ -516,113 +1331,147 @@ void triggerSetSpeed(int newSpeed) {
 }
 
 // --- BLE Command Handoff ---
-static char __bleCommandBuffer[128];
-static volatile bool __bleCommandAvailable = false;
+// BLE writes are queued in CommandQueue (a fixed ring) and processed by loop().
+
+// Script transport, defined with the script engine helpers further down.
+void pauseScript();
+void resumeScript();
+void seekScriptToTime(uint32_t ms);
+void skipScriptPhase(int direction);
+void reportScriptStatus();
+void generateAutoScript(AutoModeType type, int minutes, uint32_t seed);
+// Blink envelope, defined with the effect implementations.
+void buildBlinkEnvelope(BlinkState& blink);
 
 /**
  * @brief Processes a single command string.
+ * @return RESULT_APPLIED; RESULT_INVALID if the command was not recognised, or its
+ *         parameters were malformed or out of range for anything to happen (values
+ *         inside a usable range are clamped and applied); RESULT_IGNORED if it is not
+ *         allowed right now (script transport with no script running, gen_bench
+ *         during a script).
+ *
+ * This and runScriptCommand() only build for the device: each command's branch changes
+ * the show state, calls beginEffect(), triggers the motor or reaches NVS and LittleFS.
+ * The host harnesses (src/sim/command_fuzz.cpp, test/test_perf_budget) stop at the
+ * parsing, routing and CommandLimits checks in front of it; fire's cooling and sparks
+ * and the noise itself (inoise8()) stay on the device too. On the device, each command is an EV_COMMAND span in the event
+ * trace (trace_dump) and counts toward the loop watchdog, and render_bench times the
+ * StripRender stages with the real noise.
  */
-void processCommand(std::string value) {
-    if (value.length() == 0) return;
+CommandAck::Result processCommand(const char* value) {
+    if (value[0] == '\0') return CommandAck::RESULT_INVALID;
 
     // Per user request, lines starting with '[' are comments.
     // They are logged by the script engine but otherwise ignored here.
     if (value[0] == '[') {
-        return;
+        return CommandAck::RESULT_APPLIED;
     }
 
-    size_t colon_pos = value.find(':');
+    // Parsed in place: no command path allocates.
+    char cmd[CommandParser::MAX_NAME_LEN + 1];
+    const char* params = nullptr;
+    if (!CommandParser::split(value, cmd, &params)) {
+        log_t("Invalid command format: %s", value);
+        return CommandAck::RESULT_INVALID;
+    }
 
-    if (colon_pos != std::string::npos) {
-        std::string cmd = value.substr(0, colon_pos);
-        int val = atoi(value.substr(colon_pos + 1).c_str());
+    if (params != nullptr) {
+        int val = atoi(params);
 
-        if (cmd == "motor_speed") {
+        if (strcmp(cmd, "motor_speed") == 0) {
             val = constrain(val, 0, __LOGICAL_MAX_SPEED);
             triggerSetSpeed(val);
-        } else if (cmd == "motor_ramp") {
+        } else if (strcmp(cmd, "motor_ramp") == 0) {
             val = constrain(val, 0, 10000);
             __currentRampDuration = val;
             log_t("Set Motor Ramp Duration: %d", __currentRampDuration);
-        } else if (cmd == "led_global_brightness") {
+        } else if (strcmp(cmd, "led_global_brightness") == 0) {
             int brightness_pct = constrain(val, 0, 100);
             __globalMasterBrightness = (uint8_t)((brightness_pct * 255) / 100);
+            PowerBudget::setMasterBrightness(__globalMasterBrightness);
             // If a pulse effect isn't active, we must re-apply the last static display brightness.
             // This ensures the new global master brightness takes effect immediately by re-scaling the current display level.
             if (!__isPulseSineActive) {
                 setFinalBrightnessFromDisplayPercent(__lastDisplayBrightnessPercent);
             }
             log_t("LED Global Master Brightness set to: %d%% (%d/255)", brightness_pct, __globalMasterBrightness);
-        } else if (cmd == "led_display_brightness") {
+        } else if (strcmp(cmd, "led_display_brightness") == 0) {
             // Deactivate any running pulse effect. Setting a static display brightness
             // is mutually exclusive with a dynamic pulse, so the static command takes precedence.
             __isPulseSineActive = false;
             int brightness_pct = constrain(val, 0, 100);
             setFinalBrightnessFromDisplayPercent(brightness_pct);
             log_t("LED Display Brightness set to: %d%%", brightness_pct);
-        } else if (cmd == "led_background") {
-            std::string params = value.substr(colon_pos + 1);
-            size_t comma_pos = params.find(',');
-            if (comma_pos != std::string::npos) {
-                int h = atoi(params.substr(0, comma_pos).c_str());
-                int b_pct = atoi(params.substr(comma_pos + 1).c_str());
+        } else if (strcmp(cmd, "led_background") == 0) {
+            int p[2];
+            if (CommandParser::parseInts(params, p, 2) >= 2) {
+                int h = p[0];
+                int b_pct = p[1];
                 __bgHue = (uint8_t)constrain(h, 0, 255);
                 __bgBrightness = (uint8_t)((constrain(b_pct, 0, 50) * 255) / 100);
                 log_t("LED Background set to Hue: %d, Brightness: %d%% (%d)", __bgHue, b_pct, __bgBrightness);
+            } else {
+                log_t("Invalid parameters for %s: %s", cmd, params);
+                return CommandAck::RESULT_INVALID;
             }
-        } else if (cmd == "led_tails") {
-            __activeLedEffect = EFFECT_COMET;
-            std::string params = value.substr(colon_pos + 1);
-            size_t comma1 = params.find(',');
-            size_t comma2 = params.find(',', comma1 + 1);
-            if (comma1 != std::string::npos && comma2 != std::string::npos) {
-                int h = atoi(params.substr(0, comma1).c_str());
-                int l = atoi(params.substr(comma1 + 1, comma2 - (comma1 + 1)).c_str());
-                int c = atoi(params.substr(comma2 + 1).c_str());
-                if (c == 0 || (c * l <= __LOGICAL_NUM_LEDS * 0.8)) {
+        } else if (strcmp(cmd, "led_tails") == 0) {
+            int p[3];
+            if (CommandParser::parseInts(params, p, 3) >= 3) {
+                int h = p[0];
+                int l = p[1];
+                int c = p[2];
+                if (CommandLimits::cometsFit(c, l, __LOGICAL_NUM_LEDS)) {
+                    beginEffect(EFFECT_COMET);
                     __cometHue = (uint8_t)constrain(h, 0, 255);
                     __cometTailLength = max(1, l);
                     __cometCount = max(0, c);
                     log_t("LED Tails set: Hue %d, Length %d, Count %d", __cometHue, __cometTailLength, __cometCount);
                 } else {
-                    log_t("Tails command ignored: exceeds 80%% of strip.");
+                    log_t("Tails command rejected: exceeds 80%% of strip.");
+                    return CommandAck::RESULT_INVALID;
                 }
+            } else {
+                log_t("Invalid parameters for %s: %s", cmd, params);
+                return CommandAck::RESULT_INVALID;
             }
-        } else if (cmd == "led_cycle_time") {
+        } else if (strcmp(cmd, "led_cycle_time") == 0) {
             if (val > 0) {
                 __isManualLedInterval = true;
                 __manualLedIntervalMs = (float)val / (float)__LOGICAL_NUM_LEDS;
                 __manualSpeedReference = (__currentLogicalSpeed > 0) ? __currentLogicalSpeed : __speedSetting;
                 __ledIntervalMs = __manualLedIntervalMs;
                 log_t("LED Manual Sync set at speed %d. Step interval: %.2f ms", __manualSpeedReference, __ledIntervalMs);
+            } else {
+                log_t("Invalid cycle time: %s (must be over 0 ms)", params);
+                return CommandAck::RESULT_INVALID;
             }
-        } else if (cmd == "system_off") {
+        } else if (strcmp(cmd, "system_off") == 0) {
             __pendingOff = true;
-        } else if (cmd == "run_script") {
-            std::string scriptName = value.substr(colon_pos + 1);
-            if (scriptName == "funky") {
-                __activeScriptCommands = __script_funky;
-                __scriptCommandIndex = 0;
-                __scriptStartTime = __scriptLastCommandTime = millis();
-                __scriptHoldDuration = 0;
-                __isScriptRunning = true;
+        } else if (strcmp(cmd, "run_script") == 0) {
+            if (strcmp(params, "funky") == 0) {
+                __activeScript.clear();
+                for (size_t i = 0; i < sizeof(__script_funky) / sizeof(__script_funky[0]); i++) {
+                    __activeScript.push(__script_funky[i]);
+                }
+                beginScriptPlayback();
                 __autoModeType = AUTO_MODE_NONE; // This is not an auto-mode script
                 log_t("Script started: funky");
+            } else {
+                log_t("Unknown script: %s", params);
+                return CommandAck::RESULT_INVALID;
             }
-        } else if (cmd == "auto_mode" || cmd == "auto_mode_debug") {
+        } else if (strcmp(cmd, "auto_mode") == 0 || strcmp(cmd, "auto_mode_debug") == 0) {
             int duration_minutes = constrain(val, 1, 240); // Constrain to 1min - 4hours
 
             // Stop any currently running script
             __isScriptRunning = false;
             __autoModeType = AUTO_MODE_NONE; // Stop any previous auto mode loop
 
-            __activeScriptCommands = AutoGenerator::generateScript(duration_minutes);
+            generateAutoScript(AUTO_MODE_NORMAL, duration_minutes, 0);
 
-            if (cmd == "auto_mode" && !__activeScriptCommands.empty()) {
-                __scriptCommandIndex = 0;
-                __scriptStartTime = __scriptLastCommandTime = millis();
-                __scriptHoldDuration = 0;
-                __isScriptRunning = true;
+            if (strcmp(cmd, "auto_mode") == 0 && !__activeScript.empty()) {
+                beginScriptPlayback();
                 __autoModeType = AUTO_MODE_NORMAL;
                 __autoModeDurationMinutes = duration_minutes;
                 log_t("Auto-mode script started for %d minutes.", duration_minutes);
@@ -630,83 +1479,154 @@ void processCommand(std::string value) {
                 // For debug mode, ensure auto mode is not active
                 __autoModeType = AUTO_MODE_NONE;
                 log_t("Auto-mode debug script generated for %d minutes. Not executing.", duration_minutes);
+                startScriptDump(SCRIPT_DUMP_SERIAL, "AUTO-GENERATED SCRIPT");
             }
-        } else if (cmd == "auto_steady_rotate" || cmd == "auto_steady_rotate_debug") {
+        } else if (strcmp(cmd, "auto_steady_rotate") == 0 || strcmp(cmd, "auto_steady_rotate_debug") == 0) {
             int duration_minutes = constrain(val, 1, 240);
 
             __isScriptRunning = false;
             __autoModeType = AUTO_MODE_NONE; 
 
-            __activeScriptCommands = AutoGenerator::generateSteadyRotateScript(duration_minutes);
+            generateAutoScript(AUTO_MODE_STEADY_ROTATE, duration_minutes, 0);
 
-            if (cmd == "auto_steady_rotate" && !__activeScriptCommands.empty()) {
-                __scriptCommandIndex = 0;
-                __scriptStartTime = __scriptLastCommandTime = millis();
-                __scriptHoldDuration = 0;
-                __isScriptRunning = true;
+            if (strcmp(cmd, "auto_steady_rotate") == 0 && !__activeScript.empty()) {
+                beginScriptPlayback();
                 __autoModeType = AUTO_MODE_STEADY_ROTATE;
                 __autoModeDurationMinutes = duration_minutes;
                 log_t("Auto-steady-rotate script started for %d minutes.", duration_minutes);
             } else {
                 __autoModeType = AUTO_MODE_NONE;
                 log_t("Auto-steady-rotate debug script generated for %d minutes. Not executing.", duration_minutes);
+                startScriptDump(SCRIPT_DUMP_SERIAL, "AUTO-STEADY-ROTATE SCRIPT");
             }
-        } else if (cmd == "hold") {
-            if (__isScriptRunning) {
-                __scriptHoldDuration = val;
+        } else if (strcmp(cmd, "script_seek") == 0) {
+            if (!__isScriptRunning) {
+                log_t("Seek ignored: no script running.");
+                return CommandAck::RESULT_IGNORED;
+            } else {
+                seekScriptToTime(CommandLimits::seekMs(val));
             }
-        } else if (cmd == "led_blink") {
-            // led_blink:HHH,BB,XXXX,YYYY,C
-            std::string params = value.substr(colon_pos + 1);
-            size_t c1 = params.find(',');
-            size_t c2 = params.find(',', c1 + 1);
-            size_t c3 = params.find(',', c2 + 1);
-            if (c1 != std::string::npos && c2 != std::string::npos && c3 != std::string::npos) {
-                int h = atoi(params.substr(0, c1).c_str());
-                int b = atoi(params.substr(c1 + 1, c2 - (c1 + 1)).c_str());
-                int u = atoi(params.substr(c2 + 1, c3 - (c2 + 1)).c_str());
+        } else if (strcmp(cmd, "hold") == 0) {
+            if (!__isScriptRunning) return CommandAck::RESULT_IGNORED; // Only means something as a script step
+            __scriptHoldDuration = val;
+        } else if (strcmp(cmd, "led_blink") == 0) {
+            // led_blink:HHH,BB,XXXX,YYYY,C[,EASE]
+            int p[5];
+            int fields = CommandParser::parseInts(params, p, 5);
+            char easeName[12] = "quadratic";
+            if (fields >= 6) CommandParser::copyField(params, 5, easeName, sizeof(easeName));
+            BlinkEase ease;
+            bool easeKnown = true;
+            if (strcmp(easeName, "linear") == 0) ease = BLINK_EASE_LINEAR;
+            else if (strcmp(easeName, "quadratic") == 0) ease = BLINK_EASE_QUADRATIC;
+            else if (strcmp(easeName, "gamma") == 0) ease = BLINK_EASE_GAMMA;
+            else easeKnown = false;
+            if (fields >= 4 && easeKnown) {
+                int h = p[0];
+                int b = p[1];
+                int u = p[2];
+                int d = p[3];
+                int count = (fields >= 5) ? p[4] : 0;
+                
+                beginEffect(EFFECT_BLINK);
+                BlinkState& blink = __effectState.blink;
+                blink.hue = (uint8_t)constrain(h, 0, 255);
+                blink.maxBri = (uint8_t)((constrain(b, 0, 100) * 255) / 100);
+                blink.upDuration = (unsigned long)max(1UL, (unsigned long)u);
+                blink.downDuration = (unsigned long)max(1UL, (unsigned long)d);
+                blink.targetCount = count;
+                blink.ease = ease;
+                buildBlinkEnvelope(blink);
                 
-                int d = 0;
-                int count = 0;
-                size_t c4 = params.find(',', c3 + 1);
-                if (c4 != std::string::npos) {
-                    d = atoi(params.substr(c3 + 1, c4 - (c3 + 1)).c_str());
-                    count = atoi(params.substr(c4 + 1).c_str());
+                blackoutStrip();
+                blink.startTime = millis();
+                log_t("LED Blink set: Hue %d, MaxBri %d, Up %lu, Down %lu, Count %d, Ease %s", blink.hue, b, blink.upDuration, blink.downDuration, blink.targetCount, easeName);
+            } else {
+                log_t("Invalid parameters for %s: %s", cmd, params);
+                return CommandAck::RESULT_INVALID;
+            }
+        } else if (strcmp(cmd, "led_emitter") == 0) {
+            // led_emitter:SLOT,POS,RATE,SPEED,SPREAD,HUE,LIFE
+            int p[7];
+            if (CommandParser::parseInts(params, p, 7) < 7 || p[0] < 0 || p[0] >= ParticleSystem::MAX_EMITTERS) {
+                log_t("Invalid parameters for %s: %s", cmd, params);
+                return CommandAck::RESULT_INVALID;
+            }
+            ensureParticlesEffect();
+            ParticleSystem::setEmitter(p[0], constrain(p[1], 0, __LOGICAL_NUM_LEDS - 1), p[2], p[3], p[4],
+                                       (uint8_t)constrain(p[5], 0, 255), (uint16_t)constrain(p[6], 0, 65535));
+            log_t("Particle emitter %d: LED %d, %d/s, speed %d +/- %d, hue %d, life %d ms (%d active)", p[0], p[1], p[2],
+                  p[3], p[4], p[5], p[6], ParticleSystem::activeEmitters());
+        } else if (strcmp(cmd, "led_gravity") == 0) {
+            ensureParticlesEffect();
+            ParticleSystem::setGravity(val);
+            log_t("Particle gravity: %d LEDs/s^2", ParticleSystem::gravity());
+        } else if (strcmp(cmd, "led_burst") == 0) {
+            // led_burst:POS,COUNT,SPEED,HUE,LIFE
+            int p[5];
+            if (CommandParser::parseInts(params, p, 5) < 5) {
+                log_t("Invalid parameters for %s: %s", cmd, params);
+                return CommandAck::RESULT_INVALID;
+            }
+            ensureParticlesEffect();
+            int added = ParticleSystem::burst(constrain(p[0], 0, __LOGICAL_NUM_LEDS - 1), max(0, p[1]), p[2],
+                                              (uint8_t)constrain(p[3], 0, 255), (uint16_t)constrain(p[4], 0, 65535));
+            log_t("Particle burst: %d of %d added, %d live", added, p[1], ParticleSystem::liveCount());
+        } else if (strcmp(cmd, "led_comet_group") == 0) {
+            // led_comet_group:GROUP,COUNT,TAIL,HUE,SPEED,DIR
+            int p[6];
+            char hueField[12];
+            if (CommandParser::parseInts(params, p, 6) < 6 || p[0] < 1 || p[0] >= __COMET_GROUPS ||
+                !CommandParser::copyField(params, 3, hueField, sizeof(hueField))) {
+                log_t("Invalid parameters for %s: %s", cmd, params);
+                return CommandAck::RESULT_INVALID;
+            }
+            int count = max(0, p[1]);
+            int tail = constrain(p[2], 1, 255);
+            if (!CommandLimits::cometsFit(count, tail, __LOGICAL_NUM_LEDS)) {
+                log_t("Comet group command rejected: exceeds 80%% of strip.");
+                return CommandAck::RESULT_INVALID;
+            } else {
+                beginEffect(EFFECT_COMET);
+                CometGroup& group = __cometGroups[p[0]];
+                if (group.count == 0) group.position = __cometGroups[0].position; // Start level with led_tails' comets
+                group.count = count;
+                group.tailLength = (uint8_t)tail;
+                if (strcmp(hueField, "shared") == 0) {
+                    group.hueSource = COMET_HUE_SHARED;
+                    group.hue = 0;
+                } else if (hueField[0] == '+' || hueField[0] == '-') {
+                    group.hueSource = COMET_HUE_OFFSET;
+                    group.hue = (uint8_t)atoi(hueField);
                 } else {
-                    d = atoi(params.substr(c3 + 1).c_str());
-                    count = 0;
+                    group.hueSource = COMET_HUE_FIXED;
+                    group.hue = (uint8_t)constrain(p[3], 0, 255);
                 }
-                
-                __blinkHue = (uint8_t)constrain(h, 0, 255);
-                __blinkMaxBri = (uint8_t)((constrain(b, 0, 100) * 255) / 100);
-                __blinkUpDuration = (unsigned long)max(1UL, (unsigned long)u);
-                __blinkDownDuration = (unsigned long)max(1UL, (unsigned long)d);
-                __blinkTargetCount = count;
-                
-                FastLED.clear(true);
-                __blinkStartTime = millis();
-                __activeLedEffect = EFFECT_BLINK;
-                log_t("LED Blink set: Hue %d, MaxBri %d, Up %lu, Down %lu, Count %d", __blinkHue, b, __blinkUpDuration, __blinkDownDuration, __blinkTargetCount);
+                group.speedPercent = (uint16_t)constrain(p[4], 0, (int)__COMET_MAX_SPEED_PERCENT);
+                group.direction = (p[5] < 0) ? -1 : 1;
+                log_t("Comet group %d: %d comets, tail %d, hue %s, speed %d%%, direction %d", p[0], count, tail, hueField,
+                      group.speedPercent, group.direction);
             }
-        } else if (cmd == "led_sine_hue") {
+        } else if (strcmp(cmd, "led_sine_hue") == 0) {
             // led_sine_hue:LOW,HIGH
-            std::string params = value.substr(colon_pos + 1);
-            size_t c1 = params.find(',');
-            if (c1 != std::string::npos) {
-                __hueSineLow = (uint8_t)atoi(params.substr(0, c1).c_str());
-                __hueSineHigh = (uint8_t)atoi(params.substr(c1 + 1).c_str());
+            int p[2];
+            if (CommandParser::parseInts(params, p, 2) >= 2) {
+                __hueSineLow = (uint8_t)p[0];
+                __hueSineHigh = (uint8_t)p[1];
                 __isHueSineActive = true;
                 __isRainbowActive = false;
                 if (__cometCount == 0) __cometCount = 1; // Ensure visibility
                 log_t("LED Sine Hue: Range %d-%d (Sync BPM)", __hueSineLow, __hueSineHigh);
+            } else {
+                log_t("Invalid parameters for %s: %s", cmd, params);
+                return CommandAck::RESULT_INVALID;
             }
-        } else if (cmd == "led_sine_pulse") {
+        } else if (strcmp(cmd, "led_sine_pulse") == 0) {
             // led_sine_pulse:LOW,HIGH
-            std::string params = value.substr(colon_pos + 1);
-            size_t c1 = params.find(',');
-            if (c1 != std::string::npos) {
-                int low_pct = atoi(params.substr(0, c1).c_str());
-                int high_pct = atoi(params.substr(c1 + 1).c_str());
+            int p[2];
+            if (CommandParser::parseInts(params, p, 2) >= 2) {
+                int low_pct = p[0];
+                int high_pct = p[1];
                 
                 __pulseSineLow = (uint8_t)((constrain(low_pct, 0, 100) * 255) / 100);
                 __pulseSineHigh = (uint8_t)((constrain(high_pct, 0, 100) * 255) / 100);
@@ -717,100 +1637,198 @@ void processCommand(std::string value) {
                     __bgBrightness = 76; // Default to 30% floor
                 }
                 log_t("LED Sine Pulse: Range %d%%-%d%% (Sync BPM)", low_pct, high_pct);
+            } else {
+                log_t("Invalid parameters for %s: %s", cmd, params);
+                return CommandAck::RESULT_INVALID;
             }
-        } else if (cmd == "led_effect") {
-            std::string params = value.substr(colon_pos + 1);
-            size_t c1 = params.find(',');
-            std::string effectName = (c1 != std::string::npos) ? params.substr(0, c1) : params;
-
-            if (effectName == "fire") {
-                __activeLedEffect = EFFECT_FIRE;
+        } else if (strcmp(cmd, "led_effect") == 0) {
+            // led_effect:NAME,P1,P2,P3. p[0] is the name field and is ignored.
+            char effectName[16];
+            CommandParser::copyField(params, 0, effectName, sizeof(effectName));
+            int p[4];
+            int fields = CommandParser::parseInts(params, p, 4);
+
+            if (strcmp(effectName, "fire") == 0) {
+                beginEffect(EFFECT_FIRE);
                 log_t("LED Effect: Fire");
-            } else if (effectName == "twinkle") {
-                size_t c2 = params.find(',', c1 + 1);
-                if (c1 != std::string::npos && c2 != std::string::npos) {
-                    __twinkle_hue = atoi(params.substr(c1 + 1, c2 - (c1 + 1)).c_str());
-                    __twinkle_density = constrain(atoi(params.substr(c2 + 1).c_str()), 1, 255);
+            } else if (strcmp(effectName, "twinkle") == 0) {
+                beginEffect(EFFECT_TWINKLE);
+                TwinkleState& twinkle = __effectState.twinkle;
+                if (fields >= 3) {
+                    twinkle.hue = p[1];
+                    twinkle.density = constrain(p[2], 1, 255);
                 } else { // allow just hue
-                    __twinkle_hue = atoi(params.substr(c1 + 1).c_str());
-                    __twinkle_density = 50;
+                    twinkle.hue = (fields >= 2) ? p[1] : 0;
                 }
-                __activeLedEffect = EFFECT_TWINKLE;
-                log_t("LED Effect: Twinkle (Hue: %d, Density: %d)", __twinkle_hue, __twinkle_density);
-            } else if (effectName == "marquee") {
-                size_t c2 = params.find(',', c1 + 1);
-                size_t c3 = params.find(',', c2 + 1);
-                if (c1 != std::string::npos && c2 != std::string::npos && c3 != std::string::npos) {
-                    __marquee_hue = atoi(params.substr(c1 + 1, c2 - (c1 + 1)).c_str());
-                    __marquee_lit_width = max(1, atoi(params.substr(c2 + 1, c3 - (c2 + 1)).c_str()));
-                    __marquee_dark_width = max(1, atoi(params.substr(c3 + 1).c_str()));
-                    __activeLedEffect = EFFECT_MARQUEE;
-                    log_t("LED Effect: Marquee (Hue: %d, Lit: %d, Dark: %d). Speed now follows led_cycle_time.", __marquee_hue, __marquee_lit_width, __marquee_dark_width);
+                log_t("LED Effect: Twinkle (Hue: %d, Density: %d)", twinkle.hue, twinkle.density);
+            } else if (strcmp(effectName, "marquee") == 0) {
+                if (fields >= 4) {
+                    beginEffect(EFFECT_MARQUEE);
+                    MarqueeState& marquee = __effectState.marquee;
+                    marquee.hue = p[1];
+                    marquee.litWidth = max(1, p[2]);
+                    marquee.darkWidth = max(1, p[3]);
+                    log_t("LED Effect: Marquee (Hue: %d, Lit: %d, Dark: %d). Speed now follows led_cycle_time.", marquee.hue, marquee.litWidth, marquee.darkWidth);
                 } else {
                     log_t("Invalid marquee parameters. Expected: H,LW,DW");
+                    return CommandAck::RESULT_INVALID;
                 }
-            } else if (effectName == "noise") {
-                size_t c2 = params.find(',', c1 + 1);
-                size_t c3 = params.find(',', c2 + 1);
-                if (c1 != std::string::npos && c2 != std::string::npos && c3 != std::string::npos) {
-                    std::string paletteName = params.substr(c1 + 1, c2 - (c1 + 1));
-                    int speed_val = atoi(params.substr(c2 + 1, c3 - (c2 + 1)).c_str());
-                    int scale = atoi(params.substr(c3 + 1).c_str());
-
-                    if (paletteName == "lava") __noise_palette = LavaColors_p;
-                    else if (paletteName == "cloud") __noise_palette = CloudColors_p;
-                    else if (paletteName == "ocean") __noise_palette = OceanColors_p;
-                    else if (paletteName == "forest") __noise_palette = ForestColors_p;
-                    else if (paletteName == "party") __noise_palette = PartyColors_p;
-                    else __noise_palette = RainbowColors_p;
-
-                    __noise_x = random16();
-                    __noise_y = random16();
-                    __noise_z = random16();
-                    __noise_speed = (uint8_t)constrain(speed_val, 0, 255);
-                    __noise_scale = (uint8_t)constrain(scale, 1, 150);
-                    __activeLedEffect = EFFECT_NOISE;
-                    log_t("LED Effect: Noise (Palette: %s, Speed: %d, Scale: %d)", paletteName.c_str(), speed_val, scale);
+            } else if (strcmp(effectName, "particles") == 0) {
+                beginEffect(EFFECT_PARTICLES);
+                if (fields >= 2) __effectState.particles.fade = (uint8_t)constrain(p[1], 0, 255);
+                log_t("LED Effect: Particles (Fade: %d). Add them with led_emitter and led_burst.", __effectState.particles.fade);
+            } else if (strcmp(effectName, "noise") == 0) {
+                if (fields >= 4) {
+                    char paletteName[16];
+                    CommandParser::copyField(params, 1, paletteName, sizeof(paletteName));
+                    int speed_val = p[2];
+                    int scale = p[3];
+
+                    beginEffect(EFFECT_NOISE);
+                    NoiseState& noise = __effectState.noise;
+                    if (strcmp(paletteName, "lava") == 0) noise.palette = LavaColors_p;
+                    else if (strcmp(paletteName, "cloud") == 0) noise.palette = CloudColors_p;
+                    else if (strcmp(paletteName, "ocean") == 0) noise.palette = OceanColors_p;
+                    else if (strcmp(paletteName, "forest") == 0) noise.palette = ForestColors_p;
+                    else if (strcmp(paletteName, "party") == 0) noise.palette = PartyColors_p;
+                    else noise.palette = RainbowColors_p;
+                    buildNoisePaletteTable(noise.palette);
+
+                    noise.x = random16();
+                    noise.y = random16();
+                    noise.z = random16();
+                    noise.speed = (uint8_t)constrain(speed_val, 0, 255);
+                    noise.scale = (uint8_t)constrain(scale, 1, 150);
+                    log_t("LED Effect: Noise (Palette: %s, Speed: %d, Scale: %d)", paletteName, speed_val, scale);
+                } else {
+                    log_t("Invalid parameters for %s: %s", cmd, params);
+                    return CommandAck::RESULT_INVALID;
                 }
-            } else if (effectName == "none") {
-                __activeLedEffect = EFFECT_COMET;
+            } else if (strcmp(effectName, "none") == 0) {
+                beginEffect(EFFECT_COMET);
                 if (__cometCount == 0) __cometCount = 1;
                 log_t("LED Effect: None (reverted to Comet)");
             } else {
-                log_t("Unknown effect name: %s", effectName.c_str());
+                log_t("Unknown effect name: %s", effectName);
+                return CommandAck::RESULT_INVALID;
             }
 
 
+        } else if (strcmp(cmd, "lcd") == 0) {
+            const char* mode = params;
+            if (strcmp(mode, "dashboard") == 0) {
+                LcdDashboard::setMode(LcdDashboard::MODE_DASHBOARD);
+                log_t("LCD: dashboard");
+            } else if (strcmp(mode, "preview") == 0) {
+                LcdDashboard::setMode(LcdDashboard::MODE_PREVIEW);
+                log_t("LCD: strip preview (max %lu fps)", (unsigned long)(1000 / LcdDashboard::PREVIEW_INTERVAL_MS));
+            } else if (strcmp(mode, "off") == 0) {
+                LcdDashboard::setMode(LcdDashboard::MODE_OFF);
+                log_t("LCD: off");
+            } else {
+                log_t("Invalid LCD mode: %s", mode);
+                return CommandAck::RESULT_INVALID;
+            }
+        } else if (strcmp(cmd, "trace") == 0) {
+            const char* action = params;
+            if (strcmp(action, "on") == 0) {
+                EventTracer::setEnabled(true);
+                log_t("Event trace recording ON (%d event ring).", EVENT_TRACE_CAPACITY);
+            } else if (strcmp(action, "off") == 0) {
+                EventTracer::setEnabled(false);
+                log_t("Event trace recording OFF. %u events held.", (unsigned)EventTracer::count());
+            } else if (strcmp(action, "clear") == 0) {
+                EventTracer::clear();
+                log_t("Event trace cleared.");
+            } else if (strcmp(action, "dump") == 0) {
+                startTraceDump(TRACE_DUMP_SERIAL);
+            } else if (strcmp(action, "dump_ble") == 0) {
+                startTraceDump(TRACE_DUMP_BLE);
+            } else {
+                log_t("Invalid trace action: %s", action);
+                return CommandAck::RESULT_INVALID;
+            }
+        } else if (strcmp(cmd, "render_split") == 0) {
+            if (strcmp(params, "on") == 0 || strcmp(params, "off") == 0) {
+                ParallelRender::setEnabled(strcmp(params, "on") == 0);
+                log_t("Split rendering %s (%lu join timeouts since boot).", ParallelRender::isEnabled() ? "ON" : "OFF",
+                      (unsigned long)ParallelRender::joinTimeouts());
+            } else {
+                log_t("Invalid render_split mode: %s", params);
+                return CommandAck::RESULT_INVALID;
+            }
+        } else if (strcmp(cmd, "sys_stats") == 0) {
+            if (strcmp(params, "ble") != 0) {
+                log_t("Invalid sys_stats action: %s", params);
+                return CommandAck::RESULT_INVALID;
+            }
+            reportSysStats(true);
+        } else if (strcmp(cmd, "loop_budget") == 0) {
+            LoopWatchdog::setBudgetUs((uint32_t)constrain(val, 1000, 1000000));
+            log_t("Loop budget set to %lu us.", (unsigned long)LoopWatchdog::budgetUs());
+        } else if (strcmp(cmd, "loop_watchdog") == 0) {
+            if (strcmp(params, "ble") == 0) {
+                __watchdogDumpIndex = 0;
+            } else if (strcmp(params, "clear") == 0) {
+                LoopWatchdog::clear();
+                log_t("Loop watchdog cleared.");
+            } else {
+                log_t("Invalid loop_watchdog action: %s", params);
+                return CommandAck::RESULT_INVALID;
+            }
+        } else if (strcmp(cmd, "script_dump") == 0) {
+            if (strcmp(params, "serial") == 0) {
+                startScriptDump(SCRIPT_DUMP_SERIAL, "ACTIVE SCRIPT");
+            } else if (strcmp(params, "file") == 0) {
+                startScriptDump(SCRIPT_DUMP_FILE, "ACTIVE SCRIPT");
+            } else if (strcmp(params, "off") == 0) {
+                if (__scriptDumpTarget != SCRIPT_DUMP_NONE) endScriptDump("stopped");
+            } else {
+                log_t("Invalid script_dump target: %s", params);
+                return CommandAck::RESULT_INVALID;
+            }
+        } else if (strcmp(cmd, "gen_bench") == 0) {
+            if (!startGenBench(val)) return CommandAck::RESULT_IGNORED;
+        } else if (strcmp(cmd, "auto_templates") == 0) {
+            if (strcmp(params, "reload") != 0) {
+                log_t("Invalid auto_templates action: %s", params);
+                return CommandAck::RESULT_INVALID;
+            }
+            // Reads LittleFS, which allocates. Scripts already generated are unaffected.
+            HeapGuard::Exempt exempt;
+            AutoGenerator::loadPhaseTemplates();
         } else {
-            log_t("Unknown command prefix: %s", cmd.c_str());
+            log_t("Unknown command prefix: %s", cmd);
+            return CommandAck::RESULT_INVALID;
         }
 
-    } else if (value == "system_off") {
+    } else if (strcmp(value, "system_off") == 0) {
         __pendingOff = true;
-    } else if (value == "led_rainbow") {
+    } else if (strcmp(value, "led_rainbow") == 0) {
         __isRainbowActive = true;
         __isHueSineActive = false;
         if (__cometCount == 0) __cometCount = 1; // Ensure visibility
         log_t("LED Rainbow Mode: Sync BPM");
-    } else if (value == "led_reset") {
+    } else if (strcmp(value, "led_reset") == 0) {
         __isHueSineActive = false;
         __isRainbowActive = false;
         __isPulseSineActive = false;
-        __activeLedEffect = EFFECT_COMET;
+        beginEffect(EFFECT_COMET);
         __cometCount = 0;
+        clearCometGroups();
         __isLedReversed = false; // Also reset LED direction to forward
         __isManualLedInterval = false;
         // Let's not reset brightness here. 'led_reset' should only clear active effects,
         // not override aesthetic settings like brightness. This allows modes like
         // 'auto_steady_rotate' to maintain a consistent brightness level across cycles.
         // setFinalBrightnessFromDisplayPercent(100);
-        FastLED.clear(true);
+        blackoutStrip();
         log_t("LEDs reset to black/static.");
-    } else if (value == "motor_start") {
+    } else if (strcmp(value, "motor_start") == 0) {
         triggerStart();
-    } else if (value == "motor_stop") {
+    } else if (strcmp(value, "motor_stop") == 0) {
         triggerStop();
-    } else if (value == "system_reset") {
+    } else if (strcmp(value, "system_reset") == 0) {
         __isHueSineActive = false;
         __isRainbowActive = false;
         __isPulseSineActive = false;
@@ -824,135 +1842,254 @@ void processCommand(std::string value) {
         __cometHue = 0;
         __cometTailLength = 10;
         __cometCount = 3;
+        clearCometGroups();
         __isManualLedInterval = false;
-        __activeLedEffect = EFFECT_COMET;
+        beginEffect(EFFECT_COMET);
         __currentRampDuration = DEFAULT_RAMP_DURATION_MS;
         triggerSetSpeed(__speedSetting);
         processCommand("led_rainbow"); // Add led_rainbow after system reset
         log_t("System reset to defaults and started.");
-    } else if (value == "motor_reverse") {
+    } else if (strcmp(value, "motor_reverse") == 0) {
         triggerReverse();
-    } else if (value == "motor_speed_up") {
+    } else if (strcmp(value, "motor_speed_up") == 0) {
         triggerSpeedUp();
-    } else if (value == "motor_speed_down") {
+    } else if (strcmp(value, "motor_speed_down") == 0) {
         triggerSpeedDown();
-    } else if (value == "led_cycle_up") {
+    } else if (strcmp(value, "led_cycle_up") == 0) {
         __isManualLedInterval = true;
         __ledIntervalMs *= 0.92f;
         __manualLedIntervalMs = __ledIntervalMs;
         __manualSpeedReference = (__currentLogicalSpeed > 0) ? __currentLogicalSpeed : __speedSetting;
         log_t("LED Cycle speed UP 8%% (Manual). Interval: %.2f ms", __ledIntervalMs);
-    } else if (value == "led_cycle_down") {
+    } else if (strcmp(value, "led_cycle_down") == 0) {
         __isManualLedInterval = true;
         __ledIntervalMs *= 1.08f;
         __manualLedIntervalMs = __ledIntervalMs;
         __manualSpeedReference = (__currentLogicalSpeed > 0) ? __currentLogicalSpeed : __speedSetting;
         log_t("LED Cycle speed DOWN 8%% (Manual). Interval: %.2f ms", __ledIntervalMs);
-    } else if (value == "led_reverse") {
+    } else if (strcmp(value, "lcd_stats") == 0) {
+        const LcdDashboard::Stats& st = LcdDashboard::stats();
+        log_t("LCD: %lu refreshes, %lu regions pushed. Refresh CPU: last %lu us, avg %lu us, max %lu us.",
+              (unsigned long)st.refreshes, (unsigned long)st.regionsPushed,
+              (unsigned long)st.lastRefreshUs, (unsigned long)st.avgRefreshUs, (unsigned long)st.maxRefreshUs);
+        log_t("LCD preview: %lu frames, %lu points drawn. Frame CPU: avg %lu us, max %lu us.",
+              (unsigned long)st.previewFrames, (unsigned long)st.previewPointsDrawn,
+              (unsigned long)st.avgPreviewUs, (unsigned long)st.maxPreviewUs);
+    } else if (strcmp(value, "heap_guard") == 0) {
+        log_t("Heap: %lu free, %lu min free, %lu largest block. Script buffer: %d lines, %u/%u bytes.",
+              (unsigned long)ESP.getFreeHeap(), (unsigned long)ESP.getMinFreeHeap(), (unsigned long)ESP.getMaxAllocHeap(),
+              __activeScript.size(), (unsigned)__activeScript.bytesUsed(), (unsigned)SCRIPT_POOL_BYTES);
+        log_t("Heap guard %s: %lu loop-task allocations after setup (last %u bytes from %p), %lu exempt.",
+              HeapGuard::isLocked() ? "armed" : "off", (unsigned long)HeapGuard::violations(),
+              (unsigned)HeapGuard::lastViolationBytes(), HeapGuard::lastViolationCaller(),
+              (unsigned long)HeapGuard::exemptAllocations());
+    } else if (strcmp(value, "sys_stats") == 0) {
+        reportSysStats(false);
+    } else if (strcmp(value, "loop_watchdog") == 0) {
+        reportLoopWatchdog();
+    } else if (strcmp(value, "power_status") == 0) {
+        char line[PowerBudget::MAX_LINE_LEN];
+        PowerBudget::formatStatus(millis(), line, sizeof(line));
+        notifyStatus(line);
+        log_t("%s", line);
+        for (int i = EFFECT_COMET; i < __LED_EFFECT_COUNT; i++) {
+            const char* name = ledEffectName((LedEffect)i);
+            uint32_t load = PowerBudget::effectLoadMa(name);
+            if (load) log_t("  %-9s ~%lu mA at full brightness", name, (unsigned long)load);
+        }
+    } else if (strcmp(value, "router_status") == 0) {
+        uint32_t mask = CommandRouter::overrideMask();
+        log_t("Router: %d deferred, overrides: %s", CommandRouter::deferredCount(), mask ? "" : "none");
+        for (int k = 0; k < CommandRouter::PARAM_COUNT; k++) {
+            if (mask & (1u << k)) log_t("  override: %s", CommandRouter::paramName((CommandRouter::ParamKey)k));
+        }
+        for (int i = 0; i < CommandRouter::statusCount(); i++) {
+            const CommandRouter::StatusEntry& e = CommandRouter::statusAt(i);
+            log_t("  %lu ms %-16s %s", (unsigned long)e.ms, CommandRouter::decisionName(e.decision), e.text);
+        }
+        for (int k = 0; k < CommandRouter::PARAM_COUNT; k++) {
+            CommandRouter::ParamKey key = (CommandRouter::ParamKey)k;
+            uint32_t replaced = CommandRouter::coalesceReplaced(key);
+            if (replaced == 0) continue;
+            log_t("  coalesced %s: %lu applied, %lu superseded", CommandRouter::paramName(key),
+                  (unsigned long)CommandRouter::coalesceApplied(key), (unsigned long)replaced);
+        }
+        CommandRouter::resetCoalesceStats();
+        log_t("  acks: %lu sent, %lu lost to a full list", (unsigned long)CommandAck::sent(), (unsigned long)CommandAck::overflowed());
+    } else if (strcmp(value, "script_pause") == 0 || strcmp(value, "script_resume") == 0 ||
+               strcmp(value, "script_next") == 0 || strcmp(value, "script_prev") == 0) {
+        if (!__isScriptRunning) {
+            log_t("%s ignored: no script running.", value);
+            return CommandAck::RESULT_IGNORED;
+        } else if (strcmp(value, "script_pause") == 0) {
+            pauseScript();
+        } else if (strcmp(value, "script_resume") == 0) {
+            resumeScript();
+        } else {
+            skipScriptPhase(strcmp(value, "script_next") == 0 ? 1 : -1);
+        }
+    } else if (strcmp(value, "render_bench") == 0) {
+        startRenderBench();
+    } else if (strcmp(value, "particle_bench") == 0) {
+        startParticleBench();
+    } else if (strcmp(value, "gen_bench") == 0) {
+        if (!startGenBench(__GEN_BENCH_DEFAULT_SEEDS)) return CommandAck::RESULT_IGNORED;
+    } else if (strcmp(value, "auto_templates") == 0) {
+        AutoGenerator::logPhaseTemplates();
+    } else if (strcmp(value, "script_status") == 0) {
+        reportScriptStatus();
+    } else if (strcmp(value, "clear_overrides") == 0) {
+        CommandRouter::clearOverrides();
+        log_t("Parameter overrides cleared. The script controls all parameters again.");
+    } else if (strcmp(value, "led_reverse") == 0) {
         __isLedReversed = !__isLedReversed;
         log_t("LED direction reversed. New state: %s", __isLedReversed ? "Reversed" : "Normal");
     } else {
-        log_t("Invalid command format: %s", value.c_str());
+        log_t("Invalid command format: %s", value);
+        return CommandAck::RESULT_INVALID;
     }
+    return CommandAck::RESULT_APPLIED;
 }
 
 // --- Full Strip Effect Implementations ---
 
+/**
+ * @brief Fills in the blink's colour and its easing table, so a frame costs a table
+ * lookup rather than an HSV conversion.
+ */
+void buildBlinkEnvelope(BlinkState& blink) {
+    blink.color = CHSV(blink.hue, 255, 255);
+    BlinkEnvelope::build(blink.envelope, blink.ease, blink.maxBri);
+}
+
+/**
+ * @brief Renders blink, pushing a frame only when the level or brightness changed.
+ */
+void runBlinkEffect() {
+    BlinkState& blink = __effectState.blink;
+    unsigned long elapsed = millis() - blink.startTime;
+    unsigned long totalCycle = blink.upDuration + blink.downDuration;
+    // Check if we have reached the target count for finite blinks
+    if (blink.targetCount > 0 && (elapsed / totalCycle) >= (unsigned long)blink.targetCount) {
+        beginEffect(EFFECT_COMET); // Revert to default effect
+        blackoutStrip();
+        return;
+    }
+    // A new level, or a brightness change from a command or led_sine_pulse.
+    uint8_t level = BlinkEnvelope::level(blink.envelope, blink.maxBri, blink.upDuration, blink.downDuration, elapsed % totalCycle);
+    uint8_t brightness = FastLED.getBrightness();
+    if (level == blink.shownLevel && brightness == blink.shownBrightness) return;
+    CRGB color = blink.color;
+    color.nscale8(level);
+    fill_solid(__leds, __NUM_LEDS, color);
+    showStrip();
+    blink.shownLevel = level;
+    blink.shownBrightness = brightness;
+}
+
+// Templated on the sculpture variant so strip loops have compile-time bounds.
+template <typename Config>
 void runFireEffect() {
     // Fire2012 by Mark Kriegsman, described here: http://www.incinquecento.com/project/core-heating-and-cooling-for-a-1d-fire-effect/
     const int COOLING = 55;
     const int SPARKING = 120;
+    byte* heat = __effectState.fire.heat;
 
     // Step 1.  Cool down every cell a little
-    for (int i = 0; i < __NUM_LEDS; i++) {
-        __heat[i] = qsub8(__heat[i], random8(0, ((COOLING * 10) / __NUM_LEDS) + 2));
+    for (int i = 0; i < Config::NUM_LEDS; i++) {
+        heat[i] = qsub8(heat[i], random8(0, ((COOLING * 10) / Config::NUM_LEDS) + 2));
     }
 
     // Step 2.  Heat from each cell drifts 'up' and diffuses a little
-    for (int k = __NUM_LEDS - 1; k >= 2; k--) {
-        __heat[k] = (__heat[k - 1] + __heat[k - 2] + __heat[k - 2]) / 3;
+    for (int k = Config::NUM_LEDS - 1; k >= 2; k--) {
+        heat[k] = (heat[k - 1] + heat[k - 2] + heat[k - 2]) / 3;
     }
 
     // Step 3.  Randomly ignite new 'sparks' of heat near the bottom
     if (random8() < SPARKING) {
         int y = random8(7);
-        __heat[y] = qadd8(__heat[y], random8(160, 255));
+        heat[y] = qadd8(heat[y], random8(160, 255));
     }
 
-    // Step 4.  Map from heat cells to LED colors
-    for (int j = 0; j < __NUM_LEDS; j++) {
-        CRGB color = HeatColor(__heat[j]);
-        __leds[j] = color;
-    }
-    // The show() call uses the master brightness value that was last set by
-    // applyBrightness(), which correctly scales display brightness by the global master brightness.
-    FastLED.show();
+    // Step 4.  Map from heat cells to LED colors. Steps 1-3 stay serial: the diffusion
+    // reads neighbouring cells and the sparks share random state.
+    StripRender::HeatJob job = { (uint8_t*)__leds, heat, __heatRgb };
+    ParallelRender::forEach(renderHeatRange, &job, Config::NUM_LEDS, __SPLIT_MIN_PIXELS_LIGHT);
+    showStrip();
 }
 
+template <typename Config>
 void runNoiseEffect() {
     // Fill the strip with 1D noise from a palette
-    __noise_z += __noise_speed;
+    NoiseState& noise = __effectState.noise;
+    noise.z += noise.speed;
 
-    for (int i = 0; i < __NUM_LEDS; i++) {
-        uint8_t noise = inoise8(__noise_x + i * __noise_scale, __noise_y, __noise_z);
-        __leds[i] = ColorFromPalette(__noise_palette, noise, 255, LINEARBLEND);
-    }
-    // The show() call uses the master brightness value that was last set by
-    // applyBrightness(), which correctly scales display brightness by the global master brightness.
-    FastLED.show();
+    StripRender::NoiseJob job = { (uint8_t*)__leds, __noisePaletteRgb, noise.x, noise.y, noise.z, noise.scale };
+    ParallelRender::forEach(renderNoiseRange, &job, Config::NUM_LEDS, __SPLIT_MIN_PIXELS_HEAVY);
+    showStrip();
 }
 
+template <typename Config>
 void runMarqueeEffect() {
     // This effect's speed is now controlled by the global __ledIntervalMs,
     // which is set by the led_cycle_time command. This allows it to be ramped.
     unsigned long dynamicInterval = (unsigned long)max(1.0f, __ledIntervalMs);
     if (millis() - __last_led_strip_update > dynamicInterval) {
         __last_led_strip_update = millis();
-        uint8_t total_width = __marquee_lit_width + __marquee_dark_width;
+        MarqueeState& marquee = __effectState.marquee;
+        uint8_t total_width = marquee.litWidth + marquee.darkWidth;
         if (total_width == 0) return;
 
         if (!__isLedReversed) {
-            __marquee_offset = (__marquee_offset + 1) % total_width;
+            marquee.offset = (marquee.offset + 1) % total_width;
         } else {
-            __marquee_offset = (__marquee_offset - 1 + total_width) % total_width;
+            marquee.offset = (marquee.offset - 1 + total_width) % total_width;
         }
 
-        for (int i = 0; i < __NUM_LEDS; i++) {
-            if (((i + __marquee_offset) % total_width) < __marquee_lit_width) {
-                __leds[i] = CHSV(__marquee_hue, 255, 255);
-            } else {
-                __leds[i] = CRGB::Black;
-            }
-        }
-        // The show() call uses the master brightness value that was last set by
-        // applyBrightness(), which correctly scales display brightness by the global master brightness.
-        FastLED.show();
+        StripRender::MarqueeJob job = { (uint8_t*)__leds, {}, marquee.offset, marquee.litWidth, total_width };
+        setRgb(job.color, CHSV(marquee.hue, 255, 255));
+        ParallelRender::forEach(renderMarqueeRange, &job, Config::NUM_LEDS, __SPLIT_MIN_PIXELS_LIGHT);
+        showStrip();
     }
 }
 
+template <typename Config>
+void runParticlesEffect() {
+    unsigned long now = millis();
+    if (now - __last_led_strip_update < 16) return; // ~60 fps
+    uint32_t dtMs = (uint32_t)(now - __last_led_strip_update);
+    __last_led_strip_update = now;
+    ParticleSystem::update(dtMs);
+    // Particles are added onto what is left of the last frame, which leaves trails.
+    fadeToBlackBy(__leds, Config::NUM_LEDS, __effectState.particles.fade);
+    ParticleSystem::render((uint8_t*)__leds, __particleHueRgb);
+    showStrip();
+}
+
+template <typename Config>
 void runTwinkleEffect() {
     if (millis() - __last_led_strip_update > 20) { // run at ~50fps
         __last_led_strip_update = millis();
         // Fade all pixels down by a small amount
-        fadeToBlackBy(__leds, __NUM_LEDS, 40);
+        fadeToBlackBy(__leds, Config::NUM_LEDS, 40);
 
         // Randomly add a new sparkle
-        if (random8() < __twinkle_density) {
-            __leds[random16(__NUM_LEDS)] = CHSV(__twinkle_hue, 255, 255);
+        if (random8() < __effectState.twinkle.density) {
+            __leds[random16(Config::NUM_LEDS)] = CHSV(__effectState.twinkle.hue, 255, 255);
         }
-        // The show() call uses the master brightness value that was last set by
-        // applyBrightness(), which correctly scales display brightness by the global master brightness.
-        FastLED.show();
+        showStrip();
     }
 }
 
 // --- BLE Callbacks ---
 class MyServerCallbacks : public BLEServerCallbacks {
     void onConnect(BLEServer* pServer) {
+        __bleClientConnected = true;
         log_t("BLE Client Connected");
     };
 
     void onDisconnect(BLEServer* pServer) {
+        __bleClientConnected = false;
         log_t("BLE Client Disconnected. Restarting advertising...");
         // Restart advertising so the device can be found again
         pServer->getAdvertising()->start();
@@ -961,20 +2098,383 @@ class MyServerCallbacks : public BLEServerCallbacks {
 
 class CommandCallback : public BLECharacteristicCallbacks {
     void onWrite(BLECharacteristic *pCharacteristic) {
-        std::string value = pCharacteristic->getValue();
-        if (value.length() == 0) return;
+        // Read the raw value rather than getValue(), which returns a std::string copy.
+        // The library has already stored the write as the characteristic's value, so a
+        // client reading it back still gets the last command without a setValue() here.
+        const char* data = (const char*)pCharacteristic->getData();
+        size_t len = pCharacteristic->getLength();
+        if (len == 0) return;
+
+        // Thread-safe handoff to loop() to avoid cross-core race conditions.
+        // Not logged here: during a slider drag most writes are coalesced away, and
+        // loop() logs the ones it applies.
+        if (!CommandQueue::push(data, len, EventTracer::now())) {
+            log_t("BLE command dropped (too long or queue full). %lu dropped so far.", (unsigned long)CommandQueue::dropped());
+        }
+    }
+};
+
+// Command sources, recorded as the arg of EV_COMMAND trace spans.
+static const uint16_t __CMD_SOURCE_BLE = 0;
+static const uint16_t __CMD_SOURCE_SCRIPT = 1;
+
+/**
+ * @brief Runs processCommand() inside an EV_COMMAND trace span.
+ * @return processCommand()'s result.
+ */
+CommandAck::Result runTracedCommand(const char* cmd, uint16_t source) {
+    uint32_t startUs = EventTracer::now();
+    EventTracer::begin(EventTracer::EV_COMMAND, source);
+    CommandAck::Result result = processCommand(cmd);
+    EventTracer::end(EventTracer::EV_COMMAND, source);
+    LoopWatchdog::noteWork(cmd, EventTracer::now() - startUs);
+    return result;
+}
+
+/**
+ * @brief Queues the acknowledgement for a tagged BLE command. A no-op for untagged ones.
+ */
+void ackCommand(const CommandRouter::CommandTag& tag, CommandAck::Result result) {
+    CommandAck::complete(tag.seq, result, tag.receivedUs, EventTracer::now());
+}
+
+/**
+ * @brief Runs a BLE command and acknowledges it with processCommand()'s result.
+ */
+CommandAck::Result applyBleCommand(const char* cmd, const CommandRouter::CommandTag& tag) {
+    CommandAck::Result result = runTracedCommand(cmd, __CMD_SOURCE_BLE);
+    ackCommand(tag, result);
+    return result;
+}
 
-        log_t("BLE Received: %s", value.c_str());
+/**
+ * @brief Stops the running script (and auto-mode looping). User overrides and
+ * deferred commands belonged to that show, so they are dropped too.
+ */
+void stopScript() {
+    __isScriptRunning = false; // Stop the script
+    __isScriptPaused = false;
+    __autoModeType = AUTO_MODE_NONE; // Stop auto-mode looping
+    __sceneBoundaryPending = false;
+    CommandRouter::clearOverrides();
+    char cmd[CommandRouter::MAX_DEFERRED_LEN + 1];
+    CommandRouter::CommandTag tag;
+    while (CommandRouter::popDeferred(cmd, &tag)) {
+        ackCommand(tag, CommandAck::RESULT_IGNORED);
+    }
+}
 
-        // Thread-safe handoff to loop() to avoid cross-core race conditions
-        if (value.length() < sizeof(__bleCommandBuffer)) {
-            strcpy(__bleCommandBuffer, value.c_str());
-            __bleCommandAvailable = true;
+/**
+ * @brief Hands overridden parameters back to the script at a scene boundary, saying which.
+ */
+void expireOverrides(const char* boundary) {
+    uint32_t expired = CommandRouter::expireOverrides();
+    for (int k = 0; k < CommandRouter::PARAM_COUNT; k++) {
+        if (expired & (1u << k)) {
+            log_t("Override of %s ended at %s; the script controls it again.",
+                  CommandRouter::paramName((CommandRouter::ParamKey)k), boundary);
         }
+    }
+}
 
-        pCharacteristic->setValue(value);
+/**
+ * @brief Runs one script step, unless the user has overridden the parameter it sets.
+ */
+void runScriptCommand(const char* cmd) {
+    if (CommandRouter::isOverridden(CommandRouter::paramKey(cmd))) {
+        // The user has taken this parameter over; the script's value is skipped.
+        CommandRouter::record(CommandRouter::DECISION_SHADOWED, cmd, millis());
+        log_t("Script command skipped (user override): %s", cmd);
+    } else {
+        runTracedCommand(cmd, __CMD_SOURCE_SCRIPT);
     }
-};
+}
+
+// --- Script Transport ---
+
+/**
+ * @brief Logs where the script is and notifies a one-line summary:
+ * "SCRIPT <state> <step>/<steps> <pos_s>/<planned_s> <elapsed_s> <phase>".
+ */
+void reportScriptStatus() {
+    const char* state = !__isScriptRunning ? "stopped" : (__isScriptPaused ? "paused" : "running");
+    char line[72];
+    if (!__isScriptRunning) {
+        snprintf(line, sizeof(line), "SCRIPT stopped");
+        log_t("Script status: no script running.");
+    } else {
+        unsigned long elapsedS = (millis() - __scriptStartTime) / 1000;
+        unsigned long posS = scriptPositionMs() / 1000;
+        unsigned long totalS = ScriptTimeline::totalMs() / 1000;
+        snprintf(line, sizeof(line), "SCRIPT %s %d/%d %lu/%lu %lu %s", state, __scriptCommandIndex, __activeScript.size(),
+                 posS, totalS, elapsedS, __scriptPhaseName[0] ? __scriptPhaseName : "-");
+        log_t("Script %s: step %d of %d, phase '%s', %lu s elapsed, at %lu s of %lu s planned, about %lu s left%s.",
+              state, __scriptCommandIndex, __activeScript.size(), __scriptPhaseName, elapsedS, posS, totalS,
+              (unsigned long)(scriptRemainingMs() / 1000),
+              __autoModeType != AUTO_MODE_NONE ? " (auto-mode: a new script follows)" : "");
+    }
+    notifyStatus(line);
+}
+
+/**
+ * @brief Freezes the script on its current scene. The motor and LEDs keep running.
+ */
+void pauseScript() {
+    if (__isScriptPaused) return;
+    __scriptPausedHeldMs = millis() - __scriptLastCommandTime;
+    __isScriptPaused = true;
+    log_t("Script paused at %lu s.", (unsigned long)(scriptPositionMs() / 1000));
+}
+
+void resumeScript() {
+    if (!__isScriptPaused) return;
+    __scriptLastCommandTime = millis() - __scriptPausedHeldMs;
+    __isScriptPaused = false;
+    log_t("Script resumed at %lu s.", (unsigned long)(scriptPositionMs() / 1000));
+}
+
+/**
+ * @brief Jumps the script to `step`. Instead of replaying every step before it, only the
+ * last writer of each piece of show state is re-run (see script_timeline.h).
+ * @param holdRemainingMs How long to wait before running `step` (the rest of the hold
+ * the target time falls in).
+ */
+void seekScriptToStep(int step, uint32_t holdRemainingMs) {
+    ScriptTimeline::RestorePlan plan;
+    ScriptTimeline::planRestore(__activeScript, __scriptCommandIndex, step, holdRemainingMs, &plan);
+    for (int i = 0; i < plan.defaultCount; i++) {
+        runScriptCommand(plan.defaults[i]);
+    }
+    for (int i = 0; i < plan.count; i++) {
+        runScriptCommand(__activeScript[plan.steps[i]]);
+    }
+    if (plan.blinkEnded) beginEffect(EFFECT_COMET); // As runBlinkEffect() does when the count is reached
+    if (plan.toggleLedReverse) runTracedCommand("led_reverse", __CMD_SOURCE_SCRIPT);
+    if (plan.toggleMotorReverse) runTracedCommand("motor_reverse", __CMD_SOURCE_SCRIPT);
+
+    int marker = ScriptTimeline::markerAtOrBefore(step - 1);
+    __scriptPhaseName[0] = '\0';
+    if (marker >= 0) updateScriptPhaseName(__activeScript[ScriptTimeline::markerStep(marker)]);
+    __sceneBoundaryPending = false;
+    __scriptCommandIndex = step;
+    __scriptHoldDuration = holdRemainingMs;
+    __scriptLastCommandTime = millis();
+    __scriptPausedHeldMs = 0;
+    log_t("Script seek: step %d of %d at %lu s, %d steps replayed, %d defaults restored.", step,
+          __activeScript.size(), (unsigned long)(scriptPositionMs() / 1000), plan.count, plan.defaultCount);
+}
+
+void seekScriptToTime(uint32_t ms) {
+    uint32_t total = ScriptTimeline::totalMs();
+    if (total == 0) return;
+    if (ms >= total) ms = total - 1; // Stay inside the script rather than ending it
+    uint32_t holdRemainingMs = 0;
+    int step = ScriptTimeline::stepForTime(ms, &holdRemainingMs);
+    seekScriptToStep(step, holdRemainingMs);
+}
+
+/**
+ * @brief Jumps to the next phase marker (direction 1) or back (direction -1). Going
+ * back more than a few seconds into a phase restarts that phase, as media players do.
+ */
+void skipScriptPhase(int direction) {
+    static const uint32_t RESTART_PHASE_WINDOW_MS = 3000;
+    int current = ScriptTimeline::markerAtOrBefore(__scriptCommandIndex - 1);
+    int target;
+    if (direction > 0) {
+        target = current + 1;
+        if (target >= ScriptTimeline::markerCount()) {
+            log_t("No next phase in this script.");
+            return;
+        }
+    } else {
+        target = current;
+        if (current >= 0 && scriptPositionMs() - ScriptTimeline::stepStartMs(ScriptTimeline::markerStep(current)) < RESTART_PHASE_WINDOW_MS) {
+            target = current - 1;
+        }
+    }
+    seekScriptToStep(target >= 0 ? ScriptTimeline::markerStep(target) : 0, 0);
+}
+
+/**
+ * @brief Runs the BLE commands that were held back for a scene boundary.
+ */
+void applyDeferredCommands() {
+    char cmd[CommandRouter::MAX_DEFERRED_LEN + 1];
+    CommandRouter::CommandTag tag;
+    while (CommandRouter::popDeferred(cmd, &tag)) {
+        CommandRouter::record(CommandRouter::DECISION_DEFERRED_APPLIED, cmd, millis());
+        log_t("Applying deferred command at scene boundary: %s", cmd);
+        applyBleCommand(cmd, tag);
+    }
+}
+
+// --- Show Checkpoint ---
+// The running auto-mode show is checkpointed to NVS so that after a brown-out or
+// reset it picks up where it was instead of starting a new show (see show_checkpoint.h).
+static const unsigned long __CHECKPOINT_INTERVAL_MS = 60000;
+static ShowCheckpoint::Record __checkpoint;          // Generation fields set by generateAutoScript()
+static bool __checkpointDue = false;                 // Write at the next pass (a new script started)
+static bool __checkpointStored = true;               // NVS may hold a record; assume so until cleared
+static unsigned long __lastCheckpointMs = 0;
+
+/**
+ * @brief Generates the auto-mode script of `type` into __activeScript and records how,
+ * so the same script can be regenerated on resume.
+ * @param seed 0 picks a new random seed.
+ */
+void generateAutoScript(AutoModeType type, int minutes, uint32_t seed) {
+    if (seed == 0) seed = esp_random() | 1; // 0 would make the generator seed from millis()
+    memset(&__checkpoint, 0, sizeof(__checkpoint));
+    __checkpoint.mode = (uint8_t)type;
+    __checkpoint.seed = seed;
+    __checkpoint.minutes = (uint16_t)minutes;
+    __checkpoint.generatedRampMs = (uint16_t)__currentRampDuration;
+    __checkpoint.generatedBrightness = __globalMasterBrightness;
+    for (int i = EFFECT_COMET; i < __LED_EFFECT_COUNT; i++) {
+        __checkpoint.effectLoadsMa[i] = (uint16_t)min(PowerBudget::effectLoadMa(ledEffectName((LedEffect)i)), (uint32_t)0xFFFF);
+    }
+    __scriptLoadCount++;
+    uint32_t startUs = EventTracer::now();
+    if (type == AUTO_MODE_STEADY_ROTATE) {
+        AutoGenerator::generateSteadyRotateScript<Sculpture>(minutes, __activeScript, seed);
+        LoopWatchdog::noteWork("(generate auto_steady_rotate)", EventTracer::now() - startUs);
+    } else {
+        AutoGenerator::generateScript<Sculpture>(minutes, (uint32_t)__currentRampDuration, __activeScript, seed);
+        LoopWatchdog::noteWork("(generate auto_mode)", EventTracer::now() - startUs);
+    }
+    __checkpoint.fingerprint = __activeScript.fingerprint();
+    __checkpointDue = true;
+}
+
+/**
+ * @brief Regenerates the show saved in NVS and seeks it to the saved position, so the
+ * first frame after boot already shows that scene.
+ * @return false if there is no usable record; the caller starts a fresh show.
+ */
+bool resumeFromCheckpoint() {
+    ShowCheckpoint::Record r;
+    if (!ShowCheckpoint::load(&r)) return false;
+    if (r.mode != AUTO_MODE_NORMAL && r.mode != AUTO_MODE_STEADY_ROTATE) return false;
+
+    // Regenerate under the conditions the script was first generated in.
+    __currentRampDuration = r.generatedRampMs;
+    __globalMasterBrightness = r.generatedBrightness;
+    PowerBudget::setMasterBrightness(__globalMasterBrightness);
+    for (int i = EFFECT_COMET; i < __LED_EFFECT_COUNT; i++) {
+        if (r.effectLoadsMa[i] != 0) PowerBudget::setEffectLoadMa(ledEffectName((LedEffect)i), r.effectLoadsMa[i]);
+    }
+    generateAutoScript((AutoModeType)r.mode, r.minutes, r.seed);
+    if (__activeScript.empty() || __activeScript.fingerprint() != r.fingerprint) {
+        log_t("Checkpoint: regenerated script does not match the saved show (templates or firmware changed). Starting afresh.");
+        return false;
+    }
+    beginScriptPlayback();
+    __autoModeType = (AutoModeType)r.mode;
+    __autoModeDurationMinutes = r.minutes;
+
+    // Then the show state at its position, and over it the parameters in force at the
+    // checkpoint: the seek replays the script's own led_global_brightness and motor_ramp
+    // steps, which a slider may have overridden since.
+    seekScriptToTime(r.positionMs);
+    __currentRampDuration = r.rampMs;
+    __globalMasterBrightness = r.brightness;
+    PowerBudget::setMasterBrightness(__globalMasterBrightness);
+    setFinalBrightnessFromDisplayPercent(__lastDisplayBrightnessPercent);
+    __scriptStartTime = millis() - r.elapsedMs;
+    if (r.paused) pauseScript();
+    __checkpoint.sequence = r.sequence;
+    log_t("Checkpoint: resumed %s show (seed %lu, %d min) at %lu s of %lu s, record %lu.",
+          r.mode == AUTO_MODE_NORMAL ? "auto_mode" : "auto_steady_rotate", (unsigned long)r.seed, r.minutes,
+          (unsigned long)(r.positionMs / 1000), (unsigned long)(ScriptTimeline::totalMs() / 1000), (unsigned long)r.sequence);
+    return true;
+}
+
+/**
+ * @brief Saves the running show's position every __CHECKPOINT_INTERVAL_MS (at once when
+ * a new script starts), and removes the record once no auto-mode show is running so a
+ * stopped show stays stopped after a reboot.
+ */
+void serviceCheckpoint() {
+    unsigned long now = millis();
+    if (!__isScriptRunning || __autoModeType == AUTO_MODE_NONE) {
+        if (__checkpointStored) {
+            HeapGuard::Exempt exempt; // NVS allocates while it indexes entries
+            ShowCheckpoint::clear();
+            __checkpointStored = false;
+        }
+        return;
+    }
+    if (!__checkpointDue && now - __lastCheckpointMs < __CHECKPOINT_INTERVAL_MS) return;
+    __lastCheckpointMs = now;
+
+    uint32_t position = scriptPositionMs();
+    uint8_t paused = __isScriptPaused ? 1 : 0;
+    // A paused show with unchanged parameters has nothing new to save.
+    if (!__checkpointDue && position == __checkpoint.positionMs && paused == __checkpoint.paused &&
+        __globalMasterBrightness == __checkpoint.brightness && (uint16_t)__currentRampDuration == __checkpoint.rampMs) {
+        return;
+    }
+    __checkpointDue = false;
+    __checkpoint.positionMs = position;
+    __checkpoint.paused = paused;
+    __checkpoint.elapsedMs = now - __scriptStartTime;
+    __checkpoint.brightness = __globalMasterBrightness;
+    __checkpoint.rampMs = (uint16_t)__currentRampDuration;
+    __checkpoint.sequence++;
+    HeapGuard::Exempt exempt;
+    if (ShowCheckpoint::save(__checkpoint)) {
+        __checkpointStored = true;
+    } else {
+        log_t("Checkpoint: NVS write failed.");
+    }
+}
+
+/**
+ * @brief Applies, overrides, defers or rejects a BLE command. Outside a script every
+ * command applies; during one the command's CommandRouter lane decides.
+ */
+void routeBleCommand(const char* cmd, const CommandRouter::CommandTag& tag) {
+    unsigned long now = millis();
+    if (!__isScriptRunning) {
+        CommandRouter::record(CommandRouter::DECISION_APPLIED, cmd, now);
+        applyBleCommand(cmd, tag);
+        return;
+    }
+
+    switch (CommandRouter::classify(cmd)) {
+        case CommandRouter::LANE_OVERRIDE:
+            if (CommandRouter::stopsScript(cmd)) stopScript();
+            CommandRouter::record(CommandRouter::DECISION_OVERRIDE, cmd, now);
+            log_t("Override during script: %s", cmd);
+            applyBleCommand(cmd, tag);
+            break;
+        case CommandRouter::LANE_PARAM: {
+            CommandRouter::ParamKey key = CommandRouter::paramKey(cmd);
+            CommandRouter::record(CommandRouter::DECISION_PARAM_OVERRIDE, cmd, now);
+            log_t("User override of %s during script: %s", CommandRouter::paramName(key), cmd);
+            // A rejected value leaves the parameter with the script.
+            if (applyBleCommand(cmd, tag) == CommandAck::RESULT_APPLIED) CommandRouter::setOverride(key);
+            break;
+        }
+        case CommandRouter::LANE_DEFERRED:
+            if (CommandRouter::defer(cmd, tag)) {
+                CommandRouter::record(CommandRouter::DECISION_DEFERRED, cmd, now);
+                log_t("Deferred to next scene: %s", cmd);
+                ackCommand(tag, CommandAck::RESULT_DEFERRED);
+            } else {
+                CommandRouter::record(CommandRouter::DECISION_DROPPED, cmd, now);
+                log_t("Deferred queue full, command dropped: %s", cmd);
+                ackCommand(tag, CommandAck::RESULT_IGNORED);
+            }
+            break;
+        case CommandRouter::LANE_REJECT:
+            CommandRouter::record(CommandRouter::DECISION_REJECTED, cmd, now);
+            log_t("BLE command ignored (Script running): %s", cmd);
+            ackCommand(tag, CommandAck::RESULT_IGNORED);
+            break;
+    }
+}
 
 void setup() {
     auto cfg = M5.config();
@@ -992,6 +2492,12 @@ void setup() {
 
     log_t("System Initialized");
 
+    LoopWatchdog::begin();
+    if (LoopWatchdog::count() > 0) {
+        log_t("Loop watchdog: boot %lu, %d overruns retained from before the reset (loop_watchdog to list).",
+              (unsigned long)LoopWatchdog::bootCount(), LoopWatchdog::count());
+    }
+
     // Configure PWM for H-Bridge
     ledcSetup(__ledChannel1, __freq, __resolution);
     ledcSetup(__ledChannel2, __freq, __resolution);
@@ -1002,8 +2508,13 @@ void setup() {
     FastLED.addLeds<WS2812B, __ONBOARD_LED_PIN, GRB>(__onboard_led, 1);
     FastLED.addLeds<WS2812B, __LED_STRIP_PIN, GRB>(__leds, __NUM_LEDS);
 
-    // Set a safety power limit (5V, 500mA is safe for AtomS3 internal regulator)
-    FastLED.setMaxPowerInVoltsAndMilliamps(5, 500);
+    // Safety power limit, applied per frame in showStrip() rather than by FastLED so
+    // that limiting can be reported.
+    PowerBudget::configure(__POWER_BUDGET_MA, __NUM_LEDS);
+    ParticleSystem::configure(__LOGICAL_NUM_LEDS, __NUM_LEDS);
+    buildParticleHueTable();
+    buildHeatTable();
+    PowerBudget::setMasterBrightness(__globalMasterBrightness);
     setFinalBrightnessFromDisplayPercent(100);
 
     // Immediate blackout to overwrite any RMT initialization glitches
@@ -1030,6 +2541,14 @@ void setup() {
     pCommandCharacteristic->setCallbacks(new CommandCallback());
     pCommandCharacteristic->setValue(" "); // Set an initial value
 
+    // Status Characteristic (diagnostics such as trace dumps are notified here)
+    __statusCharacteristic = pService->createCharacteristic(
+                                         __STATUS_CHAR_UUID,
+                                         BLECharacteristic::PROPERTY_READ | BLECharacteristic::PROPERTY_NOTIFY
+                                       );
+    __statusCharacteristic->addDescriptor(new BLE2902());
+    __statusCharacteristic->setValue(" ");
+
     pService->start();
     pServer->getAdvertising()->start();
     log_t("BLE Server started. Waiting for a client connection...");
@@ -1037,61 +2556,100 @@ void setup() {
     __onboard_led[0] = CRGB(50, 0, 0); // Dim Red to show power is on and motor is stopped
     FastLED.show();
 
-    // Start the system in auto_steady_rotate mode for 480 minutes (8 hours) on initialization.
-    processCommand("auto_steady_rotate:480");
+    if (!ParallelRender::begin()) log_t("Render worker not started; rendering on one core.");
+
+    LcdDashboard::begin(M5.Display);
+    LcdDashboard::setStripGeometry(__NUM_LEDS, __LOGICAL_NUM_LEDS);
+
+    log_t("Effect state: %u bytes shared (blink %u, noise %u, fire %u, marquee %u, twinkle %u, particles %u)",
+          (unsigned)sizeof(__effectState), (unsigned)sizeof(BlinkState), (unsigned)sizeof(NoiseState),
+          (unsigned)sizeof(FireState<Sculpture>), (unsigned)sizeof(MarqueeState), (unsigned)sizeof(TwinkleState),
+          (unsigned)sizeof(ParticleState));
+#ifdef REPORT_EFFECT_RAM
+    reportAllEffectRam<Sculpture>();
+#endif
+
+    AutoGenerator::loadPhaseTemplates();
+
+    // Continue the show that was running when power was lost, if any. Otherwise start
+    // the system in auto_steady_rotate mode for 480 minutes (8 hours).
+    if (!ShowCheckpoint::begin()) log_t("Checkpoint: NVS not available; shows will not resume after a reset.");
+    if (!resumeFromCheckpoint()) {
+        processCommand("auto_steady_rotate:480");
+    }
+
+    // Everything the loop needs is allocated by now. In heap-free builds, any later
+    // allocation on this task trips an assertion.
+    HeapGuard::lockOnCurrentTask();
+    log_t("Setup complete. Free heap: %lu bytes. Heap guard %s.", (unsigned long)ESP.getFreeHeap(), HeapGuard::isLocked() ? "armed" : "off");
 }
 
 
 void loop() {
     //log_t("Loop start."); // Diagnostic: Check if the main loop is running. However, this bogs down all logging.
+    LoopWatchdog::beginPass(EventTracer::now(), millis());
     M5.update(); // Required for button state updates
 
     // --- Handle BLE Commands ---
-    if (__bleCommandAvailable) {
-        std::string cmd_str = __bleCommandBuffer;
-        __bleCommandAvailable = false;
-
-        // Per your feedback, led_global_brightness must always be processed, even during a script.
-        if (cmd_str.rfind("led_global_brightness", 0) == 0) {
-            processCommand(cmd_str);
+    LoopWatchdog::enterStage(LoopWatchdog::STAGE_COMMANDS, EventTracer::now());
+    // Everything queued since the last pass is drained. Parameter setters are coalesced
+    // so only the newest value per parameter is applied; the rest go straight through.
+    // A "#<seq> " prefix asks for an acknowledgement (see command_ack.h).
+    char raw_cmd[CommandQueue::MAX_COMMAND_LEN + 1];
+    char cmd_str[CommandQueue::MAX_COMMAND_LEN + 1];
+    CommandRouter::CommandTag tag;
+    while (CommandQueue::pop(raw_cmd, &tag.receivedUs)) {
+        EventTracer::recordAt(tag.receivedUs, EventTracer::TRACE_INSTANT, EventTracer::EV_COMMAND_RECEIVED);
+        const char* cmd = CommandParser::stripSequence(raw_cmd, &tag.seq);
+        CommandRouter::ParamKey key = CommandRouter::coalesceKey(cmd);
+        CommandRouter::CommandTag replaced;
+        if (key != CommandRouter::PARAM_NONE && !CommandRouter::offerCoalesced(key, cmd, tag, millis(), &replaced)) {
+            ackCommand(replaced, CommandAck::RESULT_SUPERSEDED);
+            continue; // Staged; a newer value may still replace it
         }
-        // system_reset and system_off can also interrupt a script.
-        else if (cmd_str == "system_reset" || cmd_str == "system_off") {
-            __isScriptRunning = false; // Stop the script
-            __autoModeType = AUTO_MODE_NONE; // Stop auto-mode looping
-            processCommand(cmd_str);
-        } else if (!__isScriptRunning) { // If no script is running, process any command.
-            processCommand(cmd_str);
-        } else {
-            // If a script is running, only allow specific commands through.
-            // For auto_steady_rotate, allow motor_speed to be overridden.
-            if (__autoModeType == AUTO_MODE_STEADY_ROTATE && cmd_str.rfind("motor_speed", 0) == 0) {
-                log_t("Processing motor_speed override during auto_steady_rotate.");
-                processCommand(cmd_str);
-            } else {
-                log_t("BLE command ignored (Script running): %s", cmd_str.c_str());
-            }
+        // Show control wins over any slider value still waiting to be applied.
+        if (CommandRouter::stopsScript(cmd)) {
+            CommandRouter::CommandTag dropped[CommandRouter::PARAM_COUNT];
+            int droppedCount = CommandRouter::discardStaged(dropped);
+            for (int i = 0; i < droppedCount; i++) ackCommand(dropped[i], CommandAck::RESULT_IGNORED);
+        }
+        // Slider values staged before this command are applied first, keeping the order sent.
+        CommandRouter::CommandTag stagedTag;
+        while (CommandRouter::takeStagedBefore(cmd, millis(), cmd_str, &stagedTag)) {
+            log_t("BLE Received: %s (staged, applied before the next command)", cmd_str);
+            routeBleCommand(cmd_str, stagedTag);
         }
+        log_t("BLE Received: %s", cmd);
+        // led_global_brightness is a parameter override, so it is always processed, even during a script.
+        routeBleCommand(cmd, tag);
+    }
+    while (CommandRouter::takeDueCoalesced(millis(), cmd_str, &tag)) {
+        log_t("BLE Received: %s (newest of a burst)", cmd_str);
+        routeBleCommand(cmd_str, tag);
+    }
+    // Anything still deferred when no script is running has no scene to wait for.
+    if (!__isScriptRunning && CommandRouter::deferredCount() > 0) {
+        applyDeferredCommands();
     }
 
     // --- Script Engine ---
+    LoopWatchdog::enterStage(LoopWatchdog::STAGE_SCRIPT, EventTracer::now());
     // Only advance if motor is idle AND any finite blink sequence has finished
-    if (__isScriptRunning && __motorState == __MOTOR_IDLE && (__activeLedEffect != EFFECT_BLINK || __blinkTargetCount == 0)) {
+    if (__isScriptRunning && !__isScriptPaused && __motorState == __MOTOR_IDLE && (__activeLedEffect != EFFECT_BLINK || __effectState.blink.targetCount == 0)) {
         if (millis() - __scriptLastCommandTime >= __scriptHoldDuration) {
-            if (__scriptCommandIndex >= __activeScriptCommands.size()) {
+            if (__scriptCommandIndex >= __activeScript.size()) {
+                // The end of a script is a scene boundary too.
+                applyDeferredCommands();
+                __sceneBoundaryPending = false;
+                expireOverrides("the end of the script");
                 // End of script reached
                 if (__autoModeType != AUTO_MODE_NONE) {
                     log_t("Auto-mode script finished. Total runtime: %lu s. Generating and starting next script...", (millis() - __scriptStartTime) / 1000);
                     
-                    if (__autoModeType == AUTO_MODE_NORMAL) {
-                        __activeScriptCommands = AutoGenerator::generateScript(__autoModeDurationMinutes);
-                    } else if (__autoModeType == AUTO_MODE_STEADY_ROTATE) {
-                        __activeScriptCommands = AutoGenerator::generateSteadyRotateScript(__autoModeDurationMinutes);
-                    }
+                    generateAutoScript(__autoModeType, __autoModeDurationMinutes, 0);
 
-                    if (!__activeScriptCommands.empty()) {
-                        __scriptCommandIndex = 0;
-                        __scriptStartTime = __scriptLastCommandTime = millis();
+                    if (!__activeScript.empty()) {
+                        beginScriptPlayback();
                         // Continue to execute the first command of the new script in this same pass
                     } else {
                         // Something went wrong with generation, stop everything.
@@ -1104,21 +2662,34 @@ void loop() {
                     __scriptCommandIndex = 0;
                 }
             }
-            std::string cmd = __activeScriptCommands[__scriptCommandIndex];
+            const char* cmd = __activeScript[__scriptCommandIndex];
             __scriptLastCommandTime = millis();
             __scriptHoldDuration = 0; // Reset hold for the next command
-            log_t("Script Executing: %s", cmd.c_str());
-            processCommand(cmd);
+            log_t("Script Executing: %s", cmd);
+            if (cmd[0] == '[') {
+                updateScriptPhaseName(cmd);
+                __sceneBoundaryPending = true;
+                expireOverrides("a scene boundary");
+            }
+            EventTracer::instant(EventTracer::EV_SCRIPT_STEP, (uint16_t)__scriptCommandIndex);
+            runScriptCommand(cmd);
             __scriptCommandIndex++;
+            // Deferred user commands apply once the new scene has set itself up, i.e. at
+            // its first hold, so they are visible for the whole scene.
+            if (__sceneBoundaryPending && CommandParser::startsWith(cmd, "hold:")) {
+                __sceneBoundaryPending = false;
+                applyDeferredCommands();
+            }
         }
     }
 
     // --- Handle Pending Off Command ---
+    LoopWatchdog::enterStage(LoopWatchdog::STAGE_RENDER, EventTracer::now());
     if (__pendingOff) {
         log_t("Processing Off command...");
         triggerStop();         // Start motor ramp down
         __isMotorRunning = false; // Stop LED animation logic
-        FastLED.clear(true);    // Blackout all LEDs immediately
+        blackoutStrip();       // Blackout all LEDs immediately
         __pendingOff = false;
     }
 
@@ -1145,82 +2716,48 @@ void loop() {
     }
 
     // --- LED Strip Animation ---
+    __frameRenderStartUs = EventTracer::isEnabled() ? EventTracer::now() : 0;
     switch (__activeLedEffect) {
-        case EFFECT_BLINK: {
-            unsigned long elapsed = millis() - __blinkStartTime;
-            unsigned long totalCycle = __blinkUpDuration + __blinkDownDuration;
-            if (totalCycle > 0) {
-                // Check if we have reached the target count for finite blinks
-                if (__blinkTargetCount > 0 && (elapsed / totalCycle) >= (unsigned long)__blinkTargetCount) {
-                    __activeLedEffect = EFFECT_COMET; // Revert to default effect
-                    __blinkTargetCount = 0;
-                    FastLED.clear(true);
-                } else {
-                    unsigned long cyclePos = elapsed % totalCycle;
-                    uint8_t bri = 0;
-                    if (cyclePos < __blinkUpDuration) {
-                        bri = map(cyclePos, 0, __blinkUpDuration, 0, __blinkMaxBri);
-                    } else {
-                        unsigned long downElapsed = cyclePos - __blinkUpDuration;
-                        bri = map(downElapsed, 0, __blinkDownDuration, __blinkMaxBri, 0);
-                    }
-                    fill_solid(__leds, __NUM_LEDS, CHSV(__blinkHue, 255, bri));
-                    // The show() call uses the master brightness value that was last set by
-                    // applyBrightness(), which correctly scales display brightness by the global master brightness.
-                    FastLED.show();
-                }
-            }
+        case EFFECT_BLINK:
+            runBlinkEffect();
             break;
-        }
         case EFFECT_COMET: {
             if (__isMotorRunning && __currentLogicalSpeed > 0) {
                 unsigned long dynamicInterval = (unsigned long)max(1.0f, __ledIntervalMs);
                 if (millis() - __last_led_strip_update > dynamicInterval) {
                     __last_led_strip_update = millis();
                     
-                    uint8_t fadeAmount = 255 / __cometTailLength;
-                    fadeToBlackBy(__leds, __NUM_LEDS, fadeAmount);
-                    
-                    CRGB bgColor = CHSV(__bgHue, 255, __bgBrightness);
                     __onboard_led[0] = __isDirectionClockwise ? CRGB(0, 50, 0) : CRGB(0, 0, 50);
 
-                    for (int i = 0; i < __NUM_LEDS; i++) {
-                        __leds[i].r = max(__leds[i].r, bgColor.r);
-                        __leds[i].g = max(__leds[i].g, bgColor.g);
-                        __leds[i].b = max(__leds[i].b, bgColor.b);
-                    }
-
                     bool led_direction_is_forward = !__isDirectionClockwise ^ __isLedReversed;
-                    if (led_direction_is_forward) __led_position = (__led_position + 1) % __LOGICAL_NUM_LEDS;
-                    else __led_position = (__led_position - 1 + __LOGICAL_NUM_LEDS) % __LOGICAL_NUM_LEDS;
-
-                    for (int j = 0; j < __cometCount; j++) {
-                        int pos = (__led_position + j * (__LOGICAL_NUM_LEDS / __cometCount)) % __LOGICAL_NUM_LEDS;
-                        if (pos < __NUM_LEDS) __leds[pos] = CHSV(__cometHue, 255, 255);
-                    }
-                    // The show() call uses the master brightness value that was last set by
-                    // applyBrightness(), which correctly scales display brightness by the global master brightness.
-                    FastLED.show();
+                    stepCometGroups(led_direction_is_forward);
+                    renderCometGroups(led_direction_is_forward);
+                    showStrip();
                 }
             }
             break;
         }
         case EFFECT_FIRE:
-            runFireEffect();
+            runFireEffect<Sculpture>();
             break;
         case EFFECT_NOISE:
-            runNoiseEffect();
+            runNoiseEffect<Sculpture>();
             break;
         case EFFECT_TWINKLE:
-            runTwinkleEffect();
+            runTwinkleEffect<Sculpture>();
             break;
         case EFFECT_MARQUEE:
-            runMarqueeEffect();
+            runMarqueeEffect<Sculpture>();
+            break;
+        case EFFECT_PARTICLES:
+            runParticlesEffect<Sculpture>();
             break;
     }
+    __frameRenderStartUs = 0;
 
 
     // --- Non-Blocking Motor State Machine ---
+    LoopWatchdog::enterStage(LoopWatchdog::STAGE_MOTOR, EventTracer::now());
     if (__motorState != __MOTOR_IDLE) {
         // Use the pre-calculated rampStepDelay for the timer check.
         if (millis() - __lastRampStepTime > __rampStepDelay) {
@@ -1233,8 +2770,9 @@ void loop() {
             }
 
             // log_t("Ramping... Current Speed: %d", __currentLogicalSpeed); // This line is too verbose for normal operation.
+            EventTracer::instant(EventTracer::EV_RAMP_TICK, (uint16_t)__currentLogicalSpeed);
 
-            setMotorDuty(mapSpeedToDuty(__currentLogicalSpeed), __isDirectionClockwise);
+            setMotorDuty(mapSpeedToDuty<Sculpture>(__currentLogicalSpeed), __isDirectionClockwise);
 
             // Update LED timing to match the current physical speed during the ramp
             applySpeedSyncLookup(__currentLogicalSpeed);
@@ -1257,7 +2795,7 @@ void loop() {
                         __isMotorRunning = false;
                         __speedSetting = __LOGICAL_INITIAL_SPEED; // Reset for next start
                         __onboard_led[0] = CRGB(50, 0, 0); // Red when stopped
-                        FastLED.show();
+                        showStrip(); // Also pushes the strip, so it must go through the power budget
                     }
                     log_t("Ramp complete. Current Speed: %d", __currentLogicalSpeed);
                     log_t("Ramp complete. %s, From %d to %d in %lu millis", 
@@ -1269,6 +2807,7 @@ void loop() {
         }
     }
 
+    LoopWatchdog::enterStage(LoopWatchdog::STAGE_BUTTONS, EventTracer::now());
     // Priority 1: Long Press. This is the highest priority and cancels any pending clicks.
     if (M5.BtnA.pressedFor(2000)) {
         // Only trigger a stop if the motor is running and not already in the process of stopping.
@@ -1283,6 +2822,20 @@ void loop() {
         triggerSpeedUp();
     }
 
+    // --- Incremental Diagnostics Output ---
+    LoopWatchdog::enterStage(LoopWatchdog::STAGE_DIAGNOSTICS, EventTracer::now());
+    serviceCommandAcks();
+    serviceTraceDump();
+    serviceScriptDump();
+    serviceWatchdogDump();
+    serviceSysStatsDump();
+    serviceGenBench();
+    serviceRenderBench();
+    serviceParticleBench();
+    serviceCheckpoint();
+    serviceLcdDashboard();
+    LoopWatchdog::endPass(EventTracer::now(), millis(), __isScriptRunning ? __scriptCommandIndex : -1);
+
     // Yield to other tasks, especially the BLE stack, to prevent task starvation.
     delay(1);
 }
\ No newline at end of file
@@ -0,0 +1,105 @@
+#include "parallel_render.h"
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <esp_timer.h>
+#include <atomic>
+
+namespace ParallelRender {
+
+static const uint32_t __WORKER_STACK_BYTES = 3072;
+// Above the idle task and loop(); below the BLE host, which must not be starved.
+static const UBaseType_t __WORKER_PRIORITY = 2;
+
+// How long the caller waits for the worker to finish before checking whether it ever
+// started. Far longer than any half frame takes.
+static const TickType_t __JOIN_TIMEOUT_TICKS = pdMS_TO_TICKS(20);
+
+static TaskHandle_t __worker = nullptr;
+static TaskHandle_t __caller = nullptr;
+static bool __enabled = true;
+
+// The job for the worker's half. Written by the caller before the fork notify and
+// read by the worker after it, so no other synchronisation is needed.
+static RangeFn __jobFn = nullptr;
+static void* __jobArg = nullptr;
+static int __jobBegin = 0;
+static int __jobEnd = 0;
+
+// Who owns the job. The caller sets PENDING before the fork; the worker claims it
+// (PENDING -> RUNNING) before touching any pixel, and the caller can withdraw it
+// (PENDING -> IDLE) if the worker has not, so exactly one of them renders that half.
+enum JobState { JOB_IDLE, JOB_PENDING, JOB_RUNNING };
+static std::atomic<int> __jobState(JOB_IDLE);
+
+static uint32_t __splitCalls = 0;
+static uint32_t __serialCalls = 0;
+static uint32_t __maxJoinWaitUs = 0;
+static uint32_t __joinTimeouts = 0;
+
+static void workerTask(void*) {
+    for (;;) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        int expected = JOB_PENDING;
+        if (!__jobState.compare_exchange_strong(expected, JOB_RUNNING)) continue; // Withdrawn by the caller
+        __jobFn(__jobBegin, __jobEnd, __jobArg);
+        __jobState.store(JOB_IDLE);
+        xTaskNotifyGive(__caller);
+    }
+}
+
+bool begin() {
+    if (__worker != nullptr) return true;
+    BaseType_t core = (xPortGetCoreID() == 0) ? 1 : 0;
+    if (xTaskCreatePinnedToCore(workerTask, "render", __WORKER_STACK_BYTES, nullptr, __WORKER_PRIORITY, &__worker, core) != pdPASS) {
+        __worker = nullptr;
+        return false;
+    }
+    return true;
+}
+
+void setEnabled(bool enabled) { __enabled = enabled; }
+bool isEnabled() { return __enabled && __worker != nullptr; }
+
+void forEach(RangeFn fn, void* arg, int count, int minCount) {
+    if (count <= 0) return;
+    if (!isEnabled() || count < minCount) {
+        __serialCalls++;
+        fn(0, count, arg);
+        return;
+    }
+    int split = count / 2;
+    __jobFn = fn;
+    __jobArg = arg;
+    __jobBegin = split;
+    __jobEnd = count;
+    __caller = xTaskGetCurrentTaskHandle();
+    __jobState.store(JOB_PENDING);
+    xTaskNotifyGive(__worker); // Fork
+
+    fn(0, split, arg);
+
+    int64_t waitStart = esp_timer_get_time();
+    if (ulTaskNotifyTake(pdTRUE, __JOIN_TIMEOUT_TICKS) == 0) { // Join
+        int expected = JOB_PENDING;
+        if (__jobState.compare_exchange_strong(expected, JOB_IDLE)) {
+            // The worker never got the CPU. Render its half here and stop splitting,
+            // rather than pay this timeout every frame; render_split:on tries again.
+            fn(split, count, arg);
+            __enabled = false;
+            __joinTimeouts++;
+        } else {
+            // It has started writing into the caller's pixels, so it must be waited for.
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        }
+    }
+    uint32_t waited = (uint32_t)(esp_timer_get_time() - waitStart);
+    if (waited > __maxJoinWaitUs) __maxJoinWaitUs = waited;
+    __splitCalls++;
+}
+
+uint32_t splitCalls() { return __splitCalls; }
+uint32_t serialCalls() { return __serialCalls; }
+uint32_t maxJoinWaitUs() { return __maxJoinWaitUs; }
+uint32_t joinTimeouts() { return __joinTimeouts; }
+
+} // namespace ParallelRender
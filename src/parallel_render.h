@@ -0,0 +1,51 @@
+#pragma once
+
+#include <stdint.h>
+
+// Fork-join pixel rendering across both ESP32-S3 cores.
+//
+// loop() runs on one core and, at steady state, the other core mostly sits idle
+// between BLE events. begin() starts a small worker task pinned to that other core.
+// forEach() then hands the upper half of a pixel range to the worker, renders the
+// lower half itself, and waits for the worker before returning, so callers see an
+// ordinary blocking call.
+//
+// The fork and the join are direct-to-task notifications: no mutex, queue or heap
+// per frame, and the notify calls order the job fields and pixel writes between the
+// cores. Only range functions whose pixels are independent of each other (no reads
+// of neighbouring pixels, no shared random state) may be split. Fire's diffusion and
+// twinkle's random sparkles stay serial.
+//
+// The join waits a bounded time. If the worker has not started its half by then (the
+// other core is starved), the caller withdraws the job, renders that half itself and
+// switches splitting off. A half the worker has started is always waited for, since
+// it is writing into the caller's pixels.
+//
+// Only one task (the loop task) may call forEach().
+namespace ParallelRender {
+
+// Renders pixels [begin, end). `arg` is the caller's job description.
+typedef void (*RangeFn)(int begin, int end, void* arg);
+
+// Starts the worker on the core loop() is not on. Call from setup(): the task
+// stack is allocated here. Returns false if the task could not be created, in which
+// case forEach() runs everything on the calling core.
+bool begin();
+
+// Splitting can be switched off at run time (render_split:off) for comparison.
+void setEnabled(bool enabled);
+bool isEnabled();
+
+// Runs fn over [0, count). The range is split only when enabled and count is at
+// least `minCount`; below that, waking the other core costs more than it saves.
+void forEach(RangeFn fn, void* arg, int count, int minCount);
+
+// Calls split across both cores and calls run serially, since begin().
+uint32_t splitCalls();
+uint32_t serialCalls();
+// Longest the caller has waited for the worker after finishing its own half.
+uint32_t maxJoinWaitUs();
+// Joins that timed out with the worker not started, each switching splitting off.
+uint32_t joinTimeouts();
+
+} // namespace ParallelRender
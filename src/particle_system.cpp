@@ -0,0 +1,200 @@
+#include "particle_system.h"
+
+namespace ParticleSystem {
+
+// Life at which a particle starts to fade; brightness is life / 2 below it.
+static const uint16_t __FADE_MS = 510;
+// An update longer than this (a stalled loop) is shortened, so nothing jumps.
+static const uint32_t __MAX_STEP_MS = 100;
+// Limits on what commands can ask for, so Q16.16 values and emitter loops stay bounded.
+static const int __MAX_SPEED = 10000;   // LEDs per second (or per second squared)
+static const int __MAX_RATE = 10000;    // Particles per second per emitter
+
+// The pool. Entries [0, __count) are live.
+static fixed_t __position[MAX_PARTICLES];
+static fixed_t __velocity[MAX_PARTICLES];
+static uint8_t __hue[MAX_PARTICLES];
+static uint16_t __life[MAX_PARTICLES];
+static int __count = 0;
+
+struct Emitter {
+    uint32_t ratePerSecond; // 0 when off
+    fixed_t position;
+    fixed_t speed;
+    fixed_t spread;
+    uint8_t hue;
+    uint16_t lifeMs;
+    uint32_t owed;          // Particles owed, in thousandths
+};
+static Emitter __emitters[MAX_EMITTERS];
+
+static fixed_t __lengthQ = 223 * ONE;
+static int __visibleLeds = 198;
+static fixed_t __gravity = 0;
+
+static uint32_t __spawned = 0;
+static uint32_t __expired = 0;
+static uint32_t __dropped = 0;
+static uint32_t __rng = 0x9e3779b9u;
+
+// xorshift32: cheap, and repeatable for benchmarks.
+static uint32_t nextRandom() {
+    __rng ^= __rng << 13;
+    __rng ^= __rng >> 17;
+    __rng ^= __rng << 5;
+    return __rng;
+}
+
+static fixed_t toFixed(int value, int limit) {
+    if (value > limit) value = limit;
+    if (value < -limit) value = -limit;
+    return (fixed_t)value * ONE;
+}
+
+// Brings a position onto the logical strip, wrapping like the comets.
+static fixed_t wrapPosition(fixed_t p) {
+    if (p >= 0 && p < __lengthQ) return p;
+    p %= __lengthQ;
+    return (p < 0) ? p + __lengthQ : p;
+}
+
+// Uniform in [-range, range].
+static fixed_t randomSpread(fixed_t range) {
+    if (range <= 0) return 0;
+    return (fixed_t)(nextRandom() % (2 * (uint32_t)range + 1)) - range;
+}
+
+void configure(int logicalLength, int visibleLeds) {
+    __lengthQ = (fixed_t)(logicalLength > 0 ? logicalLength : 1) << FRACTION_BITS;
+    __visibleLeds = (visibleLeds < logicalLength) ? visibleLeds : logicalLength;
+}
+
+void reset() {
+    __count = 0;
+    for (int i = 0; i < MAX_EMITTERS; i++) __emitters[i].ratePerSecond = 0;
+    __gravity = 0;
+    __spawned = __expired = __dropped = 0;
+}
+
+bool spawn(fixed_t position, fixed_t velocity, uint8_t hue, uint16_t lifeMs) {
+    if (__count >= MAX_PARTICLES || lifeMs == 0) {
+        __dropped++;
+        return false;
+    }
+    __position[__count] = wrapPosition(position);
+    __velocity[__count] = velocity;
+    __hue[__count] = hue;
+    __life[__count] = lifeMs;
+    __count++;
+    __spawned++;
+    return true;
+}
+
+int burst(int position, int count, int speed, uint8_t hue, uint16_t lifeMs) {
+    int added = 0;
+    fixed_t at = toFixed(position, __lengthQ >> FRACTION_BITS);
+    fixed_t range = toFixed(speed < 0 ? -speed : speed, __MAX_SPEED);
+    for (int i = 0; i < count; i++) {
+        if (!spawn(at, randomSpread(range), hue, lifeMs)) break;
+        added++;
+    }
+    return added;
+}
+
+bool setEmitter(int slot, int position, int ratePerSecond, int speed, int spread, uint8_t hue, uint16_t lifeMs) {
+    if (slot < 0 || slot >= MAX_EMITTERS) return false;
+    Emitter& e = __emitters[slot];
+    e.ratePerSecond = (ratePerSecond > 0) ? (uint32_t)(ratePerSecond < __MAX_RATE ? ratePerSecond : __MAX_RATE) : 0;
+    e.position = wrapPosition(toFixed(position, __lengthQ >> FRACTION_BITS));
+    e.speed = toFixed(speed, __MAX_SPEED);
+    e.spread = toFixed(spread < 0 ? -spread : spread, __MAX_SPEED);
+    e.hue = hue;
+    e.lifeMs = lifeMs;
+    e.owed = 0;
+    return true;
+}
+
+void setGravity(int ledsPerSecondSquared) {
+    __gravity = toFixed(ledsPerSecondSquared, __MAX_SPEED);
+}
+
+int gravity() { return __gravity >> FRACTION_BITS; }
+
+void update(uint32_t dtMs) {
+    if (dtMs > __MAX_STEP_MS) dtMs = __MAX_STEP_MS;
+
+    for (int s = 0; s < MAX_EMITTERS; s++) {
+        Emitter& e = __emitters[s];
+        if (e.ratePerSecond == 0) continue;
+        e.owed += e.ratePerSecond * dtMs;
+        for (; e.owed >= 1000; e.owed -= 1000) {
+            spawn(e.position, e.speed + randomSpread(e.spread), e.hue, e.lifeMs);
+        }
+    }
+
+    // dt in Q16.16 seconds, so each particle costs two multiplies and no divide.
+    const fixed_t dt = (fixed_t)(((uint32_t)dtMs << FRACTION_BITS) / 1000);
+    const fixed_t dv = (fixed_t)(((int64_t)__gravity * dt) >> FRACTION_BITS);
+    const bool falling = __gravity != 0;
+    for (int i = 0; i < __count;) {
+        if (__life[i] <= dtMs) {
+            // Swap the last live particle into the hole, keeping the pool packed.
+            __count--;
+            __position[i] = __position[__count];
+            __velocity[i] = __velocity[__count];
+            __hue[i] = __hue[__count];
+            __life[i] = __life[__count];
+            __expired++;
+            continue;
+        }
+        __life[i] -= (uint16_t)dtMs;
+        __velocity[i] += dv;
+        fixed_t p = __position[i] + (fixed_t)(((int64_t)__velocity[i] * dt) >> FRACTION_BITS);
+        if (p < 0 || p >= __lengthQ) {
+            if (falling) __life[i] = 0; // Left the strip: not drawn, and removed on the next update
+            p = wrapPosition(p);
+        }
+        __position[i] = p;
+        i++;
+    }
+}
+
+static inline void addScaled(uint8_t* pixel, const uint8_t* color, uint16_t weight) {
+    for (int c = 0; c < 3; c++) {
+        uint16_t v = pixel[c] + ((color[c] * weight) >> 8);
+        pixel[c] = (v > 255) ? 255 : (uint8_t)v;
+    }
+}
+
+void render(uint8_t* rgb, const uint8_t (*hueRgb)[3]) {
+    const int length = __lengthQ >> FRACTION_BITS;
+    for (int i = 0; i < __count; i++) {
+        uint16_t life = __life[i];
+        uint16_t brightness = (life >= __FADE_MS) ? 256 : (uint16_t)(life >> 1);
+        if (brightness == 0) continue;
+        int led = __position[i] >> FRACTION_BITS;
+        uint16_t frac = (uint16_t)((__position[i] >> (FRACTION_BITS - 8)) & 0xff);
+        const uint8_t* color = hueRgb[__hue[i]];
+        // Split between this LED and the next by the fractional position.
+        uint16_t upper = (uint16_t)((brightness * frac) >> 8);
+        if (led < __visibleLeds) addScaled(rgb + 3 * led, color, brightness - upper);
+        int next = (led + 1 < length) ? led + 1 : 0;
+        if (upper > 0 && next < __visibleLeds) addScaled(rgb + 3 * next, color, upper);
+    }
+}
+
+int liveCount() { return __count; }
+
+int activeEmitters() {
+    int n = 0;
+    for (int i = 0; i < MAX_EMITTERS; i++) {
+        if (__emitters[i].ratePerSecond > 0) n++;
+    }
+    return n;
+}
+
+uint32_t spawned() { return __spawned; }
+uint32_t expired() { return __expired; }
+uint32_t dropped() { return __dropped; }
+
+} // namespace ParticleSystem
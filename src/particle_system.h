@@ -0,0 +1,67 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// A particle engine for the "particles" LED effect.
+//
+// Particles move along the logical strip (the helix, plus the virtual gap), so index
+// is height. Their state is kept as a structure of arrays in a fixed pool: position,
+// velocity, hue and remaining life, with live particles packed at the front. A frame
+// touches only the live ones, so its cost scales with the live count, not the pool.
+//
+// Kinematics are fixed point: positions in LEDs and velocities in LEDs per second,
+// both Q16.16. Without gravity, particles wrap around the logical strip like comets.
+// With gravity (an acceleration along the height) they fall, and die when they leave
+// the strip at either end. Every particle fades out over its last half second.
+//
+// Particles come from spawn() and burst() directly, or from up to MAX_EMITTERS
+// emitters, each putting out a steady rate at one height. render() adds them into an
+// RGB frame, blending each across the two LEDs it sits between.
+//
+// Nothing here allocates or touches Arduino APIs, so it also builds on the host. Only
+// the loop task may call these functions.
+namespace ParticleSystem {
+
+const int MAX_PARTICLES = 1024;
+const int MAX_EMITTERS = 4;
+
+// Q16.16 fixed point.
+typedef int32_t fixed_t;
+const int FRACTION_BITS = 16;
+const fixed_t ONE = (fixed_t)1 << FRACTION_BITS;
+
+// `logicalLength` is the strip plus its virtual gap; only the first `visibleLeds` are drawn.
+void configure(int logicalLength, int visibleLeds);
+// Drops every particle and emitter and turns gravity off.
+void reset();
+
+// Adds one particle at `position` (LEDs) moving at `velocity` (LEDs per second).
+// Returns false, and counts a drop, if the pool is full.
+bool spawn(fixed_t position, fixed_t velocity, uint8_t hue, uint16_t lifeMs);
+// Adds `count` particles at LED `position` with random speeds up to `speed` LEDs per
+// second, in both directions. Returns how many fitted.
+int burst(int position, int count, int speed, uint8_t hue, uint16_t lifeMs);
+
+// Emitter `slot` puts out `ratePerSecond` particles at LED `position`, moving at
+// `speed` plus or minus up to `spread` LEDs per second. A rate of 0 turns it off.
+bool setEmitter(int slot, int position, int ratePerSecond, int speed, int spread, uint8_t hue, uint16_t lifeMs);
+// Acceleration along the height in LEDs per second squared; negative pulls toward LED 0.
+void setGravity(int ledsPerSecondSquared);
+int gravity();
+
+// Advances every particle and emitter by `dtMs`.
+void update(uint32_t dtMs);
+
+// Adds the particles into `rgb` (visibleLeds pixels of 3 bytes), saturating. `hueRgb`
+// gives the full-brightness colour of each hue.
+void render(uint8_t* rgb, const uint8_t (*hueRgb)[3]);
+
+int liveCount();
+int activeEmitters();
+// Since the last reset(): particles added, expired and dropped because the pool was full.
+uint32_t spawned();
+uint32_t expired();
+uint32_t dropped();
+
+} // namespace ParticleSystem
@@ -0,0 +1,695 @@
+#include "phase_templates.h"
+#include "script_timeline.h"
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+namespace PhaseTemplates {
+
+struct Line {
+    const char* text;
+    uint8_t len;
+};
+
+struct Scene {
+    uint16_t weight;
+    uint16_t first;
+    uint16_t count;
+    char effect[12]; // LED effect the scene shows (as named by the firmware), or "" if unknown
+};
+
+struct Phase {
+    char name[16];
+    long durationLo, durationHi;
+    int scenesLo, scenesHi;
+    uint16_t prologueFirst, prologueCount;
+    uint16_t firstScene, sceneCount;
+    uint16_t outroFirst, outroCount;
+    uint16_t maxLines; // Most lines one run of the phase can emit
+};
+
+struct TemplateSet {
+    Line lines[MAX_LINES];
+    Scene scenes[MAX_SCENES];
+    Phase phases[MAX_PHASES];
+    int lineCount;
+    int sceneCount;
+    int phaseCount;
+};
+
+// A body phase needs about this long for one pass; shorter shows shrink the
+// introduction and cool-down instead.
+static const long __MIN_BODY_MS = 120000;
+
+static TemplateSet __active;
+static TemplateSet __staging; // load() parses here and only copies over on success
+
+static const char* const __calmPalettes[] = { "cloud", "ocean", "forest" };
+static const char* const __energeticPalettes[] = { "lava", "party", "rainbow" };
+
+#define COUNT_OF(a) (sizeof(a) / sizeof((a)[0]))
+
+// --- Expansion ---
+
+// What the emitted script has set so far, carried from phase to phase.
+struct ShowState {
+    int motorSpeed;     // Last motor_speed emitted, or -1
+    int displayPercent; // Last led_display_brightness emitted
+};
+
+struct Expander {
+    const Context* ctx;
+    long vars[26];
+    long rest;              // Scene time not yet covered by a hold
+    long split;             // {split} inside the current @repeat
+    long extraMs;           // Time the phase needs beyond its scenes
+    ShowState show;         // Motor speed and display brightness as emitted so far
+    bool lastOptionalTaken; // Whether the last "?NN" line was emitted
+};
+
+// Takes the time a step costs out of the scene; what the scene cannot cover makes
+// the phase run long.
+static void charge(Expander& x, long ms) {
+    if (ms <= x.rest) {
+        x.rest -= ms;
+    } else {
+        x.extraMs += ms - x.rest;
+        x.rest = 0;
+    }
+}
+
+// Inclusive range, unlike Arduino's random(lo, hi).
+static long rnd(const Expander& x, long lo, long hi) {
+    return (hi <= lo) ? lo : x.ctx->random(lo, hi + 1);
+}
+
+static bool parseLong(const char*& p, const char* end, long* value) {
+    if (p >= end || !isdigit((unsigned char)*p)) return false;
+    long v = 0;
+    while (p < end && isdigit((unsigned char)*p)) v = v * 10 + (*p++ - '0');
+    *value = v;
+    return true;
+}
+
+// "N" or "LO-HI".
+static bool parseRange(const char*& p, const char* end, long* lo, long* hi) {
+    if (!parseLong(p, end, lo)) return false;
+    *hi = *lo;
+    if (p + 1 < end && *p == '-' && isdigit((unsigned char)p[1])) {
+        p++;
+        parseLong(p, end, hi);
+    }
+    return *lo <= *hi;
+}
+
+static bool startsWith(const char* p, const char* end, const char* prefix) {
+    size_t len = strlen(prefix);
+    return (size_t)(end - p) >= len && memcmp(p, prefix, len) == 0;
+}
+
+// LO-HI, v, v+LO-HI or v-LO-HI.
+static bool evalNumber(const char* p, const char* end, Expander& x, long* value) {
+    if (p < end && isdigit((unsigned char)*p)) {
+        long lo, hi;
+        if (!parseRange(p, end, &lo, &hi) || p != end) return false;
+        *value = rnd(x, lo, hi);
+        return true;
+    }
+    if (p >= end || !islower((unsigned char)*p)) return false;
+    long v = x.vars[*p++ - 'a'];
+    if (p < end) {
+        char op = *p++;
+        long lo, hi;
+        if ((op != '+' && op != '-') || !parseRange(p, end, &lo, &hi) || p != end) return false;
+        long d = rnd(x, lo, hi);
+        v = (((op == '+' ? v + d : v - d) % 256) + 256) % 256;
+    }
+    *value = v;
+    return true;
+}
+
+// Evaluates the text between '{' and '}' into `out`.
+static bool evalPlaceholder(const char* p, const char* end, Expander& x, char* out, size_t len) {
+    long value = 0;
+    if (startsWith(p, end, "pal:")) {
+        p += 4;
+        const char* const* names;
+        size_t count;
+        if (end - p == 4 && memcmp(p, "calm", 4) == 0) {
+            names = __calmPalettes;
+            count = COUNT_OF(__calmPalettes);
+        } else if (end - p == 9 && memcmp(p, "energetic", 9) == 0) {
+            names = __energeticPalettes;
+            count = COUNT_OF(__energeticPalettes);
+        } else {
+            return false;
+        }
+        snprintf(out, len, "%s", names[rnd(x, 0, (long)count - 1)]);
+        return true;
+    } else if (startsWith(p, end, "rev:")) {
+        p += 4;
+        long lo, hi;
+        if (p + 2 > end || !islower((unsigned char)p[0]) || p[1] != '*') return false;
+        long speed = x.vars[p[0] - 'a'];
+        p += 2;
+        if (!parseRange(p, end, &lo, &hi) || p != end) return false;
+        value = x.ctx->revTimeMs((int)speed) * rnd(x, lo, hi) / 100;
+    } else if (end - p == 5 && memcmp(p, "split", 5) == 0) {
+        value = x.split;
+    } else if (startsWith(p, end, "rest/")) {
+        p += 5;
+        long n;
+        if (!parseLong(p, end, &n) || p != end || n == 0) return false;
+        value = x.rest / n;
+    } else if (end - p >= 2 && islower((unsigned char)p[0]) && p[1] == '=') {
+        if (!evalNumber(p + 2, end, x, &value)) return false;
+        x.vars[p[0] - 'a'] = value;
+    } else if (!evalNumber(p, end, x, &value)) {
+        return false;
+    }
+    snprintf(out, len, "%ld", value);
+    return true;
+}
+
+// Expands every placeholder in a command line. Returns false on a syntax error or if
+// the result does not fit.
+static bool expandText(const char* p, const char* end, Expander& x, char* out, size_t len) {
+    size_t n = 0;
+    while (p < end) {
+        if (*p == '{') {
+            const char* close = (const char*)memchr(p, '}', end - p);
+            if (close == nullptr) return false;
+            char value[24];
+            if (!evalPlaceholder(p + 1, close, x, value, sizeof(value))) return false;
+            size_t vlen = strlen(value);
+            if (n + vlen >= len) return false;
+            memcpy(out + n, value, vlen);
+            n += vlen;
+            p = close + 1;
+        } else {
+            if (n + 1 >= len) return false;
+            out[n++] = *p++;
+        }
+    }
+    out[n] = '\0';
+    return true;
+}
+
+// Handles a "?NN " / "?! " prefix. Returns false if the line is not to be emitted.
+static bool takeOptional(const char*& p, const char* end, Expander& x, bool* ok) {
+    *ok = true;
+    if (p >= end || *p != '?') return true;
+    p++;
+    bool take;
+    if (p < end && *p == '!') {
+        p++;
+        take = !x.lastOptionalTaken;
+    } else {
+        long percent;
+        if (!parseLong(p, end, &percent)) {
+            *ok = false;
+            return false;
+        }
+        take = rnd(x, 0, 99) < percent;
+        x.lastOptionalTaken = take;
+    }
+    if (p >= end || *p != ' ') {
+        *ok = false;
+        return false;
+    }
+    p++;
+    return take;
+}
+
+static void emitLine(const TemplateSet& set, int index, Expander& x, ScriptBuffer& script) {
+    const Line& l = set.lines[index];
+    const char* p = l.text;
+    const char* end = l.text + l.len;
+    bool ok;
+    if (!takeOptional(p, end, x, &ok)) return;
+    char out[MAX_LINE_LEN + 1];
+    if (!expandText(p, end, x, out, sizeof(out))) return; // Rejected by load(); not reached
+    script.push(out);
+    // Same costs as ScriptTimeline's planned time: the engine waits out every ramp.
+    if (strncmp(out, "hold:", 5) == 0) {
+        charge(x, atol(out + 5));
+    } else if (strncmp(out, "motor_speed:", 12) == 0) {
+        int speed = atoi(out + 12);
+        if (speed != x.show.motorSpeed) charge(x, x.ctx->rampMs);
+        x.show.motorSpeed = speed;
+    } else if (strncmp(out, "led_display_brightness:", 23) == 0) {
+        x.show.displayPercent = atoi(out + 23);
+    } else if (strcmp(out, "motor_reverse") == 0) {
+        charge(x, 2 * (long)x.ctx->rampMs); // Down to the intermediate speed, then back up
+    }
+}
+
+static bool isDirective(const Line& l, const char* name) {
+    size_t len = strlen(name);
+    return l.len >= len && memcmp(l.text, name, len) == 0 && (l.len == len || l.text[len] == ' ');
+}
+
+// Index of the "@end" closing the block that opens at `open`.
+static int blockEnd(const TemplateSet& set, int open, int end) {
+    for (int i = open + 1; i < end; i++) {
+        if (isDirective(set.lines[i], "@end")) return i;
+    }
+    return end;
+}
+
+static void runLines(const TemplateSet& set, int first, int count, Expander& x, ScriptBuffer& script) {
+    int end = first + count;
+    int i = first;
+    while (i < end) {
+        const Line& l = set.lines[i];
+        if (isDirective(l, "@over")) {
+            int close = blockEnd(set, i, end);
+            const char* p = l.text + 6;
+            long threshold = 0;
+            parseLong(p, l.text + l.len, &threshold);
+            if (x.rest > threshold) runLines(set, i + 1, close - i - 1, x, script);
+            i = close + 1;
+        } else if (isDirective(l, "@repeat")) {
+            int close = blockEnd(set, i, end);
+            const char* p = l.text + 8;
+            const char* lineEnd = l.text + l.len;
+            long lo = 1, hi = 1, minSplit = 0;
+            parseRange(p, lineEnd, &lo, &hi);
+            if (p < lineEnd && *p == ' ') p++;
+            parseLong(p, lineEnd, &minSplit);
+            long times = rnd(x, lo, hi);
+            long split = x.rest / (times + 1);
+            if (split > minSplit) {
+                x.split = split;
+                for (long t = 0; t < times; t++) runLines(set, i + 1, close - i - 1, x, script);
+            }
+            i = close + 1;
+        } else {
+            emitLine(set, i, x, script);
+            i++;
+        }
+    }
+}
+
+// A scene's weight, cut to a quarter if the host expects its effect to run into the
+// strip's power limit at the display brightness in force.
+static long sceneWeight(const Scene& scene, const Expander& x) {
+    long weight = scene.weight;
+    if (x.ctx->wouldLimit && scene.effect[0] && x.ctx->wouldLimit(scene.effect, x.show.displayPercent)) {
+        weight = (weight + 3) / 4;
+    }
+    return weight;
+}
+
+static int pickScene(const TemplateSet& set, const Phase& phase, Expander& x) {
+    long weights[MAX_SCENES];
+    long total = 0;
+    for (int s = 0; s < phase.sceneCount; s++) {
+        weights[s] = sceneWeight(set.scenes[phase.firstScene + s], x);
+        total += weights[s];
+    }
+    long r = rnd(x, 0, total - 1);
+    for (int s = 0; s < phase.sceneCount; s++) {
+        r -= weights[s];
+        if (r < 0) return phase.firstScene + s;
+    }
+    return phase.firstScene + phase.sceneCount - 1;
+}
+
+static void resetExpander(Expander& x, const Context& ctx) {
+    memset(&x, 0, sizeof(x));
+    x.ctx = &ctx;
+}
+
+// Emits one phase. `durationMs` < 0 means "pick from the phase's own range". Scenes
+// are cut short to fit `budgetMs`. Returns the planned time used.
+static long runPhase(int index, long durationMs, long budgetMs, const Context& ctx, ShowState& show, ScriptBuffer& script) {
+    const TemplateSet& set = __active;
+    const Phase& phase = set.phases[index];
+    Expander x;
+    resetExpander(x, ctx);
+    x.show = show;
+
+    script.pushf("[---------- %s ----------]", phase.name);
+    runLines(set, phase.prologueFirst, phase.prologueCount, x, script);
+
+    long duration = (durationMs >= 0) ? durationMs : rnd(x, phase.durationLo, phase.durationHi);
+    long scenes = rnd(x, phase.scenesLo, phase.scenesHi);
+    long perScene = duration / scenes;
+    long used = 0;
+    for (long s = 0; s < scenes; s++) {
+        long remaining = budgetMs - used - x.extraMs;
+        if (s > 0 && remaining <= 1000) break;
+        long sceneMs = perScene;
+        if (sceneMs > remaining && remaining > 1000) sceneMs = remaining;
+        if (sceneMs <= 1000) break;
+
+        const Scene& scene = set.scenes[pickScene(set, phase, x)];
+        x.vars['h' - 'a'] = rnd(x, 0, 255);
+        x.rest = sceneMs;
+        runLines(set, scene.first, scene.count, x, script);
+        if (x.rest > 0) script.pushf("hold:%ld", x.rest);
+        used += sceneMs;
+    }
+
+    x.rest = 0;
+    runLines(set, phase.outroFirst, phase.outroCount, x, script);
+    show = x.show;
+    return used + x.extraMs;
+}
+
+// --- Loading ---
+
+static const char* trimmed(const char* p, const char* end, const char** trimmedEnd) {
+    const char* hash = (const char*)memchr(p, '#', end - p);
+    if (hash) end = hash;
+    while (p < end && (*p == ' ' || *p == '\t')) p++;
+    while (end > p && (end[-1] == ' ' || end[-1] == '\t' || end[-1] == '\r')) end--;
+    *trimmedEnd = end;
+    return p;
+}
+
+// Always answers with the low end of a range, so validation is repeatable.
+static long validationRandom(long low, long) { return low; }
+static long validationRevTime(int) { return 1000; }
+
+static bool validateCommandLine(const char* p, const char* end) {
+    static const Context ctx = { validationRandom, validationRevTime, 0, nullptr };
+    Expander x;
+    resetExpander(x, ctx);
+    x.rest = 60000;
+    bool ok;
+    takeOptional(p, end, x, &ok);
+    if (!ok) return false;
+    char out[MAX_LINE_LEN + 1];
+    return expandText(p, end, x, out, sizeof(out));
+}
+
+// Lines a scene emits at most: every line, @repeat blocks at their highest count, and
+// the closing hold.
+static int sceneMaxLines(const TemplateSet& set, const Scene& scene) {
+    int lines = 1;
+    int repeat = 1;
+    for (int i = scene.first; i < scene.first + scene.count; i++) {
+        const Line& l = set.lines[i];
+        if (isDirective(l, "@repeat")) {
+            const char* p = l.text + 8;
+            long lo = 1, hi = 1;
+            parseRange(p, l.text + l.len, &lo, &hi);
+            repeat = (int)hi;
+        } else if (isDirective(l, "@end")) {
+            repeat = 1;
+        } else if (!isDirective(l, "@over")) {
+            lines += repeat;
+        }
+    }
+    return lines;
+}
+
+static uint16_t phaseMaxLines(const TemplateSet& set, const Phase& phase) {
+    int scene = 0;
+    for (int s = 0; s < phase.sceneCount; s++) {
+        int lines = sceneMaxLines(set, set.scenes[phase.firstScene + s]);
+        if (lines > scene) scene = lines;
+    }
+    long total = 1 + phase.prologueCount + phase.outroCount + (long)phase.scenesHi * scene; // 1: the marker
+    return (uint16_t)(total < 0xFFFF ? total : 0xFFFF);
+}
+
+// Names the effect a scene shows after its first effect command (optional or not):
+// led_effect:NAME, "blink" for led_blink, or "comet" after led_reset. Left empty if the
+// scene keeps whatever effect was already running.
+static void sceneEffect(const TemplateSet& set, Scene& scene) {
+    scene.effect[0] = '\0';
+    for (int i = scene.first; i < scene.first + scene.count; i++) {
+        const Line& l = set.lines[i];
+        const char* p = l.text;
+        const char* end = l.text + l.len;
+        if (p < end && *p == '?') {
+            const char* space = (const char*)memchr(p, ' ', end - p);
+            if (space == nullptr) continue;
+            p = space + 1;
+        }
+        if (startsWith(p, end, "led_effect:")) {
+            p += 11;
+            size_t n = 0;
+            while (p + n < end && isalpha((unsigned char)p[n]) && n < sizeof(scene.effect) - 1) n++;
+            memcpy(scene.effect, p, n);
+            scene.effect[n] = '\0';
+            return;
+        } else if (startsWith(p, end, "led_blink:")) {
+            strcpy(scene.effect, "blink");
+            return;
+        } else if (startsWith(p, end, "led_reset")) {
+            strcpy(scene.effect, "comet");
+            return;
+        }
+    }
+}
+
+enum Section { SECTION_NONE, SECTION_PROLOGUE, SECTION_SCENE, SECTION_OUTRO };
+
+static bool parse(const char* text, TemplateSet& set, int* errorLine) {
+    memset(&set, 0, sizeof(set));
+    Section section = SECTION_NONE;
+    bool inBlock = false;
+    int lineNumber = 0;
+    const char* p = text;
+    while (*p) {
+        const char* nl = strchr(p, '\n');
+        const char* rawEnd = nl ? nl : p + strlen(p);
+        lineNumber++;
+        *errorLine = lineNumber;
+        const char* end;
+        const char* s = trimmed(p, rawEnd, &end);
+        p = nl ? nl + 1 : rawEnd;
+        if (s == end) continue;
+
+        Phase* phase = (set.phaseCount > 0) ? &set.phases[set.phaseCount - 1] : nullptr;
+        if (startsWith(s, end, "phase ")) {
+            if (inBlock || set.phaseCount >= MAX_PHASES) return false;
+            if (phase && phase->sceneCount == 0) return false;
+            Phase& ph = set.phases[set.phaseCount++];
+            s += 6;
+            const char* nameEnd = (const char*)memchr(s, ' ', end - s);
+            if (nameEnd == nullptr || nameEnd == s || (size_t)(nameEnd - s) >= sizeof(ph.name)) return false;
+            memcpy(ph.name, s, nameEnd - s);
+            s = nameEnd + 1;
+            if (!parseRange(s, end, &ph.durationLo, &ph.durationHi)) return false;
+            long lo = 1, hi = 1;
+            if (s < end) {
+                if (*s++ != ' ' || !parseRange(s, end, &lo, &hi) || s != end || lo < 1) return false;
+            }
+            ph.scenesLo = (int)lo;
+            ph.scenesHi = (int)hi;
+            ph.prologueFirst = (uint16_t)set.lineCount;
+            ph.firstScene = (uint16_t)set.sceneCount;
+            section = SECTION_PROLOGUE;
+        } else if (startsWith(s, end, "scene ")) {
+            if (phase == nullptr || inBlock || section == SECTION_OUTRO || set.sceneCount >= MAX_SCENES) return false;
+            s += 6;
+            long weight;
+            if (!parseLong(s, end, &weight) || s != end || weight <= 0 || weight > 0xFFFF) return false;
+            Scene& sc = set.scenes[set.sceneCount++];
+            sc.weight = (uint16_t)weight;
+            sc.first = (uint16_t)set.lineCount;
+            phase->sceneCount++;
+            section = SECTION_SCENE;
+        } else if (end - s == 5 && memcmp(s, "outro", 5) == 0) {
+            if (phase == nullptr || inBlock || section == SECTION_OUTRO) return false;
+            phase->outroFirst = (uint16_t)set.lineCount;
+            section = SECTION_OUTRO;
+        } else {
+            if (phase == nullptr || set.lineCount >= MAX_LINES || (size_t)(end - s) > MAX_LINE_LEN) return false;
+            Line line = { s, (uint8_t)(end - s) };
+            if (isDirective(line, "@end")) {
+                if (!inBlock) return false;
+                inBlock = false;
+            } else if (isDirective(line, "@over") || isDirective(line, "@repeat")) {
+                if (inBlock || section != SECTION_SCENE) return false;
+                inBlock = true;
+            } else if (!validateCommandLine(s, end)) {
+                return false;
+            }
+            set.lines[set.lineCount++] = line;
+            if (section == SECTION_PROLOGUE) phase->prologueCount++;
+            else if (section == SECTION_SCENE) set.scenes[set.sceneCount - 1].count++;
+            else phase->outroCount++;
+        }
+    }
+    if (inBlock || set.phaseCount == 0 || set.phases[set.phaseCount - 1].sceneCount == 0) return false;
+    for (int i = 0; i < set.phaseCount; i++) set.phases[i].maxLines = phaseMaxLines(set, set.phases[i]);
+    for (int i = 0; i < set.sceneCount; i++) sceneEffect(set, set.scenes[i]);
+    *errorLine = 0;
+    return true;
+}
+
+bool load(const char* text, int* errorLine) {
+    int line = 0;
+    if (!parse(text, __staging, &line)) {
+        if (errorLine) *errorLine = line;
+        return false;
+    }
+    __active = __staging;
+    if (errorLine) *errorLine = 0;
+    return true;
+}
+
+int phaseCount() { return __active.phaseCount; }
+
+const char* phaseName(int phase) {
+    return (phase >= 0 && phase < __active.phaseCount) ? __active.phases[phase].name : "?";
+}
+
+int sceneCount(int phase) {
+    return (phase >= 0 && phase < __active.phaseCount) ? __active.phases[phase].sceneCount : 0;
+}
+
+int findPhase(const char* name) {
+    for (int i = 0; i < __active.phaseCount; i++) {
+        if (strcmp(__active.phases[i].name, name) == 0) return i;
+    }
+    return -1;
+}
+
+// --- Composition ---
+
+// Fitting passes. One is normally exact; a finite blink overlapping a hold can need
+// another.
+static const int __FIT_PASSES = 3;
+// Largest hold scale. A show the line budget cut short may stretch its scenes further
+// to still run its full length.
+static const int __MAX_HOLD_SCALE = 2;
+static const int __MAX_HOLD_SCALE_LINE_LIMITED = 4;
+
+// Scales every hold so the script's predicted length approaches `targetMs`. The passes
+// only predict; the holds are rewritten once, and only if the longer lines fit the
+// pool, so a failed fit leaves the composed holds rather than a half-scaled script.
+static void fitHolds(long targetMs, const Context& ctx, ScriptBuffer& script, Composition& c) {
+    uint32_t composedHoldMs = 0;
+    long predicted = (long)ScriptTimeline::plannedMs(script, ctx.rampMs, &composedHoldMs);
+    c.predictedMs = predicted;
+    c.fittedMs = predicted;
+    c.holdScalePercent = 100;
+    c.fitFailed = false;
+    if (composedHoldMs == 0) return;
+
+    const int64_t maxWantMs = (int64_t)composedHoldMs * (c.lineLimited ? __MAX_HOLD_SCALE_LINE_LIMITED : __MAX_HOLD_SCALE);
+    // Keep scenes recognisable: never below half their composed length.
+    const int64_t minWantMs = composedHoldMs / 2;
+    int64_t wantMs = composedHoldMs;
+    uint32_t holdMs = composedHoldMs;
+    for (int pass = 0; pass < __FIT_PASSES; pass++) {
+        long error = predicted - targetMs;
+        if (labs(error) <= FIT_TOLERANCE_MS) break;
+        int64_t next = (int64_t)holdMs - error;
+        if (next < minWantMs) next = minWantMs;
+        if (next > maxWantMs) next = maxWantMs;
+        if (next == wantMs) break; // Pinned at a limit
+        wantMs = next;
+        ScriptTimeline::HoldScaler scaler(wantMs, composedHoldMs);
+        predicted = (long)ScriptTimeline::plannedMs(script, ctx.rampMs, scaler, &holdMs);
+    }
+    if (wantMs == (int64_t)composedHoldMs) return;
+
+    // A line that grows is appended to the pool, so check the room first.
+    char line[32];
+    size_t growth = 0;
+    ScriptTimeline::HoldScaler sizing(wantMs, composedHoldMs);
+    for (int i = 0; i < script.size(); i++) {
+        if (strncmp(script[i], "hold:", 5) != 0) continue;
+        long hold = atol(script[i] + 5);
+        if (hold <= 0) continue;
+        size_t len = (size_t)snprintf(line, sizeof(line), "hold:%ld", sizing.next(hold));
+        if (len > strlen(script[i])) growth += len + 1;
+    }
+    if (growth > script.bytesFree()) {
+        c.fitFailed = true;
+        return;
+    }
+    ScriptTimeline::HoldScaler scaler(wantMs, composedHoldMs);
+    for (int i = 0; i < script.size(); i++) {
+        if (strncmp(script[i], "hold:", 5) != 0) continue;
+        long hold = atol(script[i] + 5);
+        if (hold <= 0) continue;
+        snprintf(line, sizeof(line), "hold:%ld", scaler.next(hold));
+        if (!script.replace(i, line)) {
+            // Cannot happen after the check above, but a half-scaled script must say so.
+            c.fitFailed = true;
+            c.fittedMs = (long)ScriptTimeline::plannedMs(script, ctx.rampMs, &holdMs);
+            c.holdScalePercent = (int)((int64_t)holdMs * 100 / composedHoldMs);
+            return;
+        }
+    }
+    c.fittedMs = predicted;
+    c.holdScalePercent = (int)(wantMs * 100 / composedHoldMs);
+}
+
+void compose(long totalMs, int maxLines, const Context& ctx, ScriptBuffer& script, Composition* plan) {
+    script.clear();
+    Expander x;
+    resetExpander(x, ctx);
+
+    int intro = findPhase("INTRODUCTION");
+    int coolDown = findPhase("COOL_DOWN");
+    long introMs = (intro >= 0) ? rnd(x, __active.phases[intro].durationLo, __active.phases[intro].durationHi) : 0;
+    long coolDownMs = (coolDown >= 0) ? rnd(x, __active.phases[coolDown].durationLo, __active.phases[coolDown].durationHi) : 0;
+
+    // If the requested duration is shorter than a full show, scale down the bookends.
+    long minFullShowMs = introMs + __MIN_BODY_MS + coolDownMs;
+    if (totalMs < minFullShowMs) {
+        float scale = (float)totalMs / (float)minFullShowMs;
+        if (scale < 0.5f) scale = 0.5f; // Don't make them too short
+        introMs = (long)(introMs * scale);
+        coolDownMs = (long)(coolDownMs * scale);
+    }
+    long bodyMs = totalMs - introMs - coolDownMs;
+    if (bodyMs < 0) bodyMs = 0;
+
+    int body[MAX_PHASES];
+    int bodyCount = 0;
+    for (int i = 0; i < __active.phaseCount; i++) {
+        if (i != intro && i != coolDown) body[bodyCount++] = i;
+    }
+
+    long accumulated = 0;
+    ShowState show = { -1, 100 }; // Motor speed unknown until the script sets it
+    script.push("led_reset"); // Clears effects without touching global brightness or motor
+    script.push("hold:1000");
+    accumulated += 1000;
+
+    if (intro >= 0 && introMs > 1000) accumulated += runPhase(intro, introMs, introMs, ctx, show, script);
+
+    // Leave room for the cool-down and system_off.
+    int reservedLines = 1 + ((coolDown >= 0) ? __active.phases[coolDown].maxLines : 0);
+    // A phase too short for a scene adds no time, so a round of nothing but those, or a
+    // full pool, ends the body rather than cycling forever.
+    int idlePhases = 0;
+    bool lineLimited = false;
+    for (int next = 0; bodyCount > 0 && totalMs - coolDownMs - accumulated > 1000; next = (next + 1) % bodyCount) {
+        if (script.size() + __active.phases[body[next]].maxLines + reservedLines > maxLines || script.dropped() > 0) {
+            lineLimited = true;
+            break;
+        }
+        if (idlePhases >= bodyCount) break;
+        long phaseMs = runPhase(body[next], -1, totalMs - coolDownMs - accumulated, ctx, show, script);
+        accumulated += phaseMs;
+        idlePhases = (phaseMs > 0) ? 0 : idlePhases + 1;
+    }
+
+    if (coolDown >= 0 && coolDownMs > 1000) accumulated += runPhase(coolDown, coolDownMs, coolDownMs, ctx, show, script);
+
+    script.push("system_off");
+
+    Composition c;
+    c.introMs = introMs;
+    c.bodyMs = bodyMs;
+    c.coolDownMs = coolDownMs;
+    c.plannedMs = accumulated;
+    c.lineLimited = lineLimited;
+    fitHolds(totalMs, ctx, script, c);
+    if (plan) *plan = c;
+}
+
+} // namespace PhaseTemplates
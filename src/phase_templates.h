@@ -0,0 +1,102 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "script_buffer.h"
+
+// A small interpreter that composes auto_mode scripts from text templates.
+//
+// The musical structure is fixed here: INTRODUCTION, then the remaining phases in
+// file order, cycled until the time is used up, then COOL_DOWN and system_off. What
+// each phase does is described in text, so a new style is a new template file rather
+// than a reflash. The built-in set lives in flash (phase_templates_builtin.cpp); a file on
+// LittleFS can replace it.
+//
+// Template format, one item per line. Text after '#' is a comment.
+//
+//   phase NAME LO-HI [SCENES_LO-SCENES_HI]
+//       Starts a phase lasting LO-HI ms, split evenly over that many scenes
+//       (default 1). A single value may be given instead of a range.
+//   <command lines>          Phase prologue, emitted once at the start of the phase.
+//   scene WEIGHT             Starts a scene; one is picked per scene slot, by weight.
+//   <command lines>          The scene. Its last hold is added automatically: whatever
+//                            is left of the scene's time after any holds in the lines.
+//   outro                    Lines after this are emitted once at the end of the phase.
+//
+// Command lines may start with "?NN " (emit with NN% probability) or "?! " (emit only
+// if the previous "?NN" line was not). Blocks, which do not nest:
+//   @over MS ... @end        Run the block only if more than MS of the scene is left.
+//   @repeat LO-HI MIN ... @end
+//                            Run the block LO-HI times, if the resulting {split} is
+//                            longer than MIN ms.
+//
+// Placeholders in command lines:
+//   {LO-HI}        random integer, inclusive ({N} is a constant)
+//   {v=EXPR}       evaluate EXPR, store it in variable v (a-z), and emit it
+//   {v}            variable v. h is preset to a random hue for every scene
+//   {v+LO-HI}      v plus (or minus, {v-LO-HI}) a random amount, wrapped to 0-255 (hues)
+//   {rev:v*LO-HI}  motor revolution time at speed v, times LO-HI percent
+//   {pal:calm}     a random calm noise palette ({pal:energetic} for energetic ones)
+//   {rest/N}       1/N of the scene time still left
+//   {split}        inside @repeat: the scene time left at the block, / (count + 1)
+//
+// Nothing here allocates or touches Arduino APIs, so it also builds on the host.
+namespace PhaseTemplates {
+
+const int MAX_PHASES = 8;
+const int MAX_SCENES = 48;
+const int MAX_LINES = 320;
+const size_t MAX_LINE_LEN = 95;
+
+// What the interpreter needs from its host.
+struct Context {
+    long (*random)(long low, long highExclusive); // Arduino random() semantics
+    long (*revTimeMs)(int speed);                 // Motor revolution time at a logical speed
+    uint32_t rampMs;                              // Motor ramp duration in force at playback
+    // Whether `effect` ("noise", "fire", ...) at `displayPercent` display brightness is
+    // expected to hit the strip's power limit. Such scenes are picked a quarter as often.
+    // May be null.
+    bool (*wouldLimit)(const char* effect, int displayPercent);
+};
+
+// The built-in set (phase_templates_builtin.cpp).
+extern const char BUILTIN_TEMPLATES[];
+
+// Parses and validates `text`, which must outlive its use. On success it becomes the
+// active template set. On failure the active set is unchanged and `errorLine` (if
+// given) is set to the 1-based line at fault.
+bool load(const char* text, int* errorLine);
+
+int phaseCount();
+const char* phaseName(int phase);
+int sceneCount(int phase);
+// -1 if there is no such phase.
+int findPhase(const char* name);
+
+// Allowed difference between the requested length and the fitted script's predicted
+// length. Only a show with no holds, or one needing holds stretched past the limits
+// below, misses it.
+const long FIT_TOLERANCE_MS = 250;
+
+// The plan compose() followed.
+struct Composition {
+    long introMs;
+    long bodyMs;
+    long coolDownMs;
+    long plannedMs;   // What the phases were budgeted at while composing
+    long predictedMs; // What the step model (ScriptTimeline::plannedMs) predicted for that
+    long fittedMs;    // The step model's prediction after the holds were fitted
+    int holdScalePercent;
+    bool lineLimited; // The line budget ended the body before its time was used up
+    bool fitFailed;   // The fitted holds did not fit the script pool; they are as composed
+};
+
+// Composes a script of `totalMs` into `script` (cleared first), using at most
+// `maxLines` lines. Scenes are budgeted with the same step costs as
+// ScriptTimeline::plannedMs (holds, ramps, reversals). Then every hold is scaled by one
+// factor, between 1/2 and 2 (4 when the line budget ended the body early), so that the
+// predicted length of the script comes within FIT_TOLERANCE_MS of `totalMs`. If the
+// scaled holds do not fit the script pool they are left as composed, and fitFailed says so.
+void compose(long totalMs, int maxLines, const Context& ctx, ScriptBuffer& script, Composition* plan);
+
+} // namespace PhaseTemplates
@@ -0,0 +1,136 @@
+#include "phase_templates.h"
+
+// The auto_mode show, as phase templates (see phase_templates.h for the format).
+// Kept apart from the interpreter so the host harness can build against it.
+namespace PhaseTemplates {
+
+const char BUILTIN_TEMPLATES[] =
+    "phase INTRODUCTION 30000\n"
+    "led_reset\n"
+    "led_display_brightness:{30-50}      # Start dim\n"
+    // Per guidance, showcase a full-strip effect with the motor off, then spin up.
+    "scene 50\n"
+    "motor_speed:0\n"
+    "led_effect:noise,{pal:calm},5,30\n"
+    "hold:7000\n"
+    "hold:{rest/2}\n"
+    "led_tails:{0-255},10,1\n"
+    "hold:{rest/2}\n"
+    "motor_speed:500\n"
+    "led_background:{0-255},15\n"
+    "scene 50\n"
+    "motor_speed:0\n"
+    "hold:2000\n"
+    "led_background:{h},5\n"
+    "hold:{rest/2}\n"
+    "led_tails:{0-255},10,1\n"
+    "hold:{rest/2}\n"
+    "motor_speed:500\n"
+    "led_background:{0-255},15\n"
+
+    // Harmonious colours; occasionally break up the vibe with a full-strip effect.
+    "phase VIBE 20000-30000\n"
+    "led_display_brightness:{60-80}\n"
+    "scene 15\n"
+    "motor_speed:{500-600}\n"
+    "led_effect:noise,{pal:calm},8,40\n"
+    "?50 led_sine_hue:{h-20},{h+20}\n"
+    "scene 60                            # Analogous\n"
+    "motor_speed:{s=500-700}\n"
+    "led_background:{h},{15-30}\n"
+    "led_tails:{t=h+20-40},{10-24},{1-2}\n"
+    "?40 led_cycle_time:{rev:s*100-200}\n"
+    "?50 led_sine_hue:{t-20},{t+20}\n"
+    "scene 25                            # Monochromatic\n"
+    "motor_speed:{s=500-700}\n"
+    "led_background:{h},{15-30}\n"
+    "led_tails:{h},{10-24},{1-2}\n"
+    "?40 led_cycle_time:{rev:s*100-200}\n"
+    "?50 led_sine_hue:{h-20},{h+20}\n"
+
+    // High-contrast colours, cycle time at or above the motor revolution time.
+    "phase TENSION 15000-25000\n"
+    "led_display_brightness:{80-95}\n"
+    "scene 20\n"
+    "motor_speed:{600-800}\n"
+    "led_effect:marquee,{h+128},{2-4},{4-9},{25-75}\n"
+    "?60 led_sine_pulse:{50-70},{90-95}\n"
+    "scene 80\n"
+    "motor_speed:{s=750-950}\n"
+    "led_background:{h},{25-40}\n"
+    "led_tails:{h+128},{5-14},{3-5}\n"
+    "?75 led_cycle_time:{rev:s*100-150}\n"
+    "?60 led_sine_pulse:{50-70},{90-95}\n"
+    "outro\n"
+    "?75 motor_reverse                   # Signal the climax\n"
+
+    "phase CLIMAX 75000-90000 2-3\n"
+    "led_display_brightness:100\n"
+    "scene 32                            # Still marquee, then fire or noise\n"
+    "motor_speed:0\n"
+    "hold:2000\n"
+    "led_effect:marquee,{h},{2-4},{4-9},{75-120}\n"
+    "@over 12000\n"
+    "hold:{rest/2}\n"
+    "?50 led_effect:fire\n"
+    "?! led_effect:noise,{pal:energetic},25,15\n"
+    "@end\n"
+    "scene 48                            # Fast marquee\n"
+    "motor_speed:{900-1000}\n"
+    "led_effect:marquee,{h},{2-4},{4-9},{25-75}\n"
+    "@repeat 1-2 4000\n"
+    "hold:{split}\n"
+    "motor_speed:{850-1000}\n"
+    "@end\n"
+    "scene 70                            # Rainbow see-saw\n"
+    "motor_speed:{900-1000}\n"
+    "led_rainbow\n"
+    "led_tails:0,{10-19},{4-6}\n"
+    "@repeat 2-4 500\n"
+    "hold:{split}\n"
+    "led_reverse\n"
+    "@end\n"
+    "scene 12                            # Fire, then noise\n"
+    "motor_speed:0\n"
+    "hold:4000\n"
+    "led_effect:fire\n"
+    "@over 12000\n"
+    "hold:{rest/2}\n"
+    "led_effect:noise,{pal:energetic},25,15\n"
+    "@end\n"
+    "scene 13                            # Noise, then fire\n"
+    "motor_speed:0\n"
+    "hold:4000\n"
+    "led_effect:noise,{pal:energetic},25,15\n"
+    "@over 12000\n"
+    "hold:{rest/2}\n"
+    "led_effect:fire\n"
+    "@end\n"
+    "scene 25                            # Blink\n"
+    "motor_speed:{950-1000}\n"
+    "led_blink:{h},100,80,150,0\n"
+    "@repeat 1-2 4000\n"
+    "hold:{split}\n"
+    "motor_speed:{900-1000}\n"
+    "@end\n"
+    "outro\n"
+    "?40 motor_reverse                   # Signal the way out\n"
+
+    // Taper off activity and bring the audience down gently.
+    "phase COOL_DOWN 60000\n"
+    "led_display_brightness:{20-40}\n"
+    "led_reset\n"
+    "scene 40\n"
+    "motor_speed:{200-300}\n"
+    "led_effect:noise,{pal:calm},4,50    # Very slow and smooth\n"
+    "scene 30\n"
+    "motor_speed:{200-300}\n"
+    "led_effect:twinkle,{h},80\n"
+    "scene 30\n"
+    "motor_speed:{400-500}\n"
+    "led_background:{h},{5-14}\n"
+    "led_tails:{0-255},{20-29},1         # One long tail\n"
+    "hold:{rest/2}\n"
+    "motor_speed:{200-300}\n";
+
+} // namespace PhaseTemplates
@@ -0,0 +1,163 @@
+#include "power_budget.h"
+#include <stdio.h>
+#include <string.h>
+
+namespace PowerBudget {
+
+// FastLED's power model (power_mgt.cpp): mW per channel at full value, at 5 V.
+static const uint32_t __RED_MW = 16 * 5;
+static const uint32_t __GREEN_MW = 11 * 5;
+static const uint32_t __BLUE_MW = 15 * 5;
+static const uint32_t __DARK_MW = 1 * 5;
+static const uint32_t __VOLTS = 5;
+
+struct Bucket {
+    uint32_t second;  // nowMs / 1000 this bucket holds
+    uint32_t frames;
+    uint32_t sumMa;
+    uint32_t sumRequestedMa;
+    uint32_t peakRequestedMa;
+    uint32_t limitedFrames;
+    uint32_t sumCutPercent;
+};
+
+struct EffectLoad {
+    const char* name;
+    uint32_t loadMa; // Moving average of full-brightness current, x16 fixed point
+};
+
+static uint32_t __budgetMw = 500 * __VOLTS;
+static int __numLeds = 0;
+static uint8_t __masterBrightness = 255;
+static uint32_t __lastFrameMa = 0;
+static Bucket __buckets[WINDOW_SECONDS];
+static EffectLoad __effects[MAX_EFFECTS];
+static int __effectCount = 0;
+
+void configure(uint32_t budgetMa, int numLeds) {
+    __budgetMw = budgetMa * __VOLTS;
+    __numLeds = numLeds;
+}
+
+uint32_t budgetMa() { return __budgetMw / __VOLTS; }
+
+void setMasterBrightness(uint8_t brightness) { __masterBrightness = brightness; }
+
+static EffectLoad* findEffect(const char* name, bool add) {
+    for (int i = 0; i < __effectCount; i++) {
+        if (__effects[i].name == name || strcmp(__effects[i].name, name) == 0) return &__effects[i];
+    }
+    if (!add || __effectCount >= MAX_EFFECTS) return nullptr;
+    EffectLoad& e = __effects[__effectCount++];
+    e.name = name;
+    e.loadMa = 0;
+    return &e;
+}
+
+static Bucket& bucketFor(uint32_t nowMs) {
+    uint32_t second = nowMs / 1000;
+    Bucket& b = __buckets[second % WINDOW_SECONDS];
+    if (b.second != second || b.frames == 0) {
+        memset(&b, 0, sizeof(b));
+        b.second = second;
+    }
+    return b;
+}
+
+uint8_t limitFrame(const uint8_t* rgb, int count, uint8_t brightness, const char* effect, uint32_t nowMs) {
+    uint32_t red = 0, green = 0, blue = 0;
+    for (int i = 0; i < count; i++) {
+        red += rgb[0];
+        green += rgb[1];
+        blue += rgb[2];
+        rgb += 3;
+    }
+    // Full-brightness power, then scaled by brightness as FastLED does.
+    uint32_t unscaledMw = (red * __RED_MW + green * __GREEN_MW + blue * __BLUE_MW) / 256 + (uint32_t)count * __DARK_MW;
+    uint32_t requestedMw = unscaledMw * brightness / 256;
+    uint8_t shown = brightness;
+    if (requestedMw > __budgetMw) {
+        shown = (uint8_t)((uint32_t)brightness * __budgetMw / requestedMw);
+    }
+
+    uint32_t requestedMa = requestedMw / __VOLTS;
+    __lastFrameMa = (unscaledMw * shown / 256) / __VOLTS;
+
+    Bucket& b = bucketFor(nowMs);
+    b.frames++;
+    b.sumMa += __lastFrameMa;
+    b.sumRequestedMa += requestedMa;
+    if (requestedMa > b.peakRequestedMa) b.peakRequestedMa = requestedMa;
+    if (shown < brightness) {
+        b.limitedFrames++;
+        b.sumCutPercent += (uint32_t)(brightness - shown) * 100 / brightness;
+    }
+
+    // Loads are learned per effect as a 1/16 moving average (x16 fixed point).
+    EffectLoad* e = findEffect(effect, true);
+    if (e) {
+        uint32_t sample = (unscaledMw / __VOLTS) * 16;
+        e->loadMa = (e->loadMa == 0) ? sample : e->loadMa - e->loadMa / 16 + sample / 16;
+    }
+    return shown;
+}
+
+void window(int seconds, uint32_t nowMs, Window* out) {
+    if (seconds > WINDOW_SECONDS) seconds = WINDOW_SECONDS;
+    uint32_t now = nowMs / 1000;
+    uint32_t sumMa = 0, sumRequested = 0, sumCut = 0;
+    Window w = {};
+    for (int i = 0; i < WINDOW_SECONDS; i++) {
+        const Bucket& b = __buckets[i];
+        if (b.frames == 0 || now - b.second >= (uint32_t)seconds) continue;
+        w.frames += b.frames;
+        sumMa += b.sumMa;
+        sumRequested += b.sumRequestedMa;
+        sumCut += b.sumCutPercent;
+        w.limitedFrames += b.limitedFrames;
+        if (b.peakRequestedMa > w.peakRequestedMa) w.peakRequestedMa = b.peakRequestedMa;
+    }
+    if (w.frames > 0) {
+        w.avgMa = sumMa / w.frames;
+        w.avgRequestedMa = sumRequested / w.frames;
+    }
+    if (w.limitedFrames > 0) w.avgCutPercent = sumCut / w.limitedFrames;
+    *out = w;
+}
+
+uint32_t lastFrameMa() { return __lastFrameMa; }
+
+uint32_t effectLoadMa(const char* effect) {
+    const EffectLoad* e = findEffect(effect, false);
+    return e ? e->loadMa / 16 : 0;
+}
+
+void setEffectLoadMa(const char* effect, uint32_t loadMa) {
+    EffectLoad* e = findEffect(effect, true);
+    if (e) e->loadMa = loadMa * 16;
+}
+
+bool wouldLimit(const char* effect, int displayPercent) {
+    uint32_t load = effectLoadMa(effect);
+    if (load == 0) return false;
+    uint32_t brightness = (uint32_t)__masterBrightness * (uint32_t)(displayPercent * 255 / 100) / 255;
+    return load * brightness / 256 > budgetMa();
+}
+
+static uint32_t percentOf(uint32_t part, uint32_t whole) {
+    return whole ? part * 100 / whole : 0;
+}
+
+int formatStatus(uint32_t nowMs, char* out, size_t len) {
+    Window shortWindow, longWindow;
+    window(SHORT_WINDOW_SECONDS, nowMs, &shortWindow);
+    window(WINDOW_SECONDS, nowMs, &longWindow);
+    return snprintf(out, len, "PWR %lu %lu %lu %lu %lu %lu %lu %lu", (unsigned long)__lastFrameMa,
+                    (unsigned long)shortWindow.avgMa, (unsigned long)longWindow.avgMa,
+                    (unsigned long)longWindow.peakRequestedMa,
+                    (unsigned long)percentOf(shortWindow.limitedFrames, shortWindow.frames),
+                    (unsigned long)percentOf(longWindow.limitedFrames, longWindow.frames),
+                    (unsigned long)longWindow.avgCutPercent, (unsigned long)budgetMa());
+}
+
+} // namespace PowerBudget
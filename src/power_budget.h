@@ -0,0 +1,66 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Strip current estimation and limiting, with telemetry.
+//
+// Replaces FastLED's setMaxPowerInVoltsAndMilliamps(), which dims over-budget frames
+// without saying so. limitFrame() is called from showStrip() for every frame. It
+// estimates the frame's current with FastLED's per-channel model (the same constants,
+// so limiting behaves as before), lowers the brightness just enough to stay within
+// the budget, and records what it did. This walk replaces the one FastLED's limiter
+// made inside show(), so a frame costs no extra pass.
+//
+// Statistics are kept in one-second buckets for the last WINDOW_SECONDS seconds, so
+// status reports rolling averages over the last 10 s and the whole window. Each effect
+// also gets a learned load: a moving average of its current at full brightness. The
+// AutoGenerator uses it to avoid scenes that would run into the limiter.
+//
+// Only the loop task may call these functions.
+namespace PowerBudget {
+
+const int WINDOW_SECONDS = 60;
+const int SHORT_WINDOW_SECONDS = 10;
+const int MAX_EFFECTS = 8;
+// Long enough for the PWR status line.
+const size_t MAX_LINE_LEN = 96;
+
+// `budgetMa` covers the strip at 5 V, including the LEDs' idle draw.
+void configure(uint32_t budgetMa, int numLeds);
+uint32_t budgetMa();
+
+// The global master brightness (0-255) in force. Used to predict scenes.
+void setMasterBrightness(uint8_t brightness);
+
+// Estimates the current of `rgb` (count pixels, 3 bytes each, before brightness) shown
+// at `brightness`, and returns the brightness to show it at instead: `brightness`, or
+// lower if that would exceed the budget. `effect` names the effect that drew the frame
+// and must be a string literal.
+uint8_t limitFrame(const uint8_t* rgb, int count, uint8_t brightness, const char* effect, uint32_t nowMs);
+
+struct Window {
+    uint32_t frames;
+    uint32_t avgMa;           // Delivered (after limiting), per frame
+    uint32_t avgRequestedMa;  // What the frames asked for
+    uint32_t peakRequestedMa;
+    uint32_t limitedFrames;
+    uint32_t avgCutPercent;   // Average brightness cut over the limited frames
+};
+
+// Totals over the last `seconds` (up to WINDOW_SECONDS) complete or current seconds.
+void window(int seconds, uint32_t nowMs, Window* out);
+uint32_t lastFrameMa();
+
+// Learned current of `effect` at full brightness, or 0 if it has not been seen.
+uint32_t effectLoadMa(const char* effect);
+// Seeds the learned load of `effect` (a string literal), e.g. from a saved show.
+void setEffectLoadMa(const char* effect, uint32_t loadMa);
+// Whether `effect` shown at `displayPercent` display brightness (scaled by the master
+// brightness) is expected to exceed the budget. False for effects not seen yet.
+bool wouldLimit(const char* effect, int displayPercent);
+
+// "PWR <last_mA> <avg10_mA> <avg60_mA> <peak60_mA> <limited10_%> <limited60_%> <cut60_%> <budget_mA>"
+int formatStatus(uint32_t nowMs, char* out, size_t len);
+
+} // namespace PowerBudget
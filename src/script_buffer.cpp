@@ -0,0 +1,75 @@
+#include "script_buffer.h"
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+// Offsets are 16-bit.
+static_assert(SCRIPT_POOL_BYTES <= 65536, "Script pool too large for uint16_t offsets");
+
+ScriptBuffer::ScriptBuffer() {
+    clear();
+}
+
+void ScriptBuffer::clear() {
+    _count = 0;
+    _used = 0;
+    _dropped = 0;
+}
+
+bool ScriptBuffer::push(const char* line) {
+    size_t len = strlen(line) + 1;
+    if (_count >= SCRIPT_MAX_LINES || len > bytesFree()) {
+        _dropped++;
+        return false;
+    }
+    memcpy(_pool + _used, line, len);
+    _offsets[_count++] = (uint16_t)_used;
+    _used += len;
+    return true;
+}
+
+bool ScriptBuffer::pushf(const char* format, ...) {
+    if (_count >= SCRIPT_MAX_LINES || bytesFree() == 0) {
+        _dropped++;
+        return false;
+    }
+    va_list args;
+    va_start(args, format);
+    int len = vsnprintf(_pool + _used, bytesFree(), format, args);
+    va_end(args);
+    // A truncated line is worse than a missing one; discard it.
+    if (len < 0 || (size_t)len + 1 > bytesFree()) {
+        _dropped++;
+        return false;
+    }
+    _offsets[_count++] = (uint16_t)_used;
+    _used += (size_t)len + 1;
+    return true;
+}
+
+bool ScriptBuffer::replace(int index, const char* line) {
+    if (index < 0 || index >= _count) return false;
+    char* slot = _pool + _offsets[index];
+    size_t len = strlen(line) + 1;
+    if (len <= strlen(slot) + 1) {
+        memcpy(slot, line, len);
+        return true;
+    }
+    // Longer: the old text stays in the pool unused until the next clear().
+    if (len > bytesFree()) return false;
+    memcpy(_pool + _used, line, len);
+    _offsets[index] = (uint16_t)_used;
+    _used += len;
+    return true;
+}
+
+uint32_t ScriptBuffer::fingerprint() const {
+    uint32_t hash = 2166136261u;
+    for (int i = 0; i < _count; i++) {
+        const char* p = _pool + _offsets[i];
+        do {
+            hash = (hash ^ (uint8_t)*p) * 16777619u;
+        } while (*p++ != '\0');
+    }
+    return hash;
+}
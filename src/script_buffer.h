@@ -0,0 +1,55 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Fixed-capacity storage for a script of command lines.
+//
+// Lines are packed NUL-terminated into one statically sized character pool and
+// indexed by offset, so a script of any length up to the limits below costs no heap
+// at all. Generating or loading a script just rewrites the pool in place.
+//
+// Pushing into a full buffer fails (returns false) and is counted, so a generator can
+// stop early rather than silently losing the end of a show.
+
+// Upper bound on lines in one script. Matches the generators' old hard cap.
+const int SCRIPT_MAX_LINES = 2000;
+// Bytes for the text of all lines, including terminators. Generated lines average
+// well under 20 characters.
+const size_t SCRIPT_POOL_BYTES = 40 * 1024;
+
+class ScriptBuffer {
+public:
+    ScriptBuffer();
+
+    void clear();
+
+    // Appends a copy of `line`. Returns false (and counts a drop) if it does not fit.
+    bool push(const char* line);
+    // Appends a printf-formatted line, formatted directly into the pool.
+    bool pushf(const char* format, ...) __attribute__((format(printf, 2, 3)));
+
+    // Replaces line `index`, in place if the new text is no longer. Returns false if
+    // it does not fit (the line is left as it was).
+    bool replace(int index, const char* line);
+
+    int size() const { return _count; }
+    bool empty() const { return _count == 0; }
+    const char* operator[](int index) const { return _pool + _offsets[index]; }
+
+    size_t bytesUsed() const { return _used; }
+    int linesFree() const { return SCRIPT_MAX_LINES - _count; }
+    size_t bytesFree() const { return SCRIPT_POOL_BYTES - _used; }
+    // Lines rejected since the last clear().
+    int dropped() const { return _dropped; }
+
+    // FNV-1a hash of the lines, to tell whether a regenerated script matches an earlier one.
+    uint32_t fingerprint() const;
+
+private:
+    char _pool[SCRIPT_POOL_BYTES];
+    uint16_t _offsets[SCRIPT_MAX_LINES];
+    int _count;
+    size_t _used;
+    int _dropped;
+};
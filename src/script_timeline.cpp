@@ -0,0 +1,368 @@
+#include "script_timeline.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+
+namespace ScriptTimeline {
+
+// Pieces of show state a script command can set. A command "writes" every slot whose
+// value it fully determines; the last writer of each slot is what a seek replays.
+enum Slot {
+    SLOT_MOTOR_SPEED,
+    SLOT_MOTOR_RUN,
+    SLOT_MOTOR_RAMP,
+    SLOT_CYCLE_TIME,
+    SLOT_GLOBAL_BRIGHTNESS,
+    SLOT_DISPLAY_BRIGHTNESS,
+    SLOT_BACKGROUND,
+    SLOT_EFFECT,
+    SLOT_COMET,
+    SLOT_HUE_MOD,
+    SLOT_PULSE,
+    SLOT_LED_DIRECTION,
+    SLOT_COUNT
+};
+
+static_assert(SLOT_COUNT <= MAX_RESTORE_STEPS, "RestorePlan cannot hold one step per slot");
+
+#define SLOT_BIT(s) (1u << (s))
+
+enum Toggle {
+    TOGGLE_NONE = -1,
+    TOGGLE_LED_REVERSE,
+    TOGGLE_MOTOR_REVERSE,
+    TOGGLE_COUNT
+};
+
+// The slot that resets each toggle to its default (led_reset sets the LED direction
+// forward), or -1 if nothing does.
+static const int __toggleResetSlot[TOGGLE_COUNT] = { SLOT_LED_DIRECTION, -1 };
+
+struct IndexedCommand {
+    const char* name;
+    uint16_t writes;
+    Toggle toggle;
+};
+
+static const uint16_t __resetWrites = SLOT_BIT(SLOT_HUE_MOD) | SLOT_BIT(SLOT_PULSE) | SLOT_BIT(SLOT_EFFECT) |
+                                      SLOT_BIT(SLOT_COMET) | SLOT_BIT(SLOT_LED_DIRECTION) | SLOT_BIT(SLOT_CYCLE_TIME);
+static const uint16_t __systemResetWrites = (uint16_t)((SLOT_BIT(SLOT_COUNT) - 1) & ~SLOT_BIT(SLOT_GLOBAL_BRIGHTNESS));
+
+// What puts each slot back to how it is before any script step has written it, on a
+// backward seek: the system_reset values, the ramp in force when the script was loaded
+// and led_reset for the LED state it covers. nullptr where nothing does (the global
+// brightness persists; a motor_start leaves the speed it starts at unknown).
+static char __rampDefault[24] = "motor_ramp:0";
+static const char* const __slotDefaults[SLOT_COUNT] = {
+    nullptr,                      // SLOT_MOTOR_SPEED
+    "motor_stop",                 // SLOT_MOTOR_RUN
+    __rampDefault,                // SLOT_MOTOR_RAMP
+    "led_reset",                  // SLOT_CYCLE_TIME
+    nullptr,                      // SLOT_GLOBAL_BRIGHTNESS
+    "led_display_brightness:100", // SLOT_DISPLAY_BRIGHTNESS
+    "led_background:160,30",      // SLOT_BACKGROUND
+    "led_reset",                  // SLOT_EFFECT
+    "led_reset",                  // SLOT_COMET
+    "led_reset",                  // SLOT_HUE_MOD
+    "led_reset",                  // SLOT_PULSE
+    "led_reset",                  // SLOT_LED_DIRECTION
+};
+
+static const IndexedCommand __indexedCommands[] = {
+    { "motor_speed", SLOT_BIT(SLOT_MOTOR_SPEED) | SLOT_BIT(SLOT_MOTOR_RUN), TOGGLE_NONE },
+    { "motor_start", SLOT_BIT(SLOT_MOTOR_RUN), TOGGLE_NONE },
+    { "motor_stop", SLOT_BIT(SLOT_MOTOR_RUN), TOGGLE_NONE },
+    { "system_off", SLOT_BIT(SLOT_MOTOR_RUN), TOGGLE_NONE },
+    { "motor_ramp", SLOT_BIT(SLOT_MOTOR_RAMP), TOGGLE_NONE },
+    { "led_cycle_time", SLOT_BIT(SLOT_CYCLE_TIME), TOGGLE_NONE },
+    { "led_global_brightness", SLOT_BIT(SLOT_GLOBAL_BRIGHTNESS), TOGGLE_NONE },
+    { "led_display_brightness", SLOT_BIT(SLOT_DISPLAY_BRIGHTNESS), TOGGLE_NONE },
+    { "led_background", SLOT_BIT(SLOT_BACKGROUND), TOGGLE_NONE },
+    { "led_effect", SLOT_BIT(SLOT_EFFECT), TOGGLE_NONE },
+    { "led_tails", SLOT_BIT(SLOT_EFFECT) | SLOT_BIT(SLOT_COMET), TOGGLE_NONE },
+    { "led_blink", SLOT_BIT(SLOT_EFFECT), TOGGLE_NONE },
+    { "led_sine_hue", SLOT_BIT(SLOT_HUE_MOD), TOGGLE_NONE },
+    { "led_rainbow", SLOT_BIT(SLOT_HUE_MOD), TOGGLE_NONE },
+    { "led_sine_pulse", SLOT_BIT(SLOT_PULSE), TOGGLE_NONE },
+    { "led_reset", __resetWrites, TOGGLE_NONE },
+    { "system_reset", __systemResetWrites, TOGGLE_NONE },
+    { "led_reverse", 0, TOGGLE_LED_REVERSE },
+    { "motor_reverse", 0, TOGGLE_MOTOR_REVERSE },
+};
+
+// State after a prefix of the script.
+struct Cursor {
+    int16_t lastWriter[SLOT_COUNT]; // -1 if no step has written the slot yet
+    uint8_t parity;                 // Bit per toggle: odd count since its reset slot was written
+    uint8_t rawParity;              // Bit per toggle: odd count since the start
+};
+
+static const int __MAX_SNAPSHOTS = (SCRIPT_MAX_LINES + SNAPSHOT_INTERVAL - 1) / SNAPSHOT_INTERVAL;
+
+static uint32_t __stepStartMs[SCRIPT_MAX_LINES];
+static int __stepCount = 0;
+static uint32_t __totalMs = 0;
+static uint16_t __markers[MAX_MARKERS];
+static int __markerCount = 0;
+static Cursor __snapshots[__MAX_SNAPSHOTS]; // __snapshots[i] = state after steps [0, i * SNAPSHOT_INTERVAL)
+static int __snapshotCount = 0;
+
+static bool nameIs(const char* line, const char* name) {
+    size_t len = strlen(name);
+    return strncmp(line, name, len) == 0 && (line[len] == '\0' || line[len] == ':');
+}
+
+static const IndexedCommand* lookup(const char* line) {
+    for (size_t i = 0; i < sizeof(__indexedCommands) / sizeof(__indexedCommands[0]); i++) {
+        if (nameIs(line, __indexedCommands[i].name)) return &__indexedCommands[i];
+    }
+    return nullptr;
+}
+
+static void resetCursor(Cursor& c) {
+    for (int s = 0; s < SLOT_COUNT; s++) c.lastWriter[s] = -1;
+    c.parity = 0;
+    c.rawParity = 0;
+}
+
+static void advance(Cursor& c, const char* line, int step) {
+    const IndexedCommand* cmd = lookup(line);
+    if (cmd == nullptr) return;
+    for (int s = 0; s < SLOT_COUNT; s++) {
+        if (!(cmd->writes & SLOT_BIT(s))) continue;
+        c.lastWriter[s] = (int16_t)step;
+        for (int t = 0; t < TOGGLE_COUNT; t++) {
+            if (__toggleResetSlot[t] == s) c.parity &= ~(1u << t);
+        }
+    }
+    if (cmd->toggle != TOGGLE_NONE) {
+        c.parity ^= (1u << cmd->toggle);
+        c.rawParity ^= (1u << cmd->toggle);
+    }
+}
+
+// State after steps [0, step): nearest snapshot below, then at most
+// SNAPSHOT_INTERVAL - 1 lines.
+static void cursorAt(const ScriptBuffer& script, int step, Cursor& c) {
+    int snap = step / SNAPSHOT_INTERVAL;
+    if (snap >= __snapshotCount) snap = __snapshotCount - 1;
+    if (snap < 0) {
+        resetCursor(c);
+        return;
+    }
+    c = __snapshots[snap];
+    for (int i = snap * SNAPSHOT_INTERVAL; i < step && i < script.size(); i++) {
+        advance(c, script[i], i);
+    }
+}
+
+// Planned-time model of the waits the engine makes between steps.
+struct PlanClock {
+    uint32_t now;          // When the current step runs
+    uint32_t motorIdleAt;  // When the last ramp is expected to finish
+    uint32_t blinkDoneAt;  // When the last finite blink ends (0 if none is running)
+    uint32_t rampMs;
+    int speed;             // Last speed set, or -1 if not known
+};
+
+// How long a led_blink line runs for, or 0 if it repeats forever.
+static uint32_t blinkLengthMs(const char* line) {
+    int p[5] = { 0, 0, 0, 0, 0 };
+    const char* field = line + 10;
+    for (int f = 0; f < 5 && field; f++) {
+        p[f] = atoi(field);
+        field = strchr(field, ',');
+        if (field) field++;
+    }
+    uint32_t cycle = (uint32_t)std::max(1, p[2]) + (uint32_t)std::max(1, p[3]);
+    return (p[4] > 0) ? cycle * (uint32_t)p[4] : 0;
+}
+
+static void planStep(PlanClock& k, const char* line) {
+    if (strncmp(line, "hold:", 5) == 0) {
+        int hold = atoi(line + 5);
+        if (hold > 0) k.now += (uint32_t)hold;
+    } else if (strncmp(line, "motor_ramp:", 11) == 0) {
+        k.rampMs = (uint32_t)std::max(0, atoi(line + 11));
+    } else if (strncmp(line, "motor_speed:", 12) == 0) {
+        int speed = atoi(line + 12);
+        if (speed != k.speed) k.motorIdleAt = k.now + k.rampMs;
+        k.speed = speed;
+    } else if (nameIs(line, "motor_stop") || nameIs(line, "system_off")) {
+        if (k.speed != 0) k.motorIdleAt = k.now + k.rampMs;
+        k.speed = 0;
+    } else if (nameIs(line, "motor_start")) {
+        k.motorIdleAt = k.now + k.rampMs;
+        k.speed = -1;
+    } else if (nameIs(line, "motor_reverse")) {
+        k.motorIdleAt = k.now + 2 * k.rampMs; // Down to the intermediate speed, then back up
+    } else if (strncmp(line, "led_blink:", 10) == 0) {
+        uint32_t length = blinkLengthMs(line);
+        k.blinkDoneAt = (length > 0) ? k.now + length : 0;
+    } else if (nameIs(line, "led_effect") || nameIs(line, "led_tails") || nameIs(line, "led_reset")) {
+        k.blinkDoneAt = 0; // The blink was replaced; nothing to wait for
+    }
+}
+
+// The engine only moves on once the motor is idle and any finite blink has ended.
+static uint32_t nextStepTime(const PlanClock& k) {
+    uint32_t t = k.now;
+    if (k.motorIdleAt > t) t = k.motorIdleAt;
+    if (k.blinkDoneAt > t) t = k.blinkDoneAt;
+    return t;
+}
+
+void build(const ScriptBuffer& script, uint32_t rampDurationMs) {
+    Cursor c;
+    resetCursor(c);
+    PlanClock k = { 0, 0, 0, rampDurationMs, -1 };
+    snprintf(__rampDefault, sizeof(__rampDefault), "motor_ramp:%lu", (unsigned long)rampDurationMs);
+    __stepCount = script.size();
+    __markerCount = 0;
+    __snapshotCount = 0;
+    for (int i = 0; i < __stepCount; i++) {
+        if (i % SNAPSHOT_INTERVAL == 0) __snapshots[__snapshotCount++] = c;
+        const char* line = script[i];
+        k.now = nextStepTime(k);
+        __stepStartMs[i] = k.now;
+        if (line[0] == '[' && __markerCount < MAX_MARKERS) {
+            __markers[__markerCount++] = (uint16_t)i;
+        }
+        planStep(k, line);
+        advance(c, line, i);
+    }
+    __totalMs = nextStepTime(k);
+}
+
+uint32_t plannedMs(const ScriptBuffer& script, uint32_t rampDurationMs, uint32_t* holdMs) {
+    HoldScaler unscaled(1, 1);
+    return plannedMs(script, rampDurationMs, unscaled, holdMs);
+}
+
+uint32_t plannedMs(const ScriptBuffer& script, uint32_t rampDurationMs, HoldScaler& scaler, uint32_t* holdMs) {
+    PlanClock k = { 0, 0, 0, rampDurationMs, -1 };
+    uint32_t holds = 0;
+    for (int i = 0; i < script.size(); i++) {
+        const char* line = script[i];
+        k.now = nextStepTime(k);
+        if (strncmp(line, "hold:", 5) == 0) {
+            long hold = scaler.next(atol(line + 5));
+            if (hold > 0) {
+                holds += (uint32_t)hold;
+                k.now += (uint32_t)hold;
+            }
+        } else {
+            planStep(k, line);
+        }
+    }
+    if (holdMs) *holdMs = holds;
+    return nextStepTime(k);
+}
+
+uint32_t totalMs() { return __totalMs; }
+
+uint32_t stepStartMs(int step) {
+    if (step < 0) return 0;
+    if (step >= __stepCount) return __totalMs;
+    return __stepStartMs[step];
+}
+
+int stepForTime(uint32_t ms, uint32_t* holdRemainingMs) {
+    *holdRemainingMs = 0;
+    if (ms >= __totalMs) return __stepCount;
+    // Last step starting at or before `ms`: it has run, and the engine is waiting
+    // (on its hold, or a ramp) for the next one.
+    int lo = 0, hi = __stepCount; // First step starting after `ms` is in [lo, hi]
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+        if (__stepStartMs[mid] <= ms) lo = mid + 1;
+        else hi = mid;
+    }
+    int next = lo;
+    *holdRemainingMs = stepStartMs(next) - ms;
+    return next;
+}
+
+int markerCount() { return __markerCount; }
+
+int markerStep(int index) {
+    if (index < 0 || index >= __markerCount) return -1;
+    return __markers[index];
+}
+
+int markerAtOrBefore(int step) {
+    int lo = 0, hi = __markerCount;
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+        if (__markers[mid] <= step) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo - 1;
+}
+
+void planRestore(const ScriptBuffer& script, int fromStep, int toStep, uint32_t holdRemainingMs, RestorePlan* plan) {
+    Cursor target, current;
+    cursorAt(script, toStep, target);
+    cursorAt(script, fromStep, current);
+
+    // A finite blink that has run its count by the target time has already reverted
+    // to comets; replaying it would start it over.
+    plan->blinkEnded = false;
+    int16_t effectStep = target.lastWriter[SLOT_EFFECT];
+    if (effectStep >= 0 && strncmp(script[effectStep], "led_blink:", 10) == 0) {
+        uint32_t length = blinkLengthMs(script[effectStep]);
+        uint32_t atMs = stepStartMs(toStep) - std::min(holdRemainingMs, stepStartMs(toStep));
+        if (length > 0 && stepStartMs(effectStep) + length <= atMs) {
+            target.lastWriter[SLOT_EFFECT] = -1;
+            plan->blinkEnded = true;
+        }
+    }
+
+    // Slots written since the target but not before it (a backward seek) go back to
+    // their defaults, before anything is replayed on top.
+    plan->defaultCount = 0;
+    uint16_t defaulted = 0;
+    for (int s = 0; s < SLOT_COUNT; s++) {
+        const char* reset = __slotDefaults[s];
+        if (target.lastWriter[s] >= 0 || current.lastWriter[s] < 0 || reset == nullptr) continue;
+        if (s == SLOT_EFFECT && plan->blinkEnded) continue;
+        bool listed = false;
+        for (int i = 0; i < plan->defaultCount; i++) listed |= (plan->defaults[i] == reset);
+        if (!listed) plan->defaults[plan->defaultCount++] = reset;
+    }
+    for (int i = 0; i < plan->defaultCount; i++) {
+        const IndexedCommand* cmd = lookup(plan->defaults[i]);
+        if (cmd) defaulted |= cmd->writes;
+    }
+
+    plan->count = 0;
+    for (int s = 0; s < SLOT_COUNT; s++) {
+        int16_t step = target.lastWriter[s];
+        if (step < 0) continue;
+        // Insert in ascending order, skipping a step that writes several slots.
+        int pos = 0;
+        while (pos < plan->count && plan->steps[pos] < step) pos++;
+        if (pos < plan->count && plan->steps[pos] == step) continue;
+        memmove(&plan->steps[pos + 1], &plan->steps[pos], (plan->count - pos) * sizeof(plan->steps[0]));
+        plan->steps[pos] = step;
+        plan->count++;
+    }
+
+    bool toggles[TOGGLE_COUNT];
+    for (int t = 0; t < TOGGLE_COUNT; t++) {
+        int resetSlot = __toggleResetSlot[t];
+        if (resetSlot >= 0 && (target.lastWriter[resetSlot] >= 0 || (defaulted & SLOT_BIT(resetSlot)))) {
+            // The replayed or default reset puts it back to the default; then count from there.
+            toggles[t] = (target.parity >> t) & 1;
+        } else {
+            // Nothing resets it before the target, so flip it if the number of toggles
+            // differs in parity from where the show is now.
+            toggles[t] = ((target.rawParity ^ current.rawParity) >> t) & 1;
+        }
+    }
+    plan->toggleLedReverse = toggles[TOGGLE_LED_REVERSE];
+    plan->toggleMotorReverse = toggles[TOGGLE_MOTOR_REVERSE];
+}
+
+} // namespace ScriptTimeline
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "script_buffer.h"
+
+// A precomputed index over the loaded script, used for pause/seek/skip-phase.
+//
+// build() walks the script once when it is loaded and records:
+//   - the planned time of every step, so a time is found with a binary search;
+//   - the phase markers, i.e. the "[...]" comment lines the generators emit at each
+//     phase, for next/previous-phase;
+//   - every SNAPSHOT_INTERVAL steps, the last step that wrote each piece of show state
+//     (motor speed, effect, background, brightness, ...).
+//
+// To jump to a step, planRestore() starts from the snapshot below it, scans at most
+// SNAPSHOT_INTERVAL - 1 lines, and returns the handful of steps (one per piece of
+// state, in script order) that re-create the look and motion the show would have at
+// that point. Replaying those is equivalent to playing the script from the start,
+// apart from relative commands (motor_speed_up, led_cycle_down, ...), which are not
+// indexed. Toggles (led_reverse, motor_reverse) are resolved by counting them. Going
+// back, state that no step before the target wrote is first put back to its default,
+// and a finite blink that would have ended by then is not started again.
+//
+// Planned time follows the engine's rules: a step runs once the previous hold is over,
+// the motor has finished ramping and any finite blink has ended. Holds are exact; a
+// speed change or stop is estimated at one ramp duration (motor_ramp, or the duration
+// in force when the script was loaded) and a reverse at two; a blink at count x
+// (up + down). Nothing here allocates.
+namespace ScriptTimeline {
+
+const int SNAPSHOT_INTERVAL = 64;
+const int MAX_MARKERS = 96;
+// Upper bound on RestorePlan::count (one step per piece of tracked state), and on
+// RestorePlan::defaultCount.
+const int MAX_RESTORE_STEPS = 12;
+
+// `rampDurationMs` is the motor ramp duration in force when the script starts.
+void build(const ScriptBuffer& script, uint32_t rampDurationMs);
+
+// Planned length of the whole script.
+uint32_t totalMs();
+
+// Planned length of any script under the same rules, without touching the index
+// above. `holdMs` (if given) receives the part of it spent in holds.
+uint32_t plannedMs(const ScriptBuffer& script, uint32_t rampDurationMs, uint32_t* holdMs);
+
+// Scales a script's holds, in order, by num / den. The rounding is carried from hold to
+// hold, so the scaled holds add up to the scaled total exactly. Holds of 0 or less are
+// returned as they are.
+struct HoldScaler {
+    int64_t num;
+    int64_t den;
+    int64_t before; // Holds so far, unscaled
+    int64_t after;  // Holds so far, scaled
+
+    HoldScaler(int64_t scaleNum, int64_t scaleDen) : num(scaleNum), den(scaleDen), before(0), after(0) {}
+    long next(long hold) {
+        if (hold <= 0 || den <= 0) return hold;
+        before += hold;
+        int64_t cumulative = before * num / den;
+        long scaled = (long)(cumulative - after);
+        after = cumulative;
+        return scaled;
+    }
+};
+
+// As plannedMs(), as if every hold were scaled by `scaler`, without rewriting them.
+uint32_t plannedMs(const ScriptBuffer& script, uint32_t rampDurationMs, HoldScaler& scaler, uint32_t* holdMs);
+// Planned time at which `step` executes.
+uint32_t stepStartMs(int step);
+
+// The step to continue from so that playback is at planned time `ms`, and in
+// `holdRemainingMs` how long to wait before running it (the rest of the hold or ramp
+// that `ms` falls in).
+int stepForTime(uint32_t ms, uint32_t* holdRemainingMs);
+
+int markerCount();
+int markerStep(int index);
+// Index of the last marker at or before `step`, or -1.
+int markerAtOrBefore(int step);
+
+// Applied in field order: the defaults, the steps, the end of the blink, the toggles.
+struct RestorePlan {
+    const char* defaults[MAX_RESTORE_STEPS]; // Commands that reset state no step before the target wrote
+    int defaultCount;
+    int16_t steps[MAX_RESTORE_STEPS]; // Ascending
+    int count;
+    bool blinkEnded; // The last effect was a finite blink that has finished: revert to comets
+    bool toggleLedReverse;
+    bool toggleMotorReverse;
+};
+
+// Builds the plan that takes the show from its state after steps [0, fromStep) to
+// the state after steps [0, toStep), with `holdRemainingMs` (as from stepForTime())
+// still to wait before toStep runs.
+void planRestore(const ScriptBuffer& script, int fromStep, int toStep, uint32_t holdRemainingMs, RestorePlan* plan);
+
+} // namespace ScriptTimeline
@@ -0,0 +1,5 @@
+#include "sculpture_config.h"
+
+// Out-of-class definitions for the constexpr tables (required before C++17 when the
+// table is odr-used, e.g. indexed through a pointer).
+constexpr SpeedSyncPair SpiralSculptureConfig::SPEED_SYNC_TABLE[];
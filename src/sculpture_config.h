@@ -0,0 +1,108 @@
+#pragma once
+
+#include <stdint.h>
+
+// Compile-time hardware description of each sculpture variant.
+//
+// Every variant is a struct of constexpr members. The motor mapping, the renderer and
+// the AutoGenerator are templated on the variant, so strip lengths, PWM limits and the
+// speed sync table are compile-time constants the compiler can unroll and vectorise.
+//
+// The variant is selected per PlatformIO env with -DSCULPTURE_CONFIG=<struct name>.
+// To add a variant: add a struct below, define its SPEED_SYNC_TABLE in
+// sculpture_config.cpp, and add an env to platformio.ini that selects it.
+
+// Struct for the speed-to-revolution-time lookup table.
+struct SpeedSyncPair {
+    int logicalSpeed;
+    int revTimeMs;
+};
+
+// The original spiral: 198 LEDs on an inner and outer helix, driven by an
+// Atomic H-Driver on the AtomS3.
+struct SpiralSculptureConfig {
+    // Atomic H-Driver Pin Definitions
+    static constexpr int MOTOR_IN1_PIN = 6;
+    static constexpr int MOTOR_IN2_PIN = 7;
+
+    // PWM Settings
+    static constexpr int PWM_FREQ = 25000;
+    static constexpr int PWM_RESOLUTION = 10; // 0-1023
+    static constexpr int PHYSICAL_MAX_SPEED = 900; // The PWM duty cycle for maximum speed
+    static constexpr int PHYSICAL_MIN_SPEED = 500; // The PWM duty cycle to overcome friction and start moving
+
+    // LED Strip Settings
+    static constexpr int ONBOARD_LED_PIN = 35;
+    static constexpr int LED_STRIP_PIN = 2;  // Grove Port Pin (Yellow wire) on AtomS3. (G1 is Pin 1).
+    static constexpr int NUM_LEDS = 198;     // Number of LEDs on the strip.
+    static constexpr int VIRTUAL_GAP = 25;   // Non-existent pixels to match mechanical rotation
+    static constexpr int LOGICAL_NUM_LEDS = NUM_LEDS + VIRTUAL_GAP;
+    static constexpr uint8_t INITIAL_GLOBAL_BRIGHTNESS = 76; // 30% initially. 100% is really quite bright in a darkened room.
+
+    // Measured revolution time at a few logical speeds.
+    static constexpr int SPEED_SYNC_TABLE_SIZE = 3;
+    static constexpr SpeedSyncPair SPEED_SYNC_TABLE[SPEED_SYNC_TABLE_SIZE] = {
+        { 400, 5200 },
+        { 700, 2096 },
+        { 1000, 1250 }
+    };
+};
+
+#ifndef SCULPTURE_CONFIG
+#define SCULPTURE_CONFIG SpiralSculptureConfig
+#endif
+
+// The variant this firmware is built for.
+typedef SCULPTURE_CONFIG Sculpture;
+
+// Linear scale for motor speed control, shared by every variant.
+const int LOGICAL_MAX_SPEED = 1000;
+
+/**
+ * @brief Maps a linear logical speed (0-1000) to the non-linear physical PWM duty cycle.
+ * This accounts for the motor's dead zone.
+ */
+template <typename Config>
+inline int mapSpeedToDuty(int logicalSpeed) {
+    if (logicalSpeed <= 0) return 0;
+    // Map the logical speed (1-1000) to the physical PWM duty range (MIN to MAX)
+    return Config::PHYSICAL_MIN_SPEED +
+           (long)(logicalSpeed - 1) * (Config::PHYSICAL_MAX_SPEED - Config::PHYSICAL_MIN_SPEED) / (LOGICAL_MAX_SPEED - 1);
+}
+
+/**
+ * @brief Calculates the estimated revolution time in ms for a given logical speed
+ * from the variant's speed sync table.
+ */
+template <typename Config>
+inline long calculateRevTimeMs(int speed) {
+    static_assert(Config::SPEED_SYNC_TABLE_SIZE >= 2, "Speed sync table needs at least two points");
+    const SpeedSyncPair* table = Config::SPEED_SYNC_TABLE;
+    const int size = Config::SPEED_SYNC_TABLE_SIZE;
+
+    float targetRevTime = 0;
+
+    if (speed <= table[0].logicalSpeed) {
+        // Linear extrapolation using the first segment
+        float m = (float)(table[1].revTimeMs - table[0].revTimeMs) /
+                  (float)(table[1].logicalSpeed - table[0].logicalSpeed);
+        targetRevTime = table[0].revTimeMs + m * (speed - table[0].logicalSpeed);
+    } else if (speed >= table[size - 1].logicalSpeed) {
+        // Linear extrapolation using the last segment
+        const int last = size - 1;
+        float m = (float)(table[last].revTimeMs - table[last-1].revTimeMs) /
+                  (float)(table[last].logicalSpeed - table[last-1].logicalSpeed);
+        targetRevTime = table[last].revTimeMs + m * (speed - table[last].logicalSpeed);
+    } else {
+        // Piecewise linear interpolation
+        for (int i = 0; i < size - 1; i++) {
+            if (speed >= table[i].logicalSpeed && speed <= table[i+1].logicalSpeed) {
+                float fraction = (float)(speed - table[i].logicalSpeed) /
+                                 (float)(table[i+1].logicalSpeed - table[i].logicalSpeed);
+                targetRevTime = table[i].revTimeMs + fraction * (table[i+1].revTimeMs - table[i].revTimeMs);
+                break;
+            }
+        }
+    }
+    return (long)(targetRevTime > 500.0f ? targetRevTime : 500.0f); // Ensure a minimum reasonable time
+}
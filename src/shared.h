@@ -1,27 +1,13 @@
 #pragma once
 
 #include <Arduino.h>
+#include "sculpture_config.h"
 
 // This header file contains constants, structs, and function declarations
 // shared between main.cpp and auto_generator.cpp to reduce code duplication.
+// Hardware-specific values live in the sculpture variant (sculpture_config.h).
 
 // --- Shared Constants ---
 
 // Default duration for a full motor speed ramp (0 to 1000).
 const int DEFAULT_RAMP_DURATION_MS = 4000;
-
-// --- Shared Data Structures ---
-
-// Struct for the speed-to-revolution-time lookup table.
-struct SpeedSyncPair {
-    int logicalSpeed;
-    int revTimeMs;
-};
-
-extern const SpeedSyncPair g_speedSyncTable[];
-extern const int g_speedSyncTableSize;
-
-// --- Shared Function Declarations ---
-
-// Calculates the estimated revolution time in ms for a given logical speed.
-long calculate_rev_time_ms(int speed);
\ No newline at end of file
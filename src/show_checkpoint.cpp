@@ -0,0 +1,38 @@
+#include "show_checkpoint.h"
+#include <Preferences.h>
+
+namespace ShowCheckpoint {
+
+static const char* const __NAMESPACE = "resume";
+static const char* const __KEY = "show";
+
+static Preferences __prefs;
+static bool __open = false;
+static uint32_t __writes = 0;
+
+bool begin() {
+    __open = __prefs.begin(__NAMESPACE, false);
+    return __open;
+}
+
+bool load(Record* out) {
+    if (!__open || __prefs.getBytesLength(__KEY) != sizeof(Record)) return false;
+    if (__prefs.getBytes(__KEY, out, sizeof(Record)) != sizeof(Record)) return false;
+    return out->version == RECORD_VERSION;
+}
+
+bool save(Record& record) {
+    if (!__open) return false;
+    record.version = RECORD_VERSION;
+    if (__prefs.putBytes(__KEY, &record, sizeof(Record)) != sizeof(Record)) return false;
+    __writes++;
+    return true;
+}
+
+void clear() {
+    if (__open && __prefs.isKey(__KEY)) __prefs.remove(__KEY);
+}
+
+uint32_t writes() { return __writes; }
+
+} // namespace ShowCheckpoint
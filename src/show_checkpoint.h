@@ -0,0 +1,55 @@
+#pragma once
+
+#include <stdint.h>
+
+// A resume record for the running auto-mode show, kept in NVS so a show survives a
+// brown-out or reset.
+//
+// The script itself (up to 40 KB) is not stored. Generation is deterministic given
+// the seed and the conditions it ran under (ramp duration, master brightness and the
+// power budget's learned effect loads, which steer scene choice), so the record keeps
+// those and the script is regenerated at boot, which takes about a millisecond.
+// The regenerated script's fingerprint must match the recorded one, so a changed
+// /phases.txt or firmware falls back to a fresh show rather than a wrong position.
+//
+// NVS is a log-structured store that spreads writes over its pages, and a blob write
+// only replaces the old entry once the new one is complete, so a record is never
+// half-written. Writes are still kept rare (see main.cpp's serviceCheckpoint()):
+// each one stalls both cores for a few milliseconds while flash is programmed.
+namespace ShowCheckpoint {
+
+// Bump when the record layout or its meaning changes; older records are then ignored.
+const uint16_t RECORD_VERSION = 1;
+const int MAX_EFFECT_LOADS = 8;
+
+struct Record {
+    uint16_t version;
+    uint8_t mode;                  // main.cpp's AutoModeType
+    uint8_t paused;
+    uint32_t seed;
+    uint16_t minutes;
+    uint16_t generatedRampMs;      // Conditions at generation
+    uint8_t generatedBrightness;   // Global master brightness (0-255)
+    uint8_t brightness;            // Global master brightness now
+    uint16_t rampMs;               // motor_ramp now
+    uint16_t effectLoadsMa[MAX_EFFECT_LOADS]; // Learned loads at generation, by effect index
+    uint32_t fingerprint;          // ScriptBuffer::fingerprint() of the generated script
+    uint32_t positionMs;           // Planned script time reached
+    uint32_t elapsedMs;            // Wall time since the script started
+    uint32_t sequence;             // Records written for this show
+};
+
+// Opens the NVS namespace. Call once from setup().
+bool begin();
+
+// False if there is no record or it is from another record version.
+bool load(Record* out);
+// Stamps the version and writes the record. Returns false if NVS refused it.
+bool save(Record& record);
+// Removes the record, so the next boot starts afresh.
+void clear();
+
+// Records written since boot.
+uint32_t writes();
+
+} // namespace ShowCheckpoint
@@ -0,0 +1,308 @@
+// Host-side fuzz harness for the BLE command path, built by the native_fuzz env.
+//
+// Each input is split into commands at '\n'. Every command is taken through the
+// parts of the path that run on the host, in the order loop() uses them, under a
+// simulated clock:
+//   CommandQueue (as the BLE task hands it over), CommandParser::stripSequence and
+//   split, the field parsers processCommand() uses (parseInts, copyField, atoi), the
+//   CommandLimits checks it makes on those fields, the CommandRouter lanes,
+//   coalescing and deferred queue, and CommandAck.
+// The commands are then played as a script (ScriptTimeline build, plan and seek
+// restore) and the whole input is loaded as a phase template file. Invariants of each
+// step are checked with assert(), and the slowest single command is tracked.
+//
+// What stays on the device is listed at processCommand() in main.cpp. Every field its
+// branches read comes from the parsers exercised here, with the same calls.
+//
+// Built as is, the harness runs its own random generator (seeded, so runs repeat)
+// over a corpus of known-malformed commands and prints throughput and the worst
+// per-command time. Sanitizers are on in the env, so memory errors abort with a report.
+//   Run with: .pio/build/native_fuzz/program [ITERATIONS] [SEED]
+// The native_libfuzzer env builds the same file with clang as a libFuzzer target (one
+// input, split here over lines), so coverage guides the inputs:
+//   Run with: .pio/build/native_libfuzzer/program [CORPUS_DIR] [-max_total_time=N]
+#if !defined(ARDUINO)
+
+#include <assert.h>
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../command_ack.h"
+#include "../command_limits.h"
+#include "../command_parser.h"
+#include "../command_queue.h"
+#include "../command_router.h"
+#include "../phase_templates.h"
+#include "../script_buffer.h"
+#include "../script_timeline.h"
+#include "../sculpture_config.h"
+
+static const size_t __MAX_INPUT = 4096;
+static const int __MAX_FIELDS = 8;
+
+static uint32_t __clockMs = 0;
+static ScriptBuffer __script;
+static char __templateText[__MAX_INPUT + 1];
+
+static uint64_t __commands = 0;
+static uint64_t __commandNs = 0;
+static uint64_t __worstNs = 0;
+static char __worstCommand[CommandQueue::MAX_COMMAND_LEN + 1];
+
+static long fuzzRandom(long low, long highExclusive) {
+    return (highExclusive <= low) ? low : low + rand() % (highExclusive - low);
+}
+
+static long fuzzRevTimeMs(int speed) {
+    return (speed > 0) ? 600000L / speed : 0;
+}
+
+// What processCommand() reads from the parameters, with the parsers' contracts checked.
+static void parseFields(const char* params) {
+    int count = CommandParser::fieldCount(params);
+    assert(count >= 1);
+    int values[__MAX_FIELDS];
+    assert(CommandParser::parseInts(params, values, __MAX_FIELDS) == count);
+    volatile int sink = atoi(params);
+    (void)sink;
+    // The limits, on whichever fields a command would take them from. UBSan reports
+    // any overflow on the way.
+    const int strip = Sculpture::LOGICAL_NUM_LEDS;
+    for (int i = 0; i + 1 < count && i + 1 < __MAX_FIELDS; i++) {
+        int comets = values[i], tail = values[i + 1];
+        if (CommandLimits::cometsFit(comets, tail, strip) && comets > 0) {
+            assert(comets <= strip && (int64_t)comets * (tail < 1 ? 1 : tail) <= strip);
+        }
+    }
+    uint32_t seekMs = CommandLimits::seekMs(values[0]);
+    assert(values[0] <= 0 ? seekMs == 0 : seekMs >= (uint32_t)values[0]);
+    char field[24];
+    for (int i = 0; i < count && i < __MAX_FIELDS + 1; i++) {
+        memset(field, 0x7f, sizeof(field));
+        assert(CommandParser::copyField(params, i, field, sizeof(field)));
+        assert(memchr(field, '\0', sizeof(field)) != nullptr);
+    }
+    assert(!CommandParser::copyField(params, count, field, sizeof(field)));
+}
+
+// Mirrors loop()'s handling of one BLE command, minus processCommand().
+static void runCommand(const uint8_t* data, size_t len, bool scriptRunning) {
+    char raw[CommandQueue::MAX_COMMAND_LEN + 1];
+    uint32_t receivedUs = __clockMs * 1000;
+    bool queued = CommandQueue::push((const char*)data, len, receivedUs);
+    assert(queued == (len <= CommandQueue::MAX_COMMAND_LEN));
+    if (!queued) return;
+    uint32_t poppedUs;
+    assert(CommandQueue::pop(raw, &poppedUs) && poppedUs == receivedUs);
+    assert(strlen(raw) <= len);
+
+    CommandRouter::CommandTag tag = { -1, receivedUs };
+    const char* cmd = CommandParser::stripSequence(raw, &tag.seq);
+    assert(cmd >= raw && cmd <= raw + strlen(raw));
+    assert(tag.seq >= -1);
+
+    char name[CommandParser::MAX_NAME_LEN + 1];
+    const char* params = nullptr;
+    if (CommandParser::split(cmd, name, &params)) {
+        assert(strlen(name) <= CommandParser::MAX_NAME_LEN);
+        if (params) parseFields(params);
+    }
+
+    // Coalescing, then the lane, as routeBleCommand() decides it.
+    CommandRouter::ParamKey key = CommandRouter::coalesceKey(cmd);
+    CommandRouter::CommandTag replaced;
+    if (key != CommandRouter::PARAM_NONE && !CommandRouter::offerCoalesced(key, cmd, tag, __clockMs, &replaced)) {
+        CommandAck::complete(replaced.seq, CommandAck::RESULT_SUPERSEDED, replaced.receivedUs, receivedUs);
+        return;
+    }
+    if (CommandRouter::stopsScript(cmd)) {
+        CommandRouter::CommandTag dropped[CommandRouter::PARAM_COUNT];
+        int n = CommandRouter::discardStaged(dropped);
+        assert(n >= 0 && n <= CommandRouter::PARAM_COUNT);
+    }
+    char staged[CommandRouter::MAX_DEFERRED_LEN + 1];
+    while (CommandRouter::takeStagedBefore(cmd, __clockMs, staged, nullptr)) {
+        assert(strlen(staged) <= CommandRouter::MAX_DEFERRED_LEN);
+    }
+    CommandAck::Result result = CommandAck::RESULT_APPLIED;
+    if (scriptRunning) {
+        switch (CommandRouter::classify(cmd)) {
+            case CommandRouter::LANE_OVERRIDE:
+                CommandRouter::record(CommandRouter::DECISION_OVERRIDE, cmd, __clockMs);
+                break;
+            case CommandRouter::LANE_PARAM:
+                CommandRouter::setOverride(CommandRouter::paramKey(cmd));
+                CommandRouter::record(CommandRouter::DECISION_PARAM_OVERRIDE, cmd, __clockMs);
+                break;
+            case CommandRouter::LANE_DEFERRED:
+                result = CommandRouter::defer(cmd, tag) ? CommandAck::RESULT_DEFERRED : CommandAck::RESULT_IGNORED;
+                CommandRouter::record(CommandRouter::DECISION_DEFERRED, cmd, __clockMs);
+                break;
+            case CommandRouter::LANE_REJECT:
+                result = CommandAck::RESULT_IGNORED;
+                CommandRouter::record(CommandRouter::DECISION_REJECTED, cmd, __clockMs);
+                break;
+        }
+    }
+    CommandAck::complete(tag.seq, result, receivedUs, receivedUs + 50);
+    assert(CommandRouter::deferredCount() <= CommandRouter::DEFERRED_CAPACITY);
+}
+
+// Everything loop() would do between passes: due coalesced values, deferred commands
+// at a scene boundary, the frame and acknowledgements.
+static void runPass(bool sceneBoundary) {
+    char out[CommandRouter::MAX_DEFERRED_LEN + 1];
+    CommandRouter::CommandTag tag;
+    while (CommandRouter::takeDueCoalesced(__clockMs, out, &tag)) {
+        assert(strlen(out) <= CommandRouter::MAX_DEFERRED_LEN);
+    }
+    if (sceneBoundary) {
+        while (CommandRouter::popDeferred(out, &tag)) assert(strlen(out) <= CommandRouter::MAX_DEFERRED_LEN);
+    }
+    CommandAck::frameShown(__clockMs * 1000);
+    char line[CommandAck::MAX_LINE_LEN];
+    while (CommandAck::takeReady(__clockMs * 1000, line, sizeof(line))) assert(strlen(line) < sizeof(line));
+    assert(CommandRouter::statusCount() <= CommandRouter::STATUS_RING_SIZE);
+}
+
+static void resetState() {
+    char out[CommandQueue::MAX_COMMAND_LEN + 1];
+    uint32_t us;
+    while (CommandQueue::pop(out, &us)) {}
+    CommandRouter::clearOverrides();
+    CommandRouter::clearDeferred();
+    CommandRouter::CommandTag dropped[CommandRouter::PARAM_COUNT];
+    CommandRouter::discardStaged(dropped);
+    __script.clear();
+}
+
+// The input's commands as a script: timing, seek and restore plans.
+static void runScript() {
+    if (__script.empty()) return;
+    ScriptTimeline::build(__script, 4000);
+    uint32_t holdMs = 0;
+    uint32_t total = ScriptTimeline::plannedMs(__script, 4000, &holdMs);
+    assert(total == ScriptTimeline::totalMs() && holdMs <= total);
+    uint32_t remaining;
+    int step = ScriptTimeline::stepForTime(total / 2, &remaining);
+    assert(step >= 0 && step <= __script.size());
+    ScriptTimeline::RestorePlan plan;
+    ScriptTimeline::planRestore(__script, 0, step, remaining, &plan);
+    assert(plan.count >= 0 && plan.count <= ScriptTimeline::MAX_RESTORE_STEPS);
+    for (int i = 1; i < plan.count; i++) assert(plan.steps[i - 1] < plan.steps[i]);
+    assert(plan.defaultCount == 0);
+    ScriptTimeline::planRestore(__script, step, __script.size(), 0, &plan);
+    ScriptTimeline::planRestore(__script, __script.size(), step, remaining, &plan);
+    assert(plan.defaultCount >= 0 && plan.defaultCount <= ScriptTimeline::MAX_RESTORE_STEPS);
+}
+
+static void runInput(const uint8_t* data, size_t size) {
+    if (size > __MAX_INPUT) size = __MAX_INPUT;
+    resetState();
+    bool scriptRunning = size > 0 && (data[0] & 1);
+    size_t start = 0;
+    for (size_t i = 0; i <= size; i++) {
+        if (i < size && data[i] != '\n') continue;
+        // The byte before each command advances the clock, so coalescing intervals and
+        // acknowledgement timeouts are crossed in both directions.
+        __clockMs += (start > 0) ? data[start - 1] % 64 : 1;
+        auto t0 = std::chrono::steady_clock::now();
+        runCommand(data + start, i - start, scriptRunning);
+        runPass(start > 0 && data[start - 1] % 7 == 0);
+        uint64_t ns = (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - t0).count();
+        __commands++;
+        __commandNs += ns;
+        if (ns > __worstNs) {
+            __worstNs = ns;
+            size_t n = (i - start < CommandQueue::MAX_COMMAND_LEN) ? i - start : CommandQueue::MAX_COMMAND_LEN;
+            memcpy(__worstCommand, data + start, n);
+            __worstCommand[n] = '\0';
+        }
+        char line[PhaseTemplates::MAX_LINE_LEN + 1];
+        size_t n = (i - start < PhaseTemplates::MAX_LINE_LEN) ? i - start : PhaseTemplates::MAX_LINE_LEN;
+        memcpy(line, data + start, n);
+        line[n] = '\0';
+        __script.push(line);
+        start = i + 1;
+    }
+    runScript();
+
+    memcpy(__templateText, data, size);
+    __templateText[size] = '\0';
+    int errorLine = 0;
+    if (PhaseTemplates::load(__templateText, &errorLine)) {
+        PhaseTemplates::Context ctx = { fuzzRandom, fuzzRevTimeMs, 4000, nullptr };
+        PhaseTemplates::Composition plan;
+        PhaseTemplates::compose(10 * 60000L, SCRIPT_MAX_LINES, ctx, __script, &plan);
+        // Leave the built-in set active for the next input.
+        PhaseTemplates::load(PhaseTemplates::BUILTIN_TEMPLATES, &errorLine);
+    }
+}
+
+#if defined(COMMAND_FUZZ_LIBFUZZER)
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    runInput(data, size);
+    return 0;
+}
+
+#else
+
+// Commands that once had undefined cost or behaviour, and neighbours of them.
+static const char* const __corpus[] = {
+    "led_tails:,", "led_tails:,,,,,,,,,,", "led_effect:marquee,", "led_effect:,", "led_effect:noise,,",
+    "led_blink:", "led_blink:1,2", "motor_speed:", "motor_speed:-99999999999", "motor_speed:2147483648",
+    "#", "# motor_speed:5", "#999999999999 led_reset", "#42", ":", "::::", "hold:", "hold:-1",
+    "led_background:300,-5", "led_sine_hue:1", "script_seek:99999999", "script_seek:2147483647", "trace:", "lcd:", "a:b:c",
+    "led_comet_group:1,20000000,255,0,100,1", "led_comet_group:1,-2147483648,0,0,0,0",
+    "led_tails:0,2147483647,2147483647", "led_tails:0,-2147483648,-2",
+    "led_effect:marquee,1,2,3,4,5,6,7,8,9,10", "phase X 1-2\nscene 1\nhold:{1-}\n",
+    "phase A 1000\nscene 1\n@repeat 1-99999 0\nhold:1\n@end\n",
+};
+
+static const char __alphabet[] = "abcdefghijklmnopqrstuvwxyz_:,#-0123456789 \n{}@?![]";
+
+int main(int argc, char** argv) {
+    long iterations = (argc > 1) ? atol(argv[1]) : 200000;
+    unsigned seed = (argc > 2) ? (unsigned)atoi(argv[2]) : 1;
+    int errorLine = 0;
+    PhaseTemplates::load(PhaseTemplates::BUILTIN_TEMPLATES, &errorLine);
+
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < sizeof(__corpus) / sizeof(__corpus[0]); i++) {
+        runInput((const uint8_t*)__corpus[i], strlen(__corpus[i]));
+    }
+    srand(seed);
+    static uint8_t input[__MAX_INPUT];
+    for (long it = 0; it < iterations; it++) {
+        size_t len = (size_t)(rand() % 300);
+        if (rand() % 4 == 0) {
+            // Mutate a corpus entry
+            const char* base = __corpus[rand() % (sizeof(__corpus) / sizeof(__corpus[0]))];
+            len = strlen(base);
+            memcpy(input, base, len);
+            for (int m = rand() % 4; m >= 0 && len > 0; m--) input[rand() % len] = (uint8_t)rand();
+        } else if (rand() % 2 == 0) {
+            for (size_t k = 0; k < len; k++) input[k] = (uint8_t)__alphabet[rand() % (sizeof(__alphabet) - 1)];
+        } else {
+            for (size_t k = 0; k < len; k++) input[k] = (uint8_t)rand();
+        }
+        runInput(input, len);
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    printf("%ld inputs, %llu commands in %.2f s: %.0f commands/s, mean %.2f us, worst %.2f us\n",
+           iterations, (unsigned long long)__commands, seconds, __commands / seconds,
+           __commands ? __commandNs / 1000.0 / __commands : 0.0, __worstNs / 1000.0);
+    printf("Worst command: \"");
+    for (const char* p = __worstCommand; *p; p++) {
+        if (*p >= 32 && *p < 127) putchar(*p);
+        else printf("\\x%02x", (uint8_t)*p);
+    }
+    printf("\"\n");
+    return 0;
+}
+
+#endif
+
+#endif
@@ -0,0 +1,76 @@
+// Host-side harness for the LCD dashboard, built by the native_sdl env against
+// M5GFX's SDL2 backend. It drives the dashboard and then the strip preview with a
+// synthetic show and prints their cost, so layout and draw cost can be checked
+// without hardware.
+// Run headless with: SDL_VIDEODRIVER=dummy .pio/build/native_sdl/program
+#if !defined(ARDUINO)
+
+#include <M5GFX.h>
+#include <stdio.h>
+#include "../lcd_dashboard.h"
+
+static M5GFX __display;
+
+static const char* const __effects[] = { "comet", "marquee", "noise", "fire" };
+static const char* const __phases[] = { "INTRODUCTION", "VIBE", "TENSION", "CLIMAX", "COOL_DOWN" };
+static const int __SIM_FRAMES = 600; // One simulated minute at the dashboard's 10 Hz refresh
+static const int __SIM_NUM_LEDS = 198;
+static const int __SIM_LOGICAL_NUM_LEDS = 223;
+static uint8_t __simLeds[__SIM_NUM_LEDS * 3];
+
+static int user_func(bool* running) {
+    __display.init();
+    LcdDashboard::begin(__display);
+
+    uint32_t now_ms = 0;
+    for (int frame = 0; frame < __SIM_FRAMES && *running; frame++) {
+        LcdDashboard::Status status;
+        status.speedSetting = 500 + (frame / 100) * 100;
+        status.currentSpeed = status.speedSetting - ((frame % 100) < 20 ? (20 - frame % 100) * 5 : 0);
+        status.clockwise = (frame / 150) % 2 == 0;
+        status.motorRunning = true;
+        status.effectName = __effects[(frame / 120) % 4];
+        status.phaseName = __phases[(frame / 60) % 5];
+        status.holdRemainingMs = 6000 - (long)(frame % 60) * 100;
+        status.scriptRemainingMs = 1800000 - (long)frame * 100;
+        status.loopFps = (uint16_t)(850 + frame % 7);
+        status.freeHeap = 180000 - (uint32_t)(frame % 3) * 2048;
+
+        now_ms += LcdDashboard::UPDATE_INTERVAL_MS;
+        LcdDashboard::update(status, now_ms);
+        __display.display();
+    }
+
+    // Preview: three comets with fading tails over a dim blue background.
+    LcdDashboard::setStripGeometry(__SIM_NUM_LEDS, __SIM_LOGICAL_NUM_LEDS);
+    LcdDashboard::setMode(LcdDashboard::MODE_PREVIEW);
+    for (int frame = 0; frame < __SIM_FRAMES && *running; frame++) {
+        for (int i = 0; i < __SIM_NUM_LEDS; i++) {
+            int d = (i + frame) % (__SIM_LOGICAL_NUM_LEDS / 3);
+            uint8_t v = (d < 12) ? (uint8_t)(255 - d * 20) : 0;
+            __simLeds[i * 3] = v;
+            __simLeds[i * 3 + 1] = v / 4;
+            __simLeds[i * 3 + 2] = (v > 30) ? v / 2 : 30;
+        }
+        now_ms += LcdDashboard::PREVIEW_INTERVAL_MS;
+        LcdDashboard::submitFrame(__simLeds, __SIM_NUM_LEDS, now_ms);
+        LcdDashboard::update(LcdDashboard::Status(), now_ms);
+        __display.display();
+    }
+
+    const LcdDashboard::Stats& st = LcdDashboard::stats();
+    printf("Dashboard: %lu refreshes, %lu regions pushed (%.2f per refresh)\n",
+           (unsigned long)st.refreshes, (unsigned long)st.regionsPushed,
+           st.refreshes ? (double)st.regionsPushed / st.refreshes : 0.0);
+    printf("Refresh CPU: avg %lu us, max %lu us\n", (unsigned long)st.avgRefreshUs, (unsigned long)st.maxRefreshUs);
+    printf("Preview: %lu frames, %lu points drawn. Frame CPU: avg %lu us, max %lu us\n",
+           (unsigned long)st.previewFrames, (unsigned long)st.previewPointsDrawn,
+           (unsigned long)st.avgPreviewUs, (unsigned long)st.maxPreviewUs);
+    return 0;
+}
+
+int main(int, char**) {
+    return lgfx::Panel_sdl::main(user_func);
+}
+
+#endif
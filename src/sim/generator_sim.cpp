@@ -0,0 +1,118 @@
+// Host-side harness for the auto_mode phase templates, built by the native_generator
+// env. It composes scripts from the built-in templates, or from a template file given
+// on the command line, and prints one. It then runs the device's gen_bench cases, both
+// auto_mode and auto_steady_rotate, at the same durations and seeds, reporting step
+// counts, script bytes, generation time, and for auto_mode predicted against requested
+// time. Heap is not measured here ("heap n/a"); neither generator allocates, and the
+// device's gen_bench reports it. Use it to try a new style before copying the file to
+// /phases.txt on the device.
+// Run with: .pio/build/native_generator/program [MINUTES] [TEMPLATE_FILE]
+#if !defined(ARDUINO)
+
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include "../gen_bench.h"
+#include "../phase_templates.h"
+#include "../sculpture_config.h"
+#include "../steady_rotate.h"
+
+static const uint32_t __SIM_RAMP_MS = 4000; // DEFAULT_RAMP_DURATION_MS
+static char __templateFile[8192];
+static ScriptBuffer __script;
+
+static long simRandom(long low, long highExclusive) {
+    return (highExclusive <= low) ? low : low + rand() % (highExclusive - low);
+}
+
+static long simRevTimeMs(int speed) {
+    return calculateRevTimeMs<Sculpture>(speed);
+}
+
+int main(int argc, char** argv) {
+    int minutes = (argc > 1) ? atoi(argv[1]) : 10;
+    const char* text = PhaseTemplates::BUILTIN_TEMPLATES;
+    if (argc > 2) {
+        FILE* f = fopen(argv[2], "rb");
+        if (f == nullptr) {
+            printf("Cannot open %s\n", argv[2]);
+            return 1;
+        }
+        size_t len = fread(__templateFile, 1, sizeof(__templateFile) - 1, f);
+        fclose(f);
+        __templateFile[len] = '\0';
+        text = __templateFile;
+    }
+
+    int errorLine = 0;
+    if (!PhaseTemplates::load(text, &errorLine)) {
+        printf("Template error on line %d\n", errorLine);
+        return 1;
+    }
+    for (int i = 0; i < PhaseTemplates::phaseCount(); i++) {
+        printf("%-14s %d scenes\n", PhaseTemplates::phaseName(i), PhaseTemplates::sceneCount(i));
+    }
+
+    PhaseTemplates::Context context = { simRandom, simRevTimeMs, __SIM_RAMP_MS, nullptr };
+    PhaseTemplates::Composition plan;
+    const long totalMs = minutes * 60000L;
+    const int maxLines = SCRIPT_MAX_LINES;
+
+    srand(1);
+    PhaseTemplates::compose(totalMs, maxLines, context, __script, &plan);
+    for (int i = 0; i < __script.size(); i++) puts(__script[i]);
+
+    // The same cases and seeds as the device's gen_bench, plus a fitting check.
+    struct BenchCase {
+        const char* name;
+        bool steadyRotate;
+        int minutes;
+    };
+    static const BenchCase benchCases[] = {
+        { "auto_mode", false, 5 },
+        { "auto_mode", false, 30 },
+        { "auto_mode", false, 60 },
+        { "auto_mode", false, 240 },
+        { "auto_steady_rotate", true, 60 },
+        { "auto_steady_rotate", true, 240 },
+        { "auto_steady_rotate", true, 480 }
+    };
+    GenBench::Sample samples[GenBench::MAX_SAMPLES];
+    for (size_t c = 0; c < sizeof(benchCases) / sizeof(benchCases[0]); c++) {
+        const BenchCase& bench = benchCases[c];
+        long benchMs = bench.minutes * 60000L;
+        long worstComposedMs = 0, worstErrorMs = 0;
+        for (int run = 0; run < GenBench::MAX_SAMPLES; run++) {
+            srand(run + 1);
+            auto start = std::chrono::steady_clock::now();
+            if (bench.steadyRotate) {
+                SteadyRotate::compose(benchMs, maxLines, context, __script);
+            } else {
+                PhaseTemplates::compose(benchMs, maxLines, context, __script, &plan);
+            }
+            auto end = std::chrono::steady_clock::now();
+            GenBench::Sample sample = {};
+            sample.us = (uint32_t)std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+            sample.lines = (uint16_t)__script.size();
+            sample.dropped = (uint16_t)__script.dropped();
+            sample.bytes = (uint32_t)__script.bytesUsed();
+            samples[run] = sample;
+            if (bench.steadyRotate) continue;
+            long composed = labs(plan.predictedMs - benchMs);
+            if (composed > worstComposedMs) worstComposedMs = composed;
+            long error = labs(plan.fittedMs - benchMs);
+            if (error > worstErrorMs) worstErrorMs = error;
+        }
+        GenBench::Summary summary;
+        GenBench::summarize(samples, GenBench::MAX_SAMPLES, bench.minutes, &summary);
+        char line[256];
+        GenBench::format(bench.name, bench.minutes, summary, line, sizeof(line));
+        printf("%s\n", line);
+        if (!bench.steadyRotate) {
+            printf("  predicted time off by up to %ld ms as composed, %ld ms fitted\n", worstComposedMs, worstErrorMs);
+        }
+    }
+    return 0;
+}
+
+#endif
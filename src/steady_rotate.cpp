@@ -0,0 +1,91 @@
+#include "steady_rotate.h"
+
+namespace SteadyRotate {
+
+// --- Configuration for auto_steady_rotate mode (see the notes in auto_generator.cpp) ---
+static const float AUTO_STEADY_ROTATE_LED_MOTOR_MAX_RATIO = 4.0;
+static const float AUTO_STEADY_ROTATE_LED_MOTOR_MIN_RATIO = 1.0;
+static const int AUTO_STEADY_ROTATE_LED_EFFECT_STEPS = 10;
+static const float AUTO_STEADY_ROTATE_LED_EFFECT_STEP_DURATION_S = 2.0;
+
+// Lines in one cycle at most: seven setting up the effect, then two ramps of a comment
+// and a cycle time and hold per step.
+static const int CYCLE_MAX_LINES = 7 + 2 * (1 + 2 * (AUTO_STEADY_ROTATE_LED_EFFECT_STEPS + 1));
+
+// Arduino map(), which the ramp ratios were first computed with.
+static long mapRange(long x, long inMin, long inMax, long outMin, long outMax) {
+    return (x - inMin) * (outMax - outMin) / (inMax - inMin) + outMin;
+}
+
+// One ramp of the LED cycle time, from `fromPercent` to `toPercent` of a revolution.
+static void pushRamp(ScriptBuffer& script, const char* name, long revTimeMs, float fromRatio, float toRatio) {
+    const long stepMs = (long)(AUTO_STEADY_ROTATE_LED_EFFECT_STEP_DURATION_S * 1000.0);
+    script.pushf("[---------- %s ----------]", name);
+    for (int i = 0; i <= AUTO_STEADY_ROTATE_LED_EFFECT_STEPS; i++) {
+        float ratio = mapRange(i, 0, AUTO_STEADY_ROTATE_LED_EFFECT_STEPS, (long)(fromRatio * 100), (long)(toRatio * 100)) / 100.0f;
+        script.pushf("led_cycle_time:%ld", (long)(revTimeMs * ratio));
+        script.pushf("hold:%ld", stepMs);
+    }
+}
+
+void compose(long durationMs, int maxLines, const PhaseTemplates::Context& context, ScriptBuffer& script) {
+    script.clear();
+    if (durationMs <= 0) return;
+    long (*random)(long, long) = context.random;
+    long accumulatedMs = 0;
+
+    script.push("led_global_brightness:20");
+    script.pushf("motor_speed:%ld", (long)MOTOR_SPEED);
+    script.push("hold:3000"); // Give motor time to spin up to steady speed
+    accumulatedMs += 3000;
+
+    const long rampMs = (AUTO_STEADY_ROTATE_LED_EFFECT_STEPS + 1) * (long)(AUTO_STEADY_ROTATE_LED_EFFECT_STEP_DURATION_S * 1000.0);
+    // Start a cycle only if all of it fits, with a line to spare for system_off.
+    while (accumulatedMs < durationMs && script.size() + CYCLE_MAX_LINES < maxLines) {
+        script.push("[---------- NEW STEADY CYCLE ----------]");
+        script.push("led_reset"); // Clear previous effects
+
+        // Rotational effect (Comet or Marquee)
+        bool useComet = random(0, 100) < 50;
+        uint8_t fgHue = (uint8_t)random(0, 256);
+        uint8_t bgHue = (uint8_t)((fgHue + random(80, 177)) % 256); // Contrasting bg
+
+        if (useComet) {
+            script.push("[---------- COMET EFFECT ----------]");
+            int length = (int)random(15, 41);
+            int tails = (int)random(1, 6);
+            script.pushf("led_tails:%d,%d,%d", (int)fgHue, length, tails);
+
+            // Add layering for more color variety
+            long colorMod = random(0, 100);
+            if (colorMod < 33) {
+                script.push("led_rainbow");
+            } else if (colorMod < 66) {
+                uint8_t hueLow = (uint8_t)random(0, 256);
+                uint8_t hueHigh = (uint8_t)((hueLow + random(60, 120)) % 256);
+                script.pushf("led_sine_hue:%d,%d", (int)hueLow, (int)hueHigh);
+            }
+            // else: plain comet color
+        } else {
+            script.push("[---------- MARQUEE EFFECT ----------]");
+            int litWidth = (int)random(2, 6);
+            int darkWidth = (int)random(4, 11);
+            script.pushf("led_effect:marquee,%d,%d,%d", (int)fgHue, litWidth, darkWidth);
+        }
+        script.pushf("led_background:%d,%d", (int)bgHue, (int)random(10, 26));
+
+        // Randomly set LED direction for this cycle
+        if (random(0, 100) < 50) script.push("led_reverse");
+
+        long revTimeMs = context.revTimeMs(MOTOR_SPEED);
+        // Ramp from slow to fast (MAX_RATIO to MIN_RATIO), then back
+        pushRamp(script, "Ramp Up LED Speed", revTimeMs, AUTO_STEADY_ROTATE_LED_MOTOR_MAX_RATIO, AUTO_STEADY_ROTATE_LED_MOTOR_MIN_RATIO);
+        accumulatedMs += rampMs;
+        pushRamp(script, "Ramp Down LED Speed", revTimeMs, AUTO_STEADY_ROTATE_LED_MOTOR_MIN_RATIO, AUTO_STEADY_ROTATE_LED_MOTOR_MAX_RATIO);
+        accumulatedMs += rampMs;
+    }
+
+    script.push("system_off");
+}
+
+} // namespace SteadyRotate
@@ -0,0 +1,22 @@
+#pragma once
+
+#include "phase_templates.h"
+#include "script_buffer.h"
+
+// The auto_steady_rotate show: the motor at one steady speed, and cycles of a comet or
+// marquee effect whose LED cycle time ramps from four motor revolutions down to one and
+// back, two seconds a step.
+//
+// Randomness and the revolution time come from a PhaseTemplates::Context, as for
+// PhaseTemplates::compose(), so the same seed gives the same show on the device and in
+// the host harnesses. Nothing here allocates or touches Arduino APIs.
+namespace SteadyRotate {
+
+// Logical motor speed the show runs at.
+const int MOTOR_SPEED = 500;
+
+// Writes a show of about `durationMs` into `script` (cleared first), in at most
+// `maxLines` lines. Only context.random and context.revTimeMs are used.
+void compose(long durationMs, int maxLines, const PhaseTemplates::Context& context, ScriptBuffer& script);
+
+} // namespace SteadyRotate
@@ -0,0 +1,70 @@
+#include "strip_render.h"
+
+namespace StripRender {
+
+// FastLED's scale8() and CRGB::nscale8(), with its default FASTLED_SCALE8_FIXED.
+static inline uint8_t scale8(uint8_t value, uint8_t scale) {
+    return (uint8_t)(((uint16_t)value * (uint16_t)(scale + 1)) >> 8);
+}
+
+static inline void setPixel(uint8_t* pixel, const uint8_t* color) {
+    pixel[0] = color[0];
+    pixel[1] = color[1];
+    pixel[2] = color[2];
+}
+
+void renderHeatRange(int begin, int end, void* arg) {
+    const HeatJob& job = *(const HeatJob*)arg;
+    for (int i = begin; i < end; i++) setPixel(job.rgb + i * 3, job.heatRgb[job.heat[i]]);
+}
+
+int fillCometTailLevels(uint8_t* levels, int maxPixels, uint8_t tailLength) {
+    uint8_t keep = 255 - 255 / (tailLength > 1 ? tailLength : 1);
+    uint8_t level = 255;
+    int n = 0;
+    while (n < maxPixels && level > 0) {
+        levels[n++] = level;
+        level = scale8(level, keep);
+    }
+    return n;
+}
+
+void renderCometRange(int begin, int end, void* arg) {
+    const CometJob& job = *(const CometJob*)arg;
+    for (int i = begin; i < end; i++) setPixel(job.rgb + i * 3, job.background);
+    // Beyond the fill, the cost is one step per tail pixel, whatever the strip length.
+    const int length = job.logicalLength;
+    for (int g = 0; g < job.drawCount; g++) {
+        const CometDraw& d = job.draws[g];
+        for (int j = 0; j < d.count; j++) {
+            int pos = (d.head + j * d.spacing) % length;
+            for (int k = 0; k < d.tailPixels; k++) {
+                if (pos >= begin && pos < end) {
+                    uint8_t* pixel = job.rgb + pos * 3;
+                    if (k == 0) {
+                        setPixel(pixel, d.color);
+                    } else {
+                        // Brightest wins where tails cross
+                        for (int c = 0; c < 3; c++) {
+                            uint8_t tail = scale8(d.color[c], d.levels[k]);
+                            if (tail > pixel[c]) pixel[c] = tail;
+                        }
+                    }
+                }
+                pos += d.tailStep;
+                if (pos < 0) pos += length;
+                else if (pos >= length) pos -= length;
+            }
+        }
+    }
+}
+
+void renderMarqueeRange(int begin, int end, void* arg) {
+    static const uint8_t black[3] = { 0, 0, 0 };
+    const MarqueeJob& job = *(const MarqueeJob*)arg;
+    for (int i = begin; i < end; i++) {
+        setPixel(job.rgb + i * 3, (((i + job.offset) % job.totalWidth) < job.litWidth) ? job.color : black);
+    }
+}
+
+} // namespace StripRender
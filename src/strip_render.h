@@ -0,0 +1,88 @@
+#pragma once
+
+#include <stdint.h>
+
+// Per-pixel stages of the full-strip LED effects (noise, fire's heat map, comets and
+// marquee), as ParallelRender range functions.
+//
+// Each stage writes only the pixels in its own range and reads nothing shared but its
+// job, so a split render is identical to a serial one. Frames are RGB, 3 bytes per
+// pixel (CRGB's layout), as ParticleSystem::render() draws them. FastLED's colour maps
+// come in as 256-entry tables built with FastLED on the device: HeatColor() once at
+// setup, and ColorFromPalette() when a noise palette is chosen. The Perlin noise is
+// inoise8(), passed as a template argument so the device calls it directly.
+//
+// Nothing here allocates or touches Arduino APIs, so it also builds on the host, where
+// test/test_perf_budget gives each stage a ns-per-pixel budget.
+namespace StripRender {
+
+// Groups one comet pass can draw; main.cpp's __COMET_GROUPS.
+const int MAX_COMET_DRAWS = 4;
+
+typedef uint8_t (*NoiseFn)(uint16_t x, uint16_t y, uint16_t z);
+
+struct NoiseJob {
+    uint8_t* rgb;
+    const uint8_t (*paletteRgb)[3]; // ColorFromPalette(palette, i, 255, LINEARBLEND) for each i
+    uint16_t x, y, z;
+    uint8_t scale;
+};
+
+template <NoiseFn Noise>
+void renderNoiseRange(int begin, int end, void* arg) {
+    const NoiseJob& job = *(const NoiseJob*)arg;
+    for (int i = begin; i < end; i++) {
+        const uint8_t* color = job.paletteRgb[Noise(job.x + i * job.scale, job.y, job.z)];
+        uint8_t* pixel = job.rgb + i * 3;
+        pixel[0] = color[0];
+        pixel[1] = color[1];
+        pixel[2] = color[2];
+    }
+}
+
+struct HeatJob {
+    uint8_t* rgb;
+    const uint8_t* heat;
+    const uint8_t (*heatRgb)[3]; // HeatColor(i) for each i
+};
+
+void renderHeatRange(int begin, int end, void* arg);
+
+// Comet tails are drawn explicitly rather than left behind by fading the last frame,
+// so groups moving at different speeds keep their own tails. Level k is the head's
+// brightness after k of led_tails' fades; the table stops at the first zero.
+int fillCometTailLevels(uint8_t* levels, int maxPixels, uint8_t tailLength);
+
+// One group as the frame draws it.
+struct CometDraw {
+    uint8_t color[3];
+    int head;              // LED of the first comet's head
+    int tailStep;          // 1 or -1: the way the tail trails from the head
+    int count;
+    int spacing;
+    const uint8_t* levels;
+    int tailPixels;
+};
+
+// The background, then every comet of every group, in a single pass.
+struct CometJob {
+    uint8_t* rgb;
+    uint8_t background[3];
+    int logicalLength;     // Comets wrap around the strip plus its virtual gap
+    CometDraw draws[MAX_COMET_DRAWS];
+    int drawCount;
+};
+
+void renderCometRange(int begin, int end, void* arg);
+
+struct MarqueeJob {
+    uint8_t* rgb;
+    uint8_t color[3]; // Converted from HSV once, not per lit pixel
+    uint8_t offset;
+    uint8_t litWidth;
+    uint8_t totalWidth;
+};
+
+void renderMarqueeRange(int begin, int end, void* arg);
+
+} // namespace StripRender
@@ -0,0 +1,121 @@
+#include "sys_stats.h"
+#include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <stdio.h>
+#include <string.h>
+
+namespace SysStats {
+
+#if configUSE_TRACE_FACILITY
+static TaskStatus_t __status[MAX_TASKS];
+#endif
+// Run-time counters from the previous snapshot, by task number.
+static UBaseType_t __prevTaskNumber[MAX_TASKS];
+static uint32_t __prevRunTime[MAX_TASKS];
+static int __prevCount = 0;
+static uint32_t __prevTotalRunTime = 0;
+static uint32_t __prevMs = 0;
+
+#if configUSE_TRACE_FACILITY && configGENERATE_RUN_TIME_STATS
+static bool previousRunTime(UBaseType_t taskNumber, uint32_t* runTime) {
+    for (int i = 0; i < __prevCount; i++) {
+        if (__prevTaskNumber[i] == taskNumber) {
+            *runTime = __prevRunTime[i];
+            return true;
+        }
+    }
+    return false;
+}
+#endif
+
+void collect(Snapshot* out) {
+    uint32_t startUs = micros();
+    uint32_t nowMs = millis();
+    memset(out, 0, sizeof(*out));
+    out->uptimeS = nowMs / 1000;
+    out->intervalMs = __prevMs ? nowMs - __prevMs : 0;
+    out->heapFree = ESP.getFreeHeap();
+    out->heapMinFree = ESP.getMinFreeHeap();
+    out->heapLargest = ESP.getMaxAllocHeap();
+    out->callerStackFreeBytes = uxTaskGetStackHighWaterMark(nullptr) * sizeof(StackType_t);
+    for (int c = 0; c < MAX_CORES; c++) out->coreLoadPermille[c] = -1;
+
+#if configUSE_TRACE_FACILITY
+    uint32_t totalRunTime = 0;
+    out->tasksRunning = (int)uxTaskGetNumberOfTasks();
+    // uxTaskGetSystemState() fills nothing, returning 0, if the array is too small, so
+    // check first. A task created in between still makes it return 0.
+    int n = 0;
+    if (out->tasksRunning <= MAX_TASKS) n = (int)uxTaskGetSystemState(__status, MAX_TASKS, &totalRunTime);
+    out->taskListOverflow = (n == 0);
+    if (n == 0) {
+        // Nothing to compare CPU use against; the next full snapshot starts afresh.
+        __prevCount = 0;
+        __prevTotalRunTime = 0;
+        __prevMs = nowMs;
+        out->collectUs = micros() - startUs;
+        return;
+    }
+    uint32_t totalDelta = totalRunTime - __prevTotalRunTime;
+    bool haveInterval = (__prevTotalRunTime != 0 && totalDelta != 0);
+
+    for (int i = 0; i < n; i++) {
+        const TaskStatus_t& st = __status[i];
+        Task& t = out->tasks[i];
+        strncpy(t.name, st.pcTaskName, sizeof(t.name) - 1);
+#if configTASKLIST_INCLUDE_COREID
+        t.core = (st.xCoreID == tskNO_AFFINITY) ? -1 : (int8_t)st.xCoreID;
+#else
+        t.core = -1;
+#endif
+        t.priority = (uint8_t)st.uxCurrentPriority;
+        t.state = (uint8_t)st.eCurrentState;
+        t.stackFreeBytes = st.usStackHighWaterMark * sizeof(StackType_t);
+        t.cpuPermille = -1;
+#if configGENERATE_RUN_TIME_STATS
+        uint32_t prev;
+        if (haveInterval && previousRunTime(st.xTaskNumber, &prev)) {
+            uint64_t permille = (uint64_t)(st.ulRunTimeCounter - prev) * 1000 / totalDelta;
+            t.cpuPermille = (int16_t)(permille < 1000 ? permille : 1000);
+        }
+        if (strncmp(t.name, "IDLE", 4) == 0 && t.core >= 0 && t.core < MAX_CORES && t.cpuPermille >= 0) {
+            out->coreLoadPermille[t.core] = (int16_t)(1000 - t.cpuPermille);
+        }
+#endif
+    }
+    out->taskCount = n;
+
+    // Keep this snapshot's counters for the next interval.
+    for (int i = 0; i < n; i++) {
+        __prevTaskNumber[i] = __status[i].xTaskNumber;
+        __prevRunTime[i] = __status[i].ulRunTimeCounter;
+    }
+    __prevCount = n;
+    __prevTotalRunTime = totalRunTime;
+
+    // Busiest first. Insertion sort: n is small.
+    for (int i = 1; i < n; i++) {
+        Task t = out->tasks[i];
+        int j = i;
+        for (; j > 0 && out->tasks[j - 1].cpuPermille < t.cpuPermille; j--) out->tasks[j] = out->tasks[j - 1];
+        out->tasks[j] = t;
+    }
+#endif
+    __prevMs = nowMs;
+    out->collectUs = micros() - startUs;
+}
+
+int formatSummary(const Snapshot& s, char* out, size_t len) {
+    return snprintf(out, len, "SYS %lu %lu %lu %lu %d %d %lu %d %lu", (unsigned long)s.uptimeS,
+                    (unsigned long)s.heapFree, (unsigned long)s.heapMinFree, (unsigned long)s.heapLargest,
+                    s.coreLoadPermille[0], s.coreLoadPermille[1], (unsigned long)s.callerStackFreeBytes,
+                    s.taskCount, (unsigned long)s.collectUs);
+}
+
+int formatTask(const Task& t, char* out, size_t len) {
+    return snprintf(out, len, "TSK %s %d %u %lu %d", t.name, t.core, (unsigned)t.priority,
+                    (unsigned long)t.stackFreeBytes, t.cpuPermille);
+}
+
+} // namespace SysStats
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// FreeRTOS task, stack, CPU-load and heap statistics.
+//
+// collect() takes one snapshot of every task with uxTaskGetSystemState() into a
+// static array, so it costs no heap and its time is bounded by MAX_TASKS. That call
+// lists all tasks or none, so with more than MAX_TASKS running the snapshot has no
+// task list and says so in taskListOverflow. (The
+// FreeRTOS vTaskGetRunTimeStats() helper was not used: it mallocs its task array and
+// formats one large string.) CPU use is measured over the interval since the
+// previous snapshot, in permille of one core, so the idle task of each core gives
+// that core's load. The time collect() itself took is part of the snapshot.
+//
+// Run-time percentages need configGENERATE_RUN_TIME_STATS; without it they read -1.
+// Task lists need configUSE_TRACE_FACILITY; without it only heap, uptime and the
+// calling task's stack are reported.
+//
+// Only the loop task may call collect().
+namespace SysStats {
+
+const int MAX_TASKS = 32;
+const int MAX_CORES = 2;
+// Long enough for the SYS and TSK lines.
+const size_t MAX_LINE_LEN = 96;
+
+struct Task {
+    char name[16];
+    int8_t core;              // -1: not pinned
+    uint8_t priority;
+    uint8_t state;            // eTaskState
+    uint32_t stackFreeBytes;  // High-water mark: the least free stack ever seen
+    int16_t cpuPermille;      // Of one core, since the previous snapshot; -1 if unknown
+};
+
+struct Snapshot {
+    uint32_t uptimeS;
+    uint32_t intervalMs;      // Since the previous snapshot (0 for the first)
+    uint32_t heapFree;
+    uint32_t heapMinFree;
+    uint32_t heapLargest;
+    int16_t coreLoadPermille[MAX_CORES]; // 1000 - that core's idle task; -1 if unknown
+    uint32_t callerStackFreeBytes;
+    int taskCount;            // Tasks listed below
+    int tasksRunning;         // Tasks that exist, listed or not
+    bool taskListOverflow;    // More than MAX_TASKS running: none are listed
+    Task tasks[MAX_TASKS];    // Sorted by CPU use, highest first
+    uint32_t collectUs;       // What this snapshot cost
+};
+
+void collect(Snapshot* out);
+
+// "SYS <uptime_s> <heap_free> <heap_min> <heap_largest> <cpu0_permille> <cpu1_permille>
+//  <loop_stack_free> <tasks> <collect_us>", where <tasks> is the number listed (0 on
+// overflow).
+int formatSummary(const Snapshot& s, char* out, size_t len);
+// "TSK <name> <core> <prio> <stack_free> <cpu_permille>"
+int formatTask(const Task& t, char* out, size_t len);
+
+} // namespace SysStats
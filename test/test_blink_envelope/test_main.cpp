@@ -0,0 +1,63 @@
+// Host tests for the blink envelope: the default easing must keep the brightness
+// blinks had before the envelope, when each frame was CHSV(hue, 255, bri).
+//   Run with: pio test -e native_test -f test_blink_envelope
+#include <unity.h>
+#include "blink_envelope.h"
+
+static uint8_t __envelope[BLINK_ENVELOPE_SIZE];
+
+// Arduino's map(), as the old blink code used it.
+static long arduinoMap(long x, long inMin, long inMax, long outMin, long outMax) {
+    return (x - inMin) * (outMax - outMin) / (inMax - inMin) + outMin;
+}
+
+// The level the old per-frame CHSV path dimmed the full colour to: hsv2rgb_rainbow
+// scales by scale8_video(val, val).
+static uint8_t oldLevel(uint8_t maxBri, unsigned long up, unsigned long down, unsigned long cyclePos) {
+    long bri = (cyclePos < up) ? arduinoMap(cyclePos, 0, up, 0, maxBri)
+                               : arduinoMap(cyclePos - up, 0, down, maxBri, 0);
+    return (uint8_t)(((bri * bri) >> 8) + (bri ? 1 : 0));
+}
+
+void setUp() {}
+void tearDown() {}
+
+// The funky script's led_blink:0,70,200,400,10.
+void test_quadratic_matches_old_output_at_70_percent() {
+    const uint8_t maxBri = (uint8_t)(70 * 255 / 100);
+    const unsigned long up = 200, down = 400;
+    BlinkEnvelope::build(__envelope, BLINK_EASE_QUADRATIC, maxBri);
+    TEST_ASSERT_EQUAL(oldLevel(maxBri, up, down, up), BlinkEnvelope::level(__envelope, maxBri, up, down, up));
+    TEST_ASSERT_EQUAL(124, BlinkEnvelope::level(__envelope, maxBri, up, down, up));
+    for (unsigned long t = 0; t < up + down; t++) {
+        TEST_ASSERT_EQUAL(oldLevel(maxBri, up, down, t), BlinkEnvelope::level(__envelope, maxBri, up, down, t));
+    }
+}
+
+void test_quadratic_matches_old_output_at_full_brightness() {
+    const uint8_t maxBri = 255;
+    const unsigned long up = 1000, down = 1000;
+    BlinkEnvelope::build(__envelope, BLINK_EASE_QUADRATIC, maxBri);
+    for (unsigned long t = 0; t < up + down; t++) {
+        TEST_ASSERT_EQUAL(oldLevel(maxBri, up, down, t), BlinkEnvelope::level(__envelope, maxBri, up, down, t));
+    }
+}
+
+void test_linear_and_gamma_reach_the_peak() {
+    const uint8_t maxBri = 178;
+    BlinkEnvelope::build(__envelope, BLINK_EASE_LINEAR, maxBri);
+    TEST_ASSERT_EQUAL(0, __envelope[0]);
+    TEST_ASSERT_EQUAL(maxBri, __envelope[maxBri]);
+    TEST_ASSERT_EQUAL(maxBri / 2, BlinkEnvelope::level(__envelope, maxBri, 100, 100, 50));
+    BlinkEnvelope::build(__envelope, BLINK_EASE_GAMMA, maxBri);
+    TEST_ASSERT_EQUAL(maxBri, __envelope[maxBri]);
+    TEST_ASSERT_LESS_OR_EQUAL(maxBri / 4, BlinkEnvelope::level(__envelope, maxBri, 100, 100, 50));
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_quadratic_matches_old_output_at_70_percent);
+    RUN_TEST(test_quadratic_matches_old_output_at_full_brightness);
+    RUN_TEST(test_linear_and_gamma_reach_the_peak);
+    return UNITY_END();
+}
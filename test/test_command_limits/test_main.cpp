@@ -0,0 +1,49 @@
+// Host tests for CommandLimits: the checks processCommand() makes on parsed fields hold
+// for any int atoi() can return.
+//   Run with: pio test -e native_test -f test_command_limits
+#include <limits.h>
+#include <unity.h>
+#include "command_limits.h"
+#include "sculpture_config.h"
+
+using namespace CommandLimits;
+
+static const int __STRIP = Sculpture::LOGICAL_NUM_LEDS;
+
+void setUp() {}
+void tearDown() {}
+
+void test_comets_fit_within_cover() {
+    int most = __STRIP * COMET_COVER_PERCENT / 100;
+    TEST_ASSERT_TRUE(cometsFit(1, most, __STRIP));
+    TEST_ASSERT_FALSE(cometsFit(1, most + 1, __STRIP));
+    TEST_ASSERT_TRUE(cometsFit(3, 10, __STRIP));
+    TEST_ASSERT_TRUE(cometsFit(0, 10000, __STRIP)); // Comets off
+    TEST_ASSERT_TRUE(cometsFit(-5, 10000, __STRIP));
+    TEST_ASSERT_TRUE(cometsFit(most, 0, __STRIP));  // A tail below 1 counts as 1
+    TEST_ASSERT_FALSE(cometsFit(most + 1, -7, __STRIP));
+}
+
+void test_huge_fields_are_rejected_not_overflowed() {
+    // led_comet_group:1,20000000,255,0,100,1 once overflowed count * tail.
+    TEST_ASSERT_FALSE(cometsFit(20000000, 255, __STRIP));
+    TEST_ASSERT_FALSE(cometsFit(INT_MAX, INT_MAX, __STRIP));
+    TEST_ASSERT_FALSE(cometsFit(1, INT_MAX, __STRIP));
+    TEST_ASSERT_TRUE(cometsFit(INT_MIN, INT_MAX, __STRIP));
+}
+
+void test_seek_ms_saturates() {
+    TEST_ASSERT_EQUAL(0, seekMs(-1));
+    TEST_ASSERT_EQUAL(0, seekMs(INT_MIN));
+    TEST_ASSERT_EQUAL(120000, seekMs(120));
+    TEST_ASSERT_EQUAL(UINT32_MAX, seekMs(INT_MAX));
+    TEST_ASSERT_EQUAL(UINT32_MAX, seekMs(4294968)); // Would wrap to 704 ms in 32 bits
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_comets_fit_within_cover);
+    RUN_TEST(test_huge_fields_are_rejected_not_overflowed);
+    RUN_TEST(test_seek_ms_saturates);
+    return UNITY_END();
+}
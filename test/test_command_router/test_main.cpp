@@ -0,0 +1,137 @@
+// Host tests for CommandRouter: parameter overrides during a script, and the order
+// coalesced slider values apply in.
+//   Run with: pio test -e native_test -f test_command_router
+#include <string.h>
+#include <unity.h>
+#include "command_router.h"
+
+using namespace CommandRouter;
+
+// What runScriptCommand() in main.cpp decides for a script step.
+static bool scriptStepRuns(const char* cmd) {
+    return !isOverridden(paramKey(cmd));
+}
+
+// The BLE commands loop() applies, in order, as they would reach routeBleCommand().
+static char __applied[8][MAX_DEFERRED_LEN + 1];
+static int __appliedCount = 0;
+static uint32_t __nowMs = 10000;
+
+static void apply(const char* cmd) {
+    if (__appliedCount < 8) strcpy(__applied[__appliedCount++], cmd);
+}
+
+// One command through loop()'s coalescing path, as in main.cpp.
+static void receive(const char* cmd) {
+    CommandTag tag = { -1, 0 };
+    CommandTag replaced;
+    ParamKey key = coalesceKey(cmd);
+    if (key != PARAM_NONE && !offerCoalesced(key, cmd, tag, __nowMs, &replaced)) return;
+    if (stopsScript(cmd)) discardStaged(nullptr);
+    char staged[MAX_DEFERRED_LEN + 1];
+    while (takeStagedBefore(cmd, __nowMs, staged, nullptr)) apply(staged);
+    apply(cmd);
+}
+
+static void servicePass() {
+    char staged[MAX_DEFERRED_LEN + 1];
+    while (takeDueCoalesced(__nowMs, staged, nullptr)) apply(staged);
+}
+
+void setUp() {
+    clearOverrides();
+    discardStaged(nullptr);
+    __appliedCount = 0;
+    __nowMs += 1000; // Well past any earlier test's coalescing interval
+}
+
+void tearDown() {}
+
+void test_override_shadows_script_until_scene_boundary() {
+    TEST_ASSERT_TRUE(scriptStepRuns("motor_speed:400"));
+
+    // The user drags the speed slider (or sends motor_speed:0) mid-scene.
+    TEST_ASSERT_EQUAL(LANE_PARAM, classify("motor_speed:0"));
+    setOverride(paramKey("motor_speed:0"));
+    TEST_ASSERT_FALSE(scriptStepRuns("motor_speed:400"));
+    TEST_ASSERT_FALSE(scriptStepRuns("motor_speed_up"));
+    TEST_ASSERT_TRUE(scriptStepRuns("led_display_brightness:80"));
+
+    // The next phase marker hands the parameter back.
+    TEST_ASSERT_EQUAL_UINT32(1u << PARAM_MOTOR_SPEED, expireOverrides());
+    TEST_ASSERT_TRUE(scriptStepRuns("motor_speed:400"));
+    TEST_ASSERT_EQUAL_UINT32(0, overrideMask());
+}
+
+void test_every_override_expires_at_once() {
+    setOverride(PARAM_GLOBAL_BRIGHTNESS);
+    setOverride(PARAM_BACKGROUND);
+    uint32_t expired = expireOverrides();
+    TEST_ASSERT_EQUAL_UINT32((1u << PARAM_GLOBAL_BRIGHTNESS) | (1u << PARAM_BACKGROUND), expired);
+    TEST_ASSERT_TRUE(scriptStepRuns("led_global_brightness:50"));
+    TEST_ASSERT_TRUE(scriptStepRuns("led_background:160,20"));
+    // Nothing left to expire at the following boundary.
+    TEST_ASSERT_EQUAL_UINT32(0, expireOverrides());
+}
+
+void test_staged_value_applies_before_a_later_command() {
+    receive("motor_speed:300");
+    __nowMs += 10;
+    receive("motor_speed:500"); // Inside the interval: staged
+    TEST_ASSERT_EQUAL(1, __appliedCount);
+    __nowMs += 5;
+    receive("motor_reverse");
+    TEST_ASSERT_EQUAL(3, __appliedCount);
+    TEST_ASSERT_EQUAL_STRING("motor_speed:500", __applied[1]);
+    TEST_ASSERT_EQUAL_STRING("motor_reverse", __applied[2]);
+    // Nothing is left to apply after the reverse.
+    __nowMs += COALESCE_INTERVAL_MS;
+    servicePass();
+    TEST_ASSERT_EQUAL(3, __appliedCount);
+}
+
+void test_staged_values_apply_oldest_first() {
+    receive("led_background:160,20");
+    receive("led_display_brightness:40");
+    __nowMs += 5;
+    receive("led_display_brightness:60");
+    receive("led_background:0,10");
+    receive("led_reset");
+    TEST_ASSERT_EQUAL(5, __appliedCount);
+    TEST_ASSERT_EQUAL_STRING("led_display_brightness:60", __applied[2]);
+    TEST_ASSERT_EQUAL_STRING("led_background:0,10", __applied[3]);
+    TEST_ASSERT_EQUAL_STRING("led_reset", __applied[4]);
+}
+
+void test_coalesced_commands_do_not_flush_each_other() {
+    receive("motor_speed:300");
+    __nowMs += 5;
+    receive("motor_speed:400");
+    receive("led_global_brightness:50"); // Another key: applies at once, leaves the speed staged
+    TEST_ASSERT_EQUAL(2, __appliedCount);
+    TEST_ASSERT_EQUAL_STRING("led_global_brightness:50", __applied[1]);
+    __nowMs += COALESCE_INTERVAL_MS;
+    servicePass();
+    TEST_ASSERT_EQUAL(3, __appliedCount);
+    TEST_ASSERT_EQUAL_STRING("motor_speed:400", __applied[2]);
+}
+
+void test_show_control_discards_staged_values() {
+    receive("motor_speed:300");
+    __nowMs += 5;
+    receive("motor_speed:600");
+    receive("motor_stop");
+    TEST_ASSERT_EQUAL(2, __appliedCount);
+    TEST_ASSERT_EQUAL_STRING("motor_stop", __applied[1]);
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_override_shadows_script_until_scene_boundary);
+    RUN_TEST(test_every_override_expires_at_once);
+    RUN_TEST(test_staged_value_applies_before_a_later_command);
+    RUN_TEST(test_staged_values_apply_oldest_first);
+    RUN_TEST(test_coalesced_commands_do_not_flush_each_other);
+    RUN_TEST(test_show_control_discards_staged_values);
+    return UNITY_END();
+}
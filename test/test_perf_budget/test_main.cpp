@@ -0,0 +1,454 @@
+// Host latency budgets for the hot paths that build without hardware, run by the
+// native_perf env. Each case times one path, keeps the best of several runs, and fails
+// if the cost is over the case's fixed budget, or more than PERF_MARGIN_PERCENT
+// (default 50) over the cost in the baseline file. Baseline costs are kept relative to
+// a calibration loop timed in the same run, so one baseline holds across hosts of
+// different speed. There is one test per family of cases, so a failure names it:
+//   parse      command parsing per family (what processCommand() and the router do
+//              before acting: sequence strip, split, field parse, coalesce key, lane)
+//   power      ns per pixel of the per-frame power limiting pass
+//   motor      the motor ramp tick's speed mapping
+//   particles  a particle frame at 10, 100 and 1000 particles (ns per particle)
+//   script     ScriptTimeline indexing and seeking
+//   compose    auto_mode and auto_steady_rotate generation per show minute
+//   render     ns per pixel of StripRender's noise, heat, comet and marquee stages
+// What only runs on the device, and how it is timed there, is listed at processCommand()
+// in main.cpp.
+//
+// Budgets are about ten times a desktop's cost, to catch an order of magnitude; the
+// baseline catches smaller slowdowns. perf_baseline.txt beside this file is committed.
+// Without a baseline file, a run checks the budgets only and records one from its
+// results if they all pass, so later runs are checked against it. Re-record after an
+// intended change to a hot path, and commit the file with it.
+//   Check with:  pio test -e native_perf
+//   Record with: PERF_RECORD=1 pio test -e native_perf
+//   Options:     PERF_MARGIN_PERCENT=N, PERF_BASELINE=FILE
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unity.h>
+#include "command_parser.h"
+#include "command_router.h"
+#include "phase_templates.h"
+#include "power_budget.h"
+#include "script_buffer.h"
+#include "particle_system.h"
+#include "script_timeline.h"
+#include "sculpture_config.h"
+#include "steady_rotate.h"
+#include "strip_render.h"
+
+static const int __RUNS = 9;
+static const uint32_t __SIM_RAMP_MS = 4000; // DEFAULT_RAMP_DURATION_MS
+static const char* const __BASELINE_FILE = "perf_baseline.txt";
+
+static volatile long __sink;
+static ScriptBuffer __script;
+
+static long simRandom(long low, long highExclusive) {
+    return (highExclusive <= low) ? low : low + rand() % (highExclusive - low);
+}
+
+static long simRevTimeMs(int speed) {
+    return calculateRevTimeMs<Sculpture>(speed);
+}
+
+static double nowNs() {
+    return (double)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// --- Cases ---
+// Each returns the cost of one run, in the case's unit.
+
+static const int __PARSE_REPEATS = 20000;
+
+static double parseCommands(const char* const* commands, int count) {
+    char name[CommandParser::MAX_NAME_LEN + 1];
+    int values[8];
+    double start = nowNs();
+    for (int r = 0; r < __PARSE_REPEATS; r++) {
+        for (int i = 0; i < count; i++) {
+            int32_t seq;
+            const char* cmd = CommandParser::stripSequence(commands[i], &seq);
+            const char* params = nullptr;
+            if (CommandParser::split(cmd, name, &params) && params) {
+                __sink += CommandParser::parseInts(params, values, 8) + values[0];
+            }
+            __sink += CommandRouter::coalesceKey(cmd) + CommandRouter::classify(cmd);
+        }
+    }
+    return (nowNs() - start) / ((double)__PARSE_REPEATS * count);
+}
+
+static const char* const __motorCommands[] = { "motor_speed:650", "motor_ramp:4000", "motor_start", "motor_reverse", "motor_speed_up" };
+static const char* const __effectCommands[] = { "led_effect:noise", "led_effect:fire", "led_effect:marquee,4,12", "led_rainbow", "led_reset" };
+static const char* const __paramCommands[] = { "led_background:160,20", "led_tails:0,15,3", "led_blink:40,80,300,600,4", "led_sine_hue:20,200", "led_display_brightness:60" };
+static const char* const __scriptCommands[] = { "hold:4000", "script_seek:120", "script_pause", "[---------- BUILD ----------]", "auto_mode:30" };
+static const char* const __sequencedCommands[] = { "#17 motor_speed:650", "#18 led_effect:noise", "#19 led_tails:0,15,3", "#20 hold:4000", "#21 script_next" };
+
+#define PARSE_CASE(name, commands) \
+    static double name() { return parseCommands(commands, sizeof(commands) / sizeof(commands[0])); }
+PARSE_CASE(parseMotor, __motorCommands)
+PARSE_CASE(parseEffect, __effectCommands)
+PARSE_CASE(parseParam, __paramCommands)
+PARSE_CASE(parseScript, __scriptCommands)
+PARSE_CASE(parseSequenced, __sequencedCommands)
+
+static uint8_t __frame[Sculpture::NUM_LEDS * 3];
+
+static double powerLimitPerPixel() {
+    const int frames = 20000;
+    uint32_t ms = 0;
+    double start = nowNs();
+    for (int f = 0; f < frames; f++) {
+        __frame[(f * 7) % sizeof(__frame)] ^= 0x5a;
+        __sink += PowerBudget::limitFrame(__frame, Sculpture::NUM_LEDS, 255, "noise", ms);
+        ms += 16;
+    }
+    return (nowNs() - start) / ((double)frames * Sculpture::NUM_LEDS);
+}
+
+static double rampTick() {
+    const int ticks = 2000000;
+    double start = nowNs();
+    for (int i = 0; i < ticks; i++) {
+        int speed = i % (LOGICAL_MAX_SPEED + 1);
+        __sink += mapSpeedToDuty<Sculpture>(speed) + calculateRevTimeMs<Sculpture>(speed);
+    }
+    return (nowNs() - start) / ticks;
+}
+
+static uint8_t __hueRgb[256][3];
+static uint8_t __strip[Sculpture::NUM_LEDS * 3];
+
+// One particle frame, update and render, per live particle.
+static double particleFrame(int count) {
+    const int frames = 200;
+    ParticleSystem::reset();
+    ParticleSystem::burst(Sculpture::LOGICAL_NUM_LEDS / 2, count, 60, 0, 60000);
+    ParticleSystem::setGravity(-5);
+    double start = nowNs();
+    for (int f = 0; f < frames; f++) {
+        ParticleSystem::update(16);
+        ParticleSystem::render(__strip, __hueRgb);
+    }
+    return (nowNs() - start) / ((double)frames * count);
+}
+
+static double particles10() { return particleFrame(10); }
+static double particles100() { return particleFrame(100); }
+static double particles1000() { return particleFrame(1000); }
+
+static void composeShow(int minutes) {
+    PhaseTemplates::Context context = { simRandom, simRevTimeMs, __SIM_RAMP_MS, nullptr };
+    PhaseTemplates::Composition plan;
+    srand(1);
+    PhaseTemplates::compose(minutes * 60000L, SCRIPT_MAX_LINES, context, __script, &plan);
+}
+
+static double composePerMinute() {
+    const int minutes = 60, shows = 20;
+    double start = nowNs();
+    for (int i = 0; i < shows; i++) composeShow(minutes);
+    return (nowNs() - start) / 1000.0 / ((double)minutes * shows);
+}
+
+static double scriptIndexPerStep() {
+    const int builds = 20;
+    composeShow(60);
+    double start = nowNs();
+    for (int i = 0; i < builds; i++) ScriptTimeline::build(__script, __SIM_RAMP_MS);
+    return (nowNs() - start) / ((double)__script.size() * builds);
+}
+
+static double scriptSeek() {
+    composeShow(60);
+    ScriptTimeline::build(__script, __SIM_RAMP_MS);
+    const int seeks = 2000;
+    uint32_t total = ScriptTimeline::totalMs();
+    ScriptTimeline::RestorePlan plan;
+    double start = nowNs();
+    for (int i = 0; i < seeks; i++) {
+        uint32_t remaining;
+        int step = ScriptTimeline::stepForTime((uint32_t)((uint64_t)total * i / seeks), &remaining);
+        ScriptTimeline::planRestore(__script, 0, step, remaining, &plan);
+        __sink += plan.count;
+    }
+    return (nowNs() - start) / seeks;
+}
+
+static double composeSteadyPerMinute() {
+    const int minutes = 60, shows = 20;
+    PhaseTemplates::Context context = { simRandom, simRevTimeMs, __SIM_RAMP_MS, nullptr };
+    srand(1);
+    double start = nowNs();
+    for (int i = 0; i < shows; i++) SteadyRotate::compose(minutes * 60000L, SCRIPT_MAX_LINES, context, __script);
+    return (nowNs() - start) / 1000.0 / ((double)minutes * shows);
+}
+
+// Render stages: one strip-length frame at a time, moving between frames as the
+// effects do, in ns per pixel.
+static const int __RENDER_FRAMES = 2000;
+static uint8_t __heatRgb[256][3];
+static uint8_t __heat[Sculpture::NUM_LEDS];
+static uint8_t __cometLevels[Sculpture::LOGICAL_NUM_LEDS];
+
+// inoise8() is FastLED's and not built here. A cheap hash stands in, so the noise case
+// times the stage around it (palette lookup and pixel writes), not the noise itself.
+static uint8_t hashNoise(uint16_t x, uint16_t y, uint16_t z) {
+    uint32_t h = ((uint32_t)x * 2654435761u) ^ ((uint32_t)y * 40503u) ^ z;
+    return (uint8_t)(h >> 24);
+}
+
+static double renderNoise() {
+    StripRender::NoiseJob job = { __strip, __hueRgb, 1000, 2000, 0, 30 };
+    double start = nowNs();
+    for (int f = 0; f < __RENDER_FRAMES; f++) {
+        job.z += 10;
+        StripRender::renderNoiseRange<hashNoise>(0, Sculpture::NUM_LEDS, &job);
+    }
+    __sink += __strip[0];
+    return (nowNs() - start) / ((double)__RENDER_FRAMES * Sculpture::NUM_LEDS);
+}
+
+static double renderHeat() {
+    StripRender::HeatJob job = { __strip, __heat, __heatRgb };
+    double start = nowNs();
+    for (int f = 0; f < __RENDER_FRAMES; f++) {
+        __heat[f % Sculpture::NUM_LEDS] += 37;
+        StripRender::renderHeatRange(0, Sculpture::NUM_LEDS, &job);
+    }
+    __sink += __strip[0];
+    return (nowNs() - start) / ((double)__RENDER_FRAMES * Sculpture::NUM_LEDS);
+}
+
+// Three comets with 10-LED tails, as system_reset leaves them, as render_bench draws them.
+static double renderComets() {
+    StripRender::CometJob job;
+    job.rgb = __strip;
+    job.background[0] = 20;
+    job.background[1] = 10;
+    job.background[2] = 5;
+    job.logicalLength = Sculpture::LOGICAL_NUM_LEDS;
+    job.drawCount = 1;
+    job.draws[0] = { { 255, 0, 0 }, 0, -1, 3, Sculpture::LOGICAL_NUM_LEDS / 3, __cometLevels,
+                     StripRender::fillCometTailLevels(__cometLevels, Sculpture::LOGICAL_NUM_LEDS, 10) };
+    double start = nowNs();
+    for (int f = 0; f < __RENDER_FRAMES; f++) {
+        job.draws[0].head = f % Sculpture::LOGICAL_NUM_LEDS;
+        StripRender::renderCometRange(0, Sculpture::NUM_LEDS, &job);
+    }
+    __sink += __strip[0];
+    return (nowNs() - start) / ((double)__RENDER_FRAMES * Sculpture::NUM_LEDS);
+}
+
+static double renderMarquee() {
+    StripRender::MarqueeJob job = { __strip, { 255, 0, 0 }, 0, 4, 12 };
+    double start = nowNs();
+    for (int f = 0; f < __RENDER_FRAMES; f++) {
+        job.offset = (uint8_t)(f % job.totalWidth);
+        StripRender::renderMarqueeRange(0, Sculpture::NUM_LEDS, &job);
+    }
+    __sink += __strip[0];
+    return (nowNs() - start) / ((double)__RENDER_FRAMES * Sculpture::NUM_LEDS);
+}
+
+struct Case {
+    const char* family;
+    const char* name;
+    const char* unit;
+    double budget;
+    double (*run)();
+};
+
+static const Case __cases[] = {
+    { "parse",     "parse_motor",      "ns/cmd",   2000, parseMotor },
+    { "parse",     "parse_effect",     "ns/cmd",   2000, parseEffect },
+    { "parse",     "parse_param",      "ns/cmd",   2000, parseParam },
+    { "parse",     "parse_script",     "ns/cmd",   2000, parseScript },
+    { "parse",     "parse_sequenced",  "ns/cmd",   2000, parseSequenced },
+    { "power",     "power_limit",      "ns/pixel", 20, powerLimitPerPixel },
+    { "motor",     "ramp_tick",        "ns/tick",  100, rampTick },
+    { "particles", "particles_10",     "ns/part",  200, particles10 },
+    { "particles", "particles_100",    "ns/part",  100, particles100 },
+    { "particles", "particles_1000",   "ns/part",  100, particles1000 },
+    { "script",    "script_index",     "ns/step",  2000, scriptIndexPerStep },
+    { "script",    "script_seek",      "ns/seek",  50000, scriptSeek },
+    { "compose",   "compose",          "us/min",   200, composePerMinute },
+    { "compose",   "compose_steady",   "us/min",   25, composeSteadyPerMinute },
+    { "render",    "render_noise",     "ns/pixel", 15, renderNoise },
+    { "render",    "render_heat",      "ns/pixel", 15, renderHeat },
+    { "render",    "render_comets",    "ns/pixel", 50, renderComets },
+    { "render",    "render_marquee",   "ns/pixel", 25, renderMarquee },
+};
+static const int __CASE_COUNT = sizeof(__cases) / sizeof(__cases[0]);
+
+// A fixed workload of the same kind (byte loads, compares, integer maths), timed around
+// every run of every case. Baselines hold each case's cost relative to it, so a host
+// that runs faster or slower as a whole, as shared and throttled machines do, does not
+// read as a regression.
+static double calibrate() {
+    static const char text[] = "led_background:160,20 motor_speed:650 led_tails:0,15,3 hold:4000";
+    const int repeats = 50000;
+    double start = nowNs();
+    uint32_t hash = 2166136261u;
+    for (int r = 0; r < repeats; r++) {
+        for (const char* p = text; *p; p++) hash = (hash ^ (uint8_t)*p) * 16777619u;
+        __sink += strncmp(text + (r & 15), "motor", 5);
+    }
+    __sink += hash;
+    return (nowNs() - start) / repeats;
+}
+
+// --- Baseline file: one "name relative_cost" line per case ---
+
+static double __baseline[__CASE_COUNT];
+static double __relative[__CASE_COUNT]; // This run's, for recording
+static char __baselinePath[256];
+static bool __record;
+static bool __haveBaseline;
+static int __marginPercent;
+static int __failures;
+
+static bool loadBaseline(const char* path) {
+    for (int i = 0; i < __CASE_COUNT; i++) __baseline[i] = 0;
+    FILE* f = fopen(path, "r");
+    if (f == nullptr) return false;
+    char name[32];
+    double value;
+    while (fscanf(f, "%31s %lf", name, &value) == 2) {
+        for (int i = 0; i < __CASE_COUNT; i++) {
+            if (strcmp(name, __cases[i].name) == 0) __baseline[i] = value;
+        }
+    }
+    fclose(f);
+    return true;
+}
+
+static bool saveBaseline(const char* path, const double* relative) {
+    FILE* f = fopen(path, "w");
+    if (f == nullptr) return false;
+    for (int i = 0; i < __CASE_COUNT; i++) fprintf(f, "%s %.6f\n", __cases[i].name, relative[i]);
+    fclose(f);
+    return true;
+}
+
+static const char* envOr(const char* name, const char* fallback) {
+    const char* value = getenv(name);
+    return (value && value[0]) ? value : fallback;
+}
+
+// The committed baseline beside this file, unless PERF_BASELINE names another.
+static void resolveBaselinePath() {
+    const char* path = getenv("PERF_BASELINE");
+    if (path && path[0]) {
+        snprintf(__baselinePath, sizeof(__baselinePath), "%s", path);
+        return;
+    }
+    const char* slash = strrchr(__FILE__, '/');
+    int dirLength = slash ? (int)(slash - __FILE__) + 1 : 0;
+    snprintf(__baselinePath, sizeof(__baselinePath), "%.*s%s", dirLength, __FILE__, __BASELINE_FILE);
+}
+
+static void prepare() {
+    int errorLine = 0;
+    PhaseTemplates::load(PhaseTemplates::BUILTIN_TEMPLATES, &errorLine);
+    PowerBudget::configure(500, Sculpture::NUM_LEDS);
+    ParticleSystem::configure(Sculpture::LOGICAL_NUM_LEDS, Sculpture::NUM_LEDS);
+    for (int h = 0; h < 256; h++) {
+        __hueRgb[h][0] = (uint8_t)(255 - h);
+        __hueRgb[h][1] = (uint8_t)h;
+        __hueRgb[h][2] = (uint8_t)(h * 2);
+        __heatRgb[h][0] = (uint8_t)(h < 85 ? h * 3 : 255);
+        __heatRgb[h][1] = (uint8_t)(h < 85 ? 0 : h < 170 ? (h - 85) * 3 : 255);
+        __heatRgb[h][2] = (uint8_t)(h < 170 ? 0 : (h - 170) * 3);
+    }
+    for (size_t i = 0; i < sizeof(__frame); i++) __frame[i] = (uint8_t)(i * 37);
+    for (int i = 0; i < Sculpture::NUM_LEDS; i++) __heat[i] = (uint8_t)(i * 7); // Every HeatColor() band
+}
+
+// Times every case of `family` and checks it against its budget and the baseline.
+// Returns the number of cases that failed.
+static int checkFamily(const char* family) {
+    int cases[__CASE_COUNT];
+    int count = 0;
+    for (int i = 0; i < __CASE_COUNT; i++) {
+        if (strcmp(__cases[i].family, family) == 0) cases[count++] = i;
+    }
+
+    // Best of __RUNS, both in absolute terms (for the budgets) and relative to the
+    // calibration around each run (for the baseline). Runs are interleaved, so a slow
+    // spell costs one run of every case rather than every run of one.
+    double measured[__CASE_COUNT], relative[__CASE_COUNT];
+    double calibration = 0;
+    for (int r = 0; r < __RUNS; r++) {
+        for (int n = 0; n < count; n++) {
+            double before = calibrate();
+            double cost = __cases[cases[n]].run();
+            double around = (before + calibrate()) / 2;
+            if (r == 0 || cost < measured[n]) measured[n] = cost;
+            if (r == 0 || cost / around < relative[n]) relative[n] = cost / around;
+            if ((r == 0 && n == 0) || around < calibration) calibration = around;
+        }
+    }
+
+    int failures = 0;
+    for (int n = 0; n < count; n++) {
+        int i = cases[n];
+        const Case& c = __cases[i];
+        __relative[i] = relative[n];
+        // The baseline as it would read on this host at its best speed in this run.
+        double expected = __baseline[i] * calibration;
+        const char* verdict = "ok";
+        if (measured[n] > c.budget) {
+            verdict = "OVER BUDGET";
+        } else if (!__record && __baseline[i] > 0 && relative[n] > __baseline[i] * (100 + __marginPercent) / 100.0) {
+            verdict = "REGRESSED";
+        }
+        if (strcmp(verdict, "ok") != 0) failures++;
+        printf("%-16s %10.2f %10.0f %10.2f %-8s %s\n", c.name, measured[n], c.budget, expected, c.unit, verdict);
+    }
+    __failures += failures;
+    return failures;
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_parse(void) { TEST_ASSERT_EQUAL(0, checkFamily("parse")); }
+void test_power(void) { TEST_ASSERT_EQUAL(0, checkFamily("power")); }
+void test_motor(void) { TEST_ASSERT_EQUAL(0, checkFamily("motor")); }
+void test_particles(void) { TEST_ASSERT_EQUAL(0, checkFamily("particles")); }
+void test_script(void) { TEST_ASSERT_EQUAL(0, checkFamily("script")); }
+void test_compose(void) { TEST_ASSERT_EQUAL(0, checkFamily("compose")); }
+void test_render(void) { TEST_ASSERT_EQUAL(0, checkFamily("render")); }
+
+int main(int argc, char** argv) {
+    __record = atoi(envOr("PERF_RECORD", "0")) != 0;
+    __marginPercent = atoi(envOr("PERF_MARGIN_PERCENT", "50"));
+    resolveBaselinePath();
+    __haveBaseline = !__record && loadBaseline(__baselinePath);
+    prepare();
+
+    printf("%-16s %10s %10s %10s %-8s\n", "case", "best", "budget", "baseline", "unit");
+    UNITY_BEGIN();
+    RUN_TEST(test_parse);
+    RUN_TEST(test_power);
+    RUN_TEST(test_motor);
+    RUN_TEST(test_particles);
+    RUN_TEST(test_script);
+    RUN_TEST(test_compose);
+    RUN_TEST(test_render);
+
+    if (__record || (!__haveBaseline && __failures == 0)) {
+        if (saveBaseline(__baselinePath, __relative)) printf("Baseline recorded in %s\n", __baselinePath);
+        else printf("Could not write the baseline to %s\n", __baselinePath);
+    } else if (!__haveBaseline) {
+        printf("No baseline in %s, and a case failed its budget, so none was recorded.\n", __baselinePath);
+    } else {
+        printf("Checked against %s (margin %d%% over baseline)\n", __baselinePath, __marginPercent);
+    }
+    return UNITY_END();
+}
@@ -0,0 +1,83 @@
+// Host tests for auto_mode composition: shows run their requested length.
+//   Run with: pio test -e native_test -f test_phase_templates
+#include <stdlib.h>
+#include <unity.h>
+#include "phase_templates.h"
+#include "sculpture_config.h"
+#include "script_timeline.h"
+
+static const uint32_t __RAMP_MS = 4000; // DEFAULT_RAMP_DURATION_MS
+static ScriptBuffer __script;
+
+static long testRandom(long low, long highExclusive) {
+    return (highExclusive <= low) ? low : low + rand() % (highExclusive - low);
+}
+
+static long testRevTimeMs(int speed) {
+    return calculateRevTimeMs<Sculpture>(speed);
+}
+
+// Composes `minutes` with each of several seeds and checks the fit.
+static void checkFit(int minutes) {
+    PhaseTemplates::Context context = { testRandom, testRevTimeMs, __RAMP_MS, nullptr };
+    const long totalMs = minutes * 60000L;
+    for (int seed = 1; seed <= 8; seed++) {
+        srand(seed);
+        PhaseTemplates::Composition plan;
+        PhaseTemplates::compose(totalMs, SCRIPT_MAX_LINES, context, __script, &plan);
+        TEST_ASSERT_FALSE(plan.fitFailed);
+        TEST_ASSERT_EQUAL(0, __script.dropped());
+        TEST_ASSERT_INT_WITHIN(PhaseTemplates::FIT_TOLERANCE_MS, totalMs, plan.fittedMs);
+        // The rewritten script itself predicts what the plan says.
+        TEST_ASSERT_EQUAL(plan.fittedMs, (long)ScriptTimeline::plannedMs(__script, __RAMP_MS, nullptr));
+    }
+}
+
+void setUp() {
+    int errorLine = 0;
+    PhaseTemplates::load(PhaseTemplates::BUILTIN_TEMPLATES, &errorLine);
+}
+
+void tearDown() {}
+
+void test_fit_within_tolerance_at_30_min() {
+    checkFit(30);
+}
+
+// 240 minutes runs out of lines long before the time is composed, so the holds have to
+// stretch past 2x.
+void test_fit_within_tolerance_at_240_min() {
+    checkFit(240);
+    PhaseTemplates::Composition plan;
+    PhaseTemplates::Context context = { testRandom, testRevTimeMs, __RAMP_MS, nullptr };
+    srand(1);
+    PhaseTemplates::compose(240 * 60000L, SCRIPT_MAX_LINES, context, __script, &plan);
+    TEST_ASSERT_TRUE(plan.lineLimited);
+    TEST_ASSERT_GREATER_THAN(200, plan.holdScalePercent);
+}
+
+void test_scaled_prediction_matches_rewritten_holds() {
+    __script.clear();
+    __script.push("motor_speed:300");
+    __script.push("hold:999");
+    __script.push("led_blink:0,70,200,400,2");
+    __script.push("hold:1");
+    __script.push("hold:0");
+    __script.push("hold:5001");
+    ScriptTimeline::HoldScaler scaler(3, 2);
+    uint32_t holdMs = 0;
+    uint32_t scaled = ScriptTimeline::plannedMs(__script, __RAMP_MS, scaler, &holdMs);
+    TEST_ASSERT_EQUAL(9001, holdMs); // (999 + 1 + 5001) * 3 / 2, rounding carried
+    __script.replace(1, "hold:1498");
+    __script.replace(3, "hold:2");
+    __script.replace(5, "hold:7501");
+    TEST_ASSERT_EQUAL(scaled, ScriptTimeline::plannedMs(__script, __RAMP_MS, nullptr));
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_fit_within_tolerance_at_30_min);
+    RUN_TEST(test_fit_within_tolerance_at_240_min);
+    RUN_TEST(test_scaled_prediction_matches_rewritten_holds);
+    return UNITY_END();
+}
@@ -0,0 +1,124 @@
+// Host tests for ScriptTimeline::planRestore(): a finite blink that has ended is not
+// replayed, and a backward seek puts state no earlier step wrote back to its default.
+//   Run with: pio test -e native_test -f test_script_timeline
+#include <string.h>
+#include <unity.h>
+#include "script_timeline.h"
+
+using namespace ScriptTimeline;
+
+static ScriptBuffer __script;
+
+static void load(const char* const* lines, int count) {
+    __script.clear();
+    for (int i = 0; i < count; i++) __script.push(lines[i]);
+    build(__script, 4000);
+}
+
+static bool replays(const RestorePlan& plan, int step) {
+    for (int i = 0; i < plan.count; i++) {
+        if (plan.steps[i] == step) return true;
+    }
+    return false;
+}
+
+static bool resets(const RestorePlan& plan, const char* cmd) {
+    for (int i = 0; i < plan.defaultCount; i++) {
+        if (strcmp(plan.defaults[i], cmd) == 0) return true;
+    }
+    return false;
+}
+
+void setUp() {}
+void tearDown() {}
+
+static const char* const __blinkScript[] = {
+    "led_tails:0,10,3",          // 0
+    "led_blink:0,255,500,500,3", // 1: ends 3 s after it starts
+    "hold:1000",                 // 2: waits for the blink, at 3 s
+    "led_background:20,10",      // 3
+    "hold:5000",                 // 4
+    "led_display_brightness:50", // 5
+};
+
+void test_finished_blink_is_not_replayed(void) {
+    load(__blinkScript, 6);
+    TEST_ASSERT_EQUAL(3000, stepStartMs(2));
+    RestorePlan plan;
+    planRestore(__script, 0, 5, 0, &plan);
+    TEST_ASSERT_FALSE(replays(plan, 1));
+    TEST_ASSERT_TRUE(plan.blinkEnded);
+    TEST_ASSERT_TRUE(replays(plan, 0));
+    TEST_ASSERT_TRUE(replays(plan, 3));
+}
+
+void test_running_blink_is_replayed(void) {
+    load(__blinkScript, 6);
+    uint32_t remaining;
+    int step = stepForTime(2000, &remaining);
+    TEST_ASSERT_EQUAL(2, step);
+    RestorePlan plan;
+    planRestore(__script, 0, step, remaining, &plan);
+    TEST_ASSERT_TRUE(replays(plan, 1));
+    TEST_ASSERT_FALSE(plan.blinkEnded);
+}
+
+void test_infinite_blink_is_replayed(void) {
+    const char* const lines[] = { "led_blink:0,255,500,500,0", "hold:10000", "led_background:20,10" };
+    load(lines, 3);
+    RestorePlan plan;
+    planRestore(__script, 0, 3, 0, &plan);
+    TEST_ASSERT_TRUE(replays(plan, 0));
+    TEST_ASSERT_FALSE(plan.blinkEnded);
+}
+
+void test_backward_seek_resets_unwritten_slots(void) {
+    const char* const lines[] = {
+        "motor_ramp:1000",       // 0
+        "led_tails:0,10,3",      // 1
+        "hold:1000",             // 2
+        "led_background:20,10",  // 3
+        "led_sine_pulse:20,80",  // 4
+        "motor_speed:300",       // 5
+        "motor_ramp:2500",       // 6
+        "led_reverse",           // 7
+        "hold:1000",             // 8
+    };
+    load(lines, 9);
+    RestorePlan plan;
+    planRestore(__script, 9, 2, 0, &plan);
+    TEST_ASSERT_TRUE(resets(plan, "led_background:160,30"));
+    TEST_ASSERT_TRUE(resets(plan, "led_reset"));
+    TEST_ASSERT_TRUE(resets(plan, "motor_stop"));
+    TEST_ASSERT_FALSE(resets(plan, "led_display_brightness:100"));
+    // The ramp was written before the target, so it is replayed rather than reset.
+    TEST_ASSERT_FALSE(resets(plan, "motor_ramp:4000"));
+    TEST_ASSERT_TRUE(replays(plan, 0));
+    TEST_ASSERT_TRUE(replays(plan, 1));
+    TEST_ASSERT_EQUAL(2, plan.count);
+    // led_reset already sets the LED direction forward; no toggle on top of it.
+    TEST_ASSERT_FALSE(plan.toggleLedReverse);
+
+    planRestore(__script, 9, 0, 0, &plan);
+    TEST_ASSERT_TRUE(resets(plan, "motor_ramp:4000"));
+    TEST_ASSERT_EQUAL(0, plan.count);
+}
+
+void test_forward_seek_resets_nothing(void) {
+    load(__blinkScript, 6);
+    RestorePlan plan;
+    planRestore(__script, 0, 6, 0, &plan);
+    TEST_ASSERT_EQUAL(0, plan.defaultCount);
+    planRestore(__script, 3, 4, 0, &plan);
+    TEST_ASSERT_EQUAL(0, plan.defaultCount);
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_finished_blink_is_not_replayed);
+    RUN_TEST(test_running_blink_is_replayed);
+    RUN_TEST(test_infinite_blink_is_replayed);
+    RUN_TEST(test_backward_seek_resets_unwritten_slots);
+    RUN_TEST(test_forward_seek_resets_nothing);
+    return UNITY_END();
+}
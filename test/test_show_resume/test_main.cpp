@@ -0,0 +1,108 @@
+// Host tests for resuming a checkpointed show: the parameters saved in the record win
+// over the script steps that the seek to its position replays.
+//   Run with: pio test -e native_test -f test_show_resume
+#include <stdlib.h>
+#include <string.h>
+#include <unity.h>
+#include "command_parser.h"
+#include "sculpture_config.h"
+#include "script_timeline.h"
+#include "show_checkpoint.h"
+#include "steady_rotate.h"
+
+static const uint32_t __RAMP_MS = 4000;
+static ScriptBuffer __script;
+
+// The parameters resumeFromCheckpoint() in main.cpp restores, as processCommand() sets them.
+static int __brightness;
+static long __rampMs;
+
+static void run(const char* line) {
+    char name[CommandParser::MAX_NAME_LEN + 1];
+    const char* params;
+    if (!CommandParser::split(line, name, &params) || params == nullptr) return;
+    if (strcmp(name, "led_global_brightness") == 0) __brightness = atoi(params);
+    if (strcmp(name, "motor_ramp") == 0) __rampMs = atol(params);
+}
+
+// Returns whether the seek replayed `cmd`.
+static bool replays(const ScriptTimeline::RestorePlan& plan, const char* cmd) {
+    for (int i = 0; i < plan.count; i++) {
+        if (strcmp(__script[plan.steps[i]], cmd) == 0) return true;
+    }
+    return false;
+}
+
+// resumeFromCheckpoint()'s order: the seek to the recorded position, then the record's
+// parameters over it.
+static void resume(const ShowCheckpoint::Record& r, ScriptTimeline::RestorePlan* plan) {
+    uint32_t holdRemainingMs = 0;
+    int step = ScriptTimeline::stepForTime(r.positionMs, &holdRemainingMs);
+    ScriptTimeline::planRestore(__script, 0, step, holdRemainingMs, plan);
+    for (int i = 0; i < plan->defaultCount; i++) run(plan->defaults[i]);
+    for (int i = 0; i < plan->count; i++) run(__script[plan->steps[i]]);
+    __rampMs = r.rampMs;
+    __brightness = r.brightness;
+}
+
+static long simRandom(long low, long highExclusive) {
+    return (highExclusive <= low) ? low : low + rand() % (highExclusive - low);
+}
+
+static long simRevTimeMs(int speed) {
+    return calculateRevTimeMs<Sculpture>(speed);
+}
+
+void setUp() {
+    __brightness = 255;
+    __rampMs = __RAMP_MS;
+}
+
+void tearDown() {}
+
+void test_steady_rotate_resume_keeps_recorded_brightness() {
+    PhaseTemplates::Context context = { simRandom, simRevTimeMs, __RAMP_MS, nullptr };
+    srand(7);
+    SteadyRotate::compose(30 * 60000L, SCRIPT_MAX_LINES, context, __script);
+    ScriptTimeline::build(__script, __RAMP_MS);
+
+    ShowCheckpoint::Record r = {};
+    r.mode = 2; // AUTO_MODE_STEADY_ROTATE
+    r.seed = 7;
+    r.minutes = 30;
+    r.generatedBrightness = 20;
+    r.brightness = 140; // Raised with the slider after the show began
+    r.rampMs = __RAMP_MS;
+    r.positionMs = ScriptTimeline::totalMs() / 2;
+
+    ScriptTimeline::RestorePlan plan;
+    resume(r, &plan);
+    // The seek does replay the script's brightness; the record must still win.
+    TEST_ASSERT_TRUE(replays(plan, "led_global_brightness:20"));
+    TEST_ASSERT_EQUAL(140, __brightness);
+}
+
+void test_resume_keeps_recorded_ramp() {
+    const char* const lines[] = { "motor_ramp:1000", "motor_speed:400", "hold:10000", "led_background:20,10", "hold:10000" };
+    __script.clear();
+    for (int i = 0; i < 5; i++) __script.push(lines[i]);
+    ScriptTimeline::build(__script, __RAMP_MS);
+
+    ShowCheckpoint::Record r = {};
+    r.brightness = 90;
+    r.rampMs = 2500;
+    r.positionMs = 15000;
+
+    ScriptTimeline::RestorePlan plan;
+    resume(r, &plan);
+    TEST_ASSERT_TRUE(replays(plan, "motor_ramp:1000"));
+    TEST_ASSERT_EQUAL(2500, __rampMs);
+    TEST_ASSERT_EQUAL(90, __brightness);
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_steady_rotate_resume_keeps_recorded_brightness);
+    RUN_TEST(test_resume_keeps_recorded_ramp);
+    return UNITY_END();
+}
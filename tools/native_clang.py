@@ -0,0 +1,11 @@
+"""PlatformIO post-script: build a native env with clang instead of gcc.
+
+Used by env:native_libfuzzer, since -fsanitize=fuzzer (libFuzzer) is clang's. The
+native platform names gcc when it sets up the build, so this runs after it. The
+sanitizers also have to reach the link, which build_flags do not.
+"""
+
+Import("env")  # noqa: F821 (provided by PlatformIO)
+
+env.Replace(CC="clang", CXX="clang++")  # noqa: F821
+env.Append(LINKFLAGS=["-fsanitize=fuzzer,address,undefined"])  # noqa: F821
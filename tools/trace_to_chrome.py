@@ -0,0 +1,77 @@
+#!/usr/bin/env python3
+"""Convert an event trace dump from the sculpture into Chrome trace JSON.
+
+Capture the output of the "trace:dump" command from the serial monitor (or the
+Status characteristic notifications after "trace:dump_ble") into a text file, then:
+
+    python3 tools/trace_to_chrome.py capture.txt > trace.json
+
+Open trace.json in https://ui.perfetto.dev or chrome://tracing.
+Lines that are not part of the dump (ordinary log output) are ignored.
+"""
+
+import json
+import re
+import struct
+import sys
+
+LINE_RE = re.compile(r"\b(TH|TN|TE)\s+(.*)$")
+
+
+def parse_dump(lines):
+    names = {}
+    events = []
+    for line in lines:
+        m = LINE_RE.search(line.strip())
+        if not m:
+            continue
+        kind, rest = m.group(1), m.group(2).strip()
+        if kind == "TN":
+            ident, _, name = rest.partition(" ")
+            names[int(ident)] = name
+        elif kind == "TE":
+            raw = bytes.fromhex(rest[:16])
+            events.append(struct.unpack("<IBBH", raw))
+    return names, events
+
+
+def to_chrome(names, events):
+    out = []
+    # micros() wraps every ~71 minutes. Events are dumped in recording order, so
+    # unwrap by accumulating signed 32-bit deltas from the previous record.
+    unwrapped = 0
+    prev_raw = None
+    for ts, ev_type, ident, arg in events:
+        if prev_raw is None:
+            unwrapped = ts
+        else:
+            delta = (ts - prev_raw) & 0xFFFFFFFF
+            if delta >= 0x80000000:
+                delta -= 0x100000000
+            unwrapped += delta
+        prev_raw = ts
+        entry = {
+            "name": names.get(ident, "event_%d" % ident),
+            "ph": chr(ev_type),
+            "ts": unwrapped,
+            "pid": 1,
+            "tid": 1,
+            "args": {"arg": arg},
+        }
+        if entry["ph"] == "i":
+            entry["s"] = "t"
+        out.append(entry)
+    # Events stamped on another task (command_received) are recorded late; sort by time.
+    out.sort(key=lambda e: e["ts"])
+    return {"traceEvents": out, "displayTimeUnit": "ms"}
+
+
+def main():
+    src = open(sys.argv[1]) if len(sys.argv) > 1 else sys.stdin
+    names, events = parse_dump(src)
+    json.dump(to_chrome(names, events), sys.stdout, indent=1)
+    sys.stdout.write("\n")
+
+
+if __name__ == "__main__":
+    main()